@@ -116,6 +116,35 @@ public:
     void Deallocate(void* ptr) override;
 };
 
+/*
+* @brief AlignedHeapAllocator is a custom allocator that traces the allocations like the HeapAllocator
+* but guarantees every block starts on a given boundary (a cache line by default), so that arrays
+* allocated with it can be streamed with aligned SIMD loads.
+*/
+class AlignedHeapAllocator final : public Allocator
+{
+private:
+    std::size_t _minAlignment = 64;
+
+public:
+    AlignedHeapAllocator() = default;
+    explicit AlignedHeapAllocator(std::size_t minAlignment) noexcept : _minAlignment(minAlignment) {}
+
+    /**
+     * @brief Allocate is a method that allocates a given amount of memory.
+     * @param allocationSize The size of the allocation to do.
+     * @param alignment The alignment in memory of the allocation, raised to the minimum alignment of the allocator.
+     * @return A pointer pointing to the memory (aka a void*).
+     */
+    void* Allocate(std::size_t allocationSize, std::size_t alignment) override;
+
+    /**
+     * @brief Deallocate is a method that deallocates a block of memory given in parameter.
+     * @param ptr The pointer to the memory block to deallocates.
+     */
+    void Deallocate(void* ptr) override;
+};
+
 /**
  * @brief StandardAllocator is an implementation of the allocator of the STL but used as a proxy
  * custom allocator in order to be able to trace allocations.
@@ -0,0 +1,131 @@
+#pragma once
+
+/**
+ * @headerfile JobSystem.h
+ * This file defines a small work stealing job system used to split loops over worker threads.
+ */
+
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <type_traits>
+#include <vector>
+
+/**
+ * @brief Pool of worker threads executing ranges of loops.
+ * @note Every participating thread owns a queue of tasks. A thread pops the most recent task of its own
+ * queue and, when it is empty, steals the oldest task of another queue. The thread calling ParallelFor takes
+ * part in the work as thread 0, so a job system with a single worker runs everything inline.
+ * ParallelFor must be called from one external thread at a time, loop bodies can nest further loops.
+ */
+class JobSystem
+{
+private:
+	/**
+	 * @brief A chunk of a loop, the type erased loop body is called on [Begin, End).
+	 */
+	struct Task
+	{
+		void (*Invoke)(const void* context, std::size_t begin, std::size_t end) = nullptr;
+		const void* Context = nullptr;
+		std::size_t Begin = 0;
+		std::size_t End = 0;
+		std::atomic<std::size_t>* Pending = nullptr;
+	};
+
+	struct WorkQueue
+	{
+		std::mutex Mutex;
+		std::deque<Task> Tasks;
+	};
+
+	std::vector<std::unique_ptr<WorkQueue>> _queues; /**< One queue per participating thread, the caller uses queue 0. */
+	std::vector<std::thread> _workers;
+
+	std::mutex _sleepMutex;
+	std::condition_variable _wakeUp;
+	std::atomic<std::size_t> _queuedTasks{ 0 };
+	bool _running = false;
+
+public:
+	JobSystem() noexcept = default;
+	~JobSystem() noexcept;
+
+	JobSystem(const JobSystem&) = delete;
+	JobSystem& operator=(const JobSystem&) = delete;
+
+	/**
+	 * @brief Start the worker threads, stopping the previous ones if any.
+	 * @param workerCount The number of threads taking part in the loops including the caller, 0 uses every hardware thread.
+	 */
+	void Start(std::size_t workerCount = 0) noexcept;
+
+	/**
+	 * @brief Join the worker threads, loops then run inline on the caller.
+	 */
+	void Stop() noexcept;
+
+	/**
+	 * @brief Number of threads taking part in the loops, including the caller.
+	 */
+	[[nodiscard]] std::size_t WorkerCount() const noexcept { return _queues.empty() ? 1 : _queues.size(); }
+
+	/**
+	 * @brief Index of the calling thread in [0, WorkerCount()), 0 for the thread calling ParallelFor.
+	 * @note Meant to address per-thread buffers from inside a loop body.
+	 */
+	[[nodiscard]] static std::size_t CurrentWorkerIndex() noexcept;
+
+	/**
+	 * @brief Call func(i) for every i in [begin, end), split over the workers in chunks of grainSize.
+	 * @note Returns once every iteration ran. The order of the iterations is not specified.
+	 * @param begin The first index.
+	 * @param end One past the last index.
+	 * @param grainSize The number of consecutive iterations executed by one task.
+	 * @param func The loop body.
+	 */
+	template<typename Func>
+	void ParallelFor(std::size_t begin, std::size_t end, std::size_t grainSize, Func&& func) noexcept
+	{
+		ParallelForChunks(begin, end, grainSize, [&func](std::size_t first, std::size_t last)
+		{
+			for (std::size_t i = first; i < last; i++)
+			{
+				func(i);
+			}
+		});
+	}
+
+	/**
+	 * @brief Call func(first, last) on consecutive chunks of at most grainSize iterations covering [begin, end).
+	 * @param begin The first index.
+	 * @param end One past the last index.
+	 * @param grainSize The maximum number of iterations of a chunk.
+	 * @param func The chunk body.
+	 */
+	template<typename Func>
+	void ParallelForChunks(std::size_t begin, std::size_t end, std::size_t grainSize, Func&& func) noexcept
+	{
+		using FuncType = std::remove_reference_t<Func>;
+		Dispatch([](const void* context, std::size_t first, std::size_t last)
+		{
+			(*static_cast<FuncType*>(const_cast<void*>(context)))(first, last);
+		}, &func, begin, end, grainSize);
+	}
+
+private:
+	void Dispatch(void (*invoke)(const void*, std::size_t, std::size_t), const void* context,
+		std::size_t begin, std::size_t end, std::size_t grainSize) noexcept;
+
+	void WorkerLoop(std::size_t index) noexcept;
+
+	/**
+	 * @brief Run one task of the given queue or, if it is empty, one stolen from another queue.
+	 * @return true if a task was executed.
+	 */
+	bool RunOneTask(std::size_t queueIndex) noexcept;
+};
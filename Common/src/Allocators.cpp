@@ -1,5 +1,10 @@
 #include "Allocators.h"
 
+#include <cstdlib>
+#ifdef _WIN32
+#include <malloc.h>
+#endif
+
 void* HeapAllocator::Allocate(std::size_t allocationSize, std::size_t alignment)
 {
 #ifdef TRACY_ENABLE
@@ -33,4 +38,48 @@ void HeapAllocator::Deallocate(void* ptr)
 #endif
 
     std::free(ptr);
+}
+
+void* AlignedHeapAllocator::Allocate(std::size_t allocationSize, std::size_t alignment)
+{
+#ifdef TRACY_ENABLE
+    ZoneScoped;
+#endif
+    if (allocationSize == 0)
+    {
+        return nullptr;
+    }
+
+    const std::size_t align = alignment > _minAlignment ? alignment : _minAlignment;
+    // aligned_alloc requires the size to be a multiple of the alignment
+    const std::size_t size = (allocationSize + align - 1) / align * align;
+
+#ifdef _WIN32
+    auto* ptr = _aligned_malloc(size, align);
+#else
+    auto* ptr = std::aligned_alloc(align, size);
+#endif
+
+#ifdef TRACY_ENABLE
+    TracyAlloc(ptr, size);
+#endif
+
+    return ptr;
+}
+
+void AlignedHeapAllocator::Deallocate(void* ptr)
+{
+#ifdef TRACY_ENABLE
+    ZoneScoped;
+#endif
+
+#ifdef TRACY_ENABLE
+    TracyFree(ptr);
+#endif
+
+#ifdef _WIN32
+    _aligned_free(ptr);
+#else
+    std::free(ptr);
+#endif
 }
\ No newline at end of file
@@ -0,0 +1,172 @@
+#include "JobSystem.h"
+
+#ifdef TRACY_ENABLE
+#include <Tracy.hpp>
+#endif // TRACY_ENABLE
+
+namespace
+{
+	thread_local std::size_t workerIndex = 0;
+}
+
+JobSystem::~JobSystem() noexcept
+{
+	Stop();
+}
+
+void JobSystem::Start(std::size_t workerCount) noexcept
+{
+	Stop();
+
+	if (workerCount == 0)
+	{
+		workerCount = std::thread::hardware_concurrency();
+	}
+	if (workerCount <= 1)
+	{
+		return;
+	}
+
+	for (std::size_t i = 0; i < workerCount; i++)
+	{
+		_queues.push_back(std::make_unique<WorkQueue>());
+	}
+
+	_running = true;
+	for (std::size_t i = 1; i < workerCount; i++)
+	{
+		_workers.emplace_back(&JobSystem::WorkerLoop, this, i);
+	}
+}
+
+void JobSystem::Stop() noexcept
+{
+	{
+		std::lock_guard lock(_sleepMutex);
+		_running = false;
+	}
+	_wakeUp.notify_all();
+
+	for (auto& worker : _workers)
+	{
+		worker.join();
+	}
+	_workers.clear();
+	_queues.clear();
+}
+
+std::size_t JobSystem::CurrentWorkerIndex() noexcept
+{
+	return workerIndex;
+}
+
+void JobSystem::Dispatch(void (*invoke)(const void*, std::size_t, std::size_t), const void* context,
+	std::size_t begin, std::size_t end, std::size_t grainSize) noexcept
+{
+#ifdef TRACY_ENABLE
+	ZoneScoped;
+#endif
+	if (begin >= end)
+	{
+		return;
+	}
+	if (grainSize == 0)
+	{
+		grainSize = 1;
+	}
+
+	if (_queues.empty() || end - begin <= grainSize)
+	{
+		invoke(context, begin, end);
+		return;
+	}
+
+	const std::size_t taskCount = (end - begin + grainSize - 1) / grainSize;
+	std::atomic<std::size_t> pending{ taskCount };
+
+	// Deal the chunks round robin so every worker starts with local work and only steals to balance
+	for (std::size_t t = 0; t < taskCount; t++)
+	{
+		const std::size_t first = begin + t * grainSize;
+		const std::size_t last = first + grainSize < end ? first + grainSize : end;
+
+		auto& queue = *_queues[t % _queues.size()];
+		std::lock_guard lock(queue.Mutex);
+		queue.Tasks.push_back({ invoke, context, first, last, &pending });
+	}
+
+	{
+		std::lock_guard lock(_sleepMutex);
+		_queuedTasks.fetch_add(taskCount);
+	}
+	_wakeUp.notify_all();
+
+	// The caller helps, from its own queue when it is a worker running a nested loop, until all the chunks are done
+	const std::size_t callerQueue = workerIndex < _queues.size() ? workerIndex : 0;
+	while (pending.load(std::memory_order_acquire) != 0)
+	{
+		if (!RunOneTask(callerQueue))
+		{
+			std::this_thread::yield();
+		}
+	}
+}
+
+void JobSystem::WorkerLoop(std::size_t index) noexcept
+{
+	workerIndex = index;
+
+	while (true)
+	{
+		if (RunOneTask(index))
+		{
+			continue;
+		}
+
+		std::unique_lock lock(_sleepMutex);
+		_wakeUp.wait(lock, [this] { return !_running || _queuedTasks.load() != 0; });
+		if (!_running)
+		{
+			return;
+		}
+	}
+}
+
+bool JobSystem::RunOneTask(std::size_t queueIndex) noexcept
+{
+	Task task;
+	bool found = false;
+
+	{
+		auto& own = *_queues[queueIndex];
+		std::lock_guard lock(own.Mutex);
+		if (!own.Tasks.empty())
+		{
+			task = own.Tasks.back();
+			own.Tasks.pop_back();
+			found = true;
+		}
+	}
+
+	for (std::size_t offset = 1; !found && offset < _queues.size(); offset++)
+	{
+		auto& victim = *_queues[(queueIndex + offset) % _queues.size()];
+		std::lock_guard lock(victim.Mutex);
+		if (!victim.Tasks.empty())
+		{
+			task = victim.Tasks.front();
+			victim.Tasks.pop_front();
+			found = true;
+		}
+	}
+
+	if (!found)
+	{
+		return false;
+	}
+
+	_queuedTasks.fetch_sub(1);
+	task.Invoke(task.Context, task.Begin, task.End);
+	task.Pending->fetch_sub(1, std::memory_order_release);
+	return true;
+}
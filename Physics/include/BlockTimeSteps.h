@@ -0,0 +1,126 @@
+#pragma once
+
+#include "FluidParticleSystem.h"
+#include "FluidSleep.h"
+#include "NeighborList.h"
+#include "JobSystem.h"
+
+#include <cstdint>
+#include <utility>
+#include <vector>
+
+/**
+ * @brief Hierarchical (block) time steps of the fluid particles: each particle steps by the frame time divided
+ * by a power of two picked from its own CFL conditions instead of the step of the fastest particle.
+ * @note The frame is cut into 2^MaxLevel ticks. A particle of level l is active every 2^(MaxLevel - l) ticks:
+ * its density and forces are evaluated and its velocity is kicked for its whole step. Every particle drifts
+ * with its current velocity between the processed ticks, so the neighbors of an active particle are at their
+ * synchronized positions while their pressure is the one of their last active tick. A particle may refine its
+ * level at any of its ticks and coarsen it once its tick is aligned with the coarser step, and it is never more
+ * than one level coarser than its neighbors so slow particles react to fast ones in time.
+ */
+class BlockTimeStepper
+{
+public:
+	/**
+	 * @brief CFL conditions giving the stable step of each particle, the same as the global adaptive time step.
+	 */
+	struct Limits
+	{
+		float CourantFactor = 0.4f; /**< Fraction of the smoothing radius a particle may travel in one step. */
+		float SmoothingRadius = 1.f;
+		float Gravity = 0.f;
+		float ViscosityStrength = 0.f; /**< Explicit viscosity strength, 0 when it does not limit the step. */
+		float ViscosityStepFactor = 0.5f; /**< Fraction of the viscosity relaxation time a step may last. */
+	};
+
+private:
+	std::vector<std::pair<std::uint32_t, std::uint32_t>> _activeChunks; /**< Ranges of consecutive active particles. */
+	std::vector<std::uint32_t> _inactive; /**< 1 for the particles not evaluated at the current tick, sleeping ones included. */
+	std::vector<std::uint32_t> _levels; /**< Level picked by the kick of each active particle, committed once every particle picked. */
+	std::vector<std::uint32_t> _timeStepLevels; /**< The particle steps by the frame time divided by 2^level, attached to the particles. */
+	float _frameStep = 0.f;
+	std::uint32_t _maxLevel = 0;
+	std::uint32_t _tick = 0;
+	std::uint32_t _finestLevel = 0; /**< Finest level used since Begin. */
+	std::size_t _activeParticles = 0;
+	std::size_t _evaluations = 0; /**< Active particles summed over the ticks since Begin. */
+
+public:
+	/**
+	 * @brief Attach the level column to the particles, must be done before the first frame.
+	 */
+	void Attach(FluidParticleSystem& fluids) noexcept;
+
+	/**
+	 * @brief Start a frame, every particle is active at the first tick.
+	 * @param frameStep The time simulated by the frame.
+	 * @param maxLevel The finest level, the shortest step is frameStep / 2^maxLevel.
+	 */
+	void Begin(float frameStep, std::uint32_t maxLevel) noexcept;
+
+	/**
+	 * @brief Gather the awake particles whose step starts at the current tick, after every reorder of the particles.
+	 * @param sleep The sleep state of the particles.
+	 * @param grainSize The maximum length of an active range.
+	 */
+	void SelectActive(const FluidParticleSystem& fluids, const FluidSleepTracker& sleep, std::size_t grainSize) noexcept;
+
+	/**
+	 * @brief Call func(first, last) in parallel on ranges covering the active particles.
+	 */
+	template<typename Func>
+	void ForEachActiveChunk(JobSystem& jobs, Func&& func) const noexcept
+	{
+		jobs.ParallelFor(0, _activeChunks.size(), 1, [&](const std::size_t chunk)
+		{
+			func(_activeChunks[chunk].first, _activeChunks[chunk].second);
+		});
+	}
+
+	/**
+	 * @brief Pick the level of the active particles from their accumulated forces, then apply the forces and
+	 * gravity to their velocities for their whole step and reset the forces to the external force.
+	 * @param neighbors The neighbor list, it holds every neighbor of the active particles.
+	 */
+	void Kick(FluidParticleSystem& fluids, const NeighborList& neighbors, const FluidSleepTracker& sleep, const Limits& limits,
+		JobSystem& jobs) noexcept;
+
+	/**
+	 * @brief Move every particle with its velocity up to the next tick starting the step of a particle.
+	 * @param integrator The implementation moving the particles, see Integrators::Select.
+	 * @param grainSize The number of particles moved by one job.
+	 * @return The time the particles moved by.
+	 */
+	float Drift(FluidParticleSystem& fluids, const FluidSleepTracker& sleep, const IntegratorTable& integrator, JobSystem& jobs,
+		std::size_t grainSize) noexcept;
+
+	[[nodiscard]] bool Done() const noexcept { return _tick >= TickCount(); }
+
+	[[nodiscard]] std::uint32_t TickCount() const noexcept { return 1u << _maxLevel; }
+
+	/**
+	 * @brief Mask of the particles skipped at the current tick, valid until the next SelectActive.
+	 */
+	[[nodiscard]] const std::uint32_t* InactiveMask() const noexcept { return _inactive.data(); }
+
+	[[nodiscard]] std::size_t ActiveParticles() const noexcept { return _activeParticles; }
+
+	/**
+	 * @brief Particle steps evaluated since Begin, the particles times the substeps of a global time step.
+	 */
+	[[nodiscard]] std::size_t Evaluations() const noexcept { return _evaluations; }
+
+	/**
+	 * @brief Shortest step used since Begin.
+	 */
+	[[nodiscard]] float SmallestStep() const noexcept { return LevelStep(_finestLevel); }
+
+	[[nodiscard]] float LevelStep(std::uint32_t level) const noexcept { return _frameStep / static_cast<float>(1u << level); }
+
+private:
+	/**
+	 * @brief Ticks between two steps of a particle of the given level.
+	 */
+	[[nodiscard]] std::uint32_t period(std::uint32_t level) const noexcept { return 1u << (_maxLevel - level); }
+};
@@ -1,47 +1,83 @@
 #pragma once
 
+#include "FluidParticleSystem.h"
+#include "RigidBodySystem.h"
+
 #include <DirectXMath.h>
-#include <optional>
+#include <cstdint>
 
 using namespace DirectX;
 
 enum class BodyType { DYNAMIC, STATIC, FLUID, NONE };
 
 /**
- * @brief Represents a 2D body with position, velocity, and mass.
- * @note A body is disabled if its mass is negative.
+ * @brief Represents a 3D body with position, velocity, and mass.
+ * @note The body is a view on its row of the RigidBodySystem of the world, which owns the state, or on its
+ * particle in the FluidParticleSystem while it is a FLUID body. Only the bodies of the world (see World::GetBody)
+ * are bound to a row.
+ * A body is disabled if its mass is negative.
  */
-
-
 class Body {
-public:
-	XMVECTOR Position = XMVectorZero();
-	XMVECTOR Velocity = XMVectorZero();
-
-	XMVECTOR PredictedPosition = XMVectorZero();
-
-	float Mass = -1.f;  // Body is disabled if mass is negative
-	BodyType Type = BodyType::DYNAMIC;
-
 private:
-	XMVECTOR _force = XMVectorZero(); // Total force acting on the body
+	RigidBodySystem* _system = nullptr; // Set by the world when the body is created
+	FluidParticleSystem* _fluids = nullptr; // Owns the state instead of _system while the body is a FLUID
+	std::uint32_t _slot = 0; // Row of the body, its slot in the world
+	BodyType _type = BodyType::DYNAMIC; // Set by the world only, which lists the body by type (see World::SetBodyType)
 
+	friend class World;
 
 public:
 	/**
-	 * @brief Default constructor for Body.
+	 * @brief Default constructor for Body, the body is bound by the world.
 	 */
 	constexpr Body() noexcept = default;
 
+	[[nodiscard]] XMVECTOR GetPosition() const noexcept
+	{
+		return _type == BodyType::FLUID ? _fluids->GetPosition(particle()) : _system->GetPosition(_slot);
+	}
+
+	void SetPosition(XMVECTOR position) noexcept
+	{
+		if (_type == BodyType::FLUID)
+		{
+			_fluids->SetPosition(particle(), position);
+			return;
+		}
+		_system->SetPosition(_slot, position);
+	}
+
+	[[nodiscard]] XMVECTOR GetVelocity() const noexcept
+	{
+		return _type == BodyType::FLUID ? _fluids->GetVelocity(particle()) : _system->GetVelocity(_slot);
+	}
+
+	void SetVelocity(XMVECTOR velocity) noexcept
+	{
+		if (_type == BodyType::FLUID)
+		{
+			_fluids->SetVelocity(particle(), velocity);
+			return;
+		}
+		_system->SetVelocity(_slot, velocity);
+	}
+
 	/**
-	 * @brief Constructor for Body with specified position, velocity, and mass.
-	 * @param position The initial position of the body.
-	 * @param velocity The initial velocity of the body.
-	 * @param mass The mass of the body.
+	 * @brief Get the mass of the body, negative if the body is disabled.
 	 */
-	explicit Body(XMVECTOR position, XMVECTOR velocity,
-		float mass) noexcept
-		: Position(position), Velocity(velocity), Mass(mass) {
+	[[nodiscard]] float GetMass() const noexcept
+	{
+		return _type == BodyType::FLUID ? _fluids->Mass[particle()] : _system->Mass[_slot];
+	}
+
+	void SetMass(float mass) noexcept
+	{
+		if (_type == BodyType::FLUID)
+		{
+			_fluids->SetMass(particle(), mass);
+			return;
+		}
+		_system->SetMass(_slot, mass);
 	}
 
 	/**
@@ -54,26 +90,45 @@ public:
 	 * @brief Check if the body is enabled (mass is non-negative).
 	 * @return true if the body is enabled, false otherwise.
 	 */
-	[[nodiscard]] constexpr bool IsEnabled() const noexcept { return Mass >= 0; }
+	[[nodiscard]] bool IsEnabled() const noexcept { return GetMass() >= 0; }
 
 	/**
 	 * @brief Enable the body by setting its mass to a positive value.
 	 */
-	constexpr void Enable() noexcept { Mass = 1.f; }
+	void Enable() noexcept { SetMass(1.f); }
 
 	/**
 	 * @brief Disable the body by setting its mass to a negative value.
 	 */
-	constexpr void Disable() noexcept { Mass = -1.f; }
+	void Disable() noexcept { SetMass(-1.f); }
+
+	/**
+	 * @brief Get the type of the body, changed with World::SetBodyType.
+	 */
+	[[nodiscard]] constexpr BodyType GetType() const noexcept { return _type; }
 
 	/**
-	 * @brief Get the total force acting on the body.
+	 * @brief Get the total force acting on the body, the external force of its particle for a FLUID body.
 	 * @return The total force acting on the body.
 	 */
-	[[nodiscard]] constexpr XMVECTOR GetForce() const { return _force; }
+	[[nodiscard]] XMVECTOR GetForce() const noexcept
+	{
+		return _type == BodyType::FLUID ? _fluids->GetExternalForce(particle()) : _system->GetForce(_slot);
+	}
 
 	/**
 	 * @brief Reset the total force acting on the body to zero.
 	 */
-	void ResetForce() { _force = XMVectorZero(); }
-};
\ No newline at end of file
+	void ResetForce() noexcept
+	{
+		if (_type == BodyType::FLUID)
+		{
+			_fluids->ResetExternalForce(particle());
+			return;
+		}
+		_system->ResetForce(_slot);
+	}
+
+private:
+	[[nodiscard]] std::uint32_t particle() const noexcept { return _fluids->ParticleOf(_slot); }
+};
@@ -0,0 +1,123 @@
+#pragma once
+
+#include "FluidParticleSystem.h"
+#include "UniformGrid.h"
+#include "NeighborList.h"
+#include "SPHKernels.h"
+#include "Shape.h"
+#include "Allocators.h"
+
+#include <cstdint>
+#include <vector>
+
+/**
+ * @brief Static boundary sampled with particles (Akinci et al. 2012), the fluid feels the walls through the SPH sweeps.
+ * @note The geometry is sampled once. Each boundary particle b gets the volume V_b = 1 / sum_k W_bk over the
+ * boundary particles around it, so densely sampled areas do not push harder. A boundary particle adds
+ * rho_i * V_b * W_ib to the density of a fluid particle i, the fluid missing behind the wall mirrored from i
+ * (rho_0 * V_b * W_ib in the paper, the same once the fluid is at rest), and pushes it back with the mirrored
+ * pressure of i. Nothing moves, so the grid and the volumes are only rebuilt when the boundary or the smoothing
+ * radius changes and the cost is the within-radius neighbor work.
+ * The DFSPH and PBF solvers use the boundary as in the paper, with the rest density: psi_b = rho_0 * V_b is the
+ * mass a boundary particle adds to the density and constraint gradient sums of its fluid neighbors.
+ */
+class BoundaryParticleSystem
+{
+private:
+	AlignedHeapAllocator _alloc; /**< Allocator of the columns, must be declared before them. */
+
+	UniformGrid _grid; /**< Grid of the boundary particles, built for the interaction radius of the fluid. */
+	float _gridCellSize = 0.f; /**< Cell size of the last grid build, 0 when it has to be rebuilt. */
+	ChunkedListBuilder _builder; /**< Gathers the neighbor lists of the fluid particles in parallel. */
+	float _volumeRadius = 0.f; /**< Smoothing radius of the last volume computation, 0 when they have to be recomputed. */
+	SPHSmoothingKernel _volumeKernel = SPHSmoothingKernel::Spiky;
+	bool _changed = true; /**< Set when particles are added or removed, the fluid neighbors have to be searched again. */
+
+public:
+	CustomlyAllocatedVector<float> PositionX{ _alloc }; /**< X position of each boundary particle. */
+	CustomlyAllocatedVector<float> PositionY{ _alloc }; /**< Y position of each boundary particle. */
+	CustomlyAllocatedVector<float> PositionZ{ _alloc }; /**< Z position of each boundary particle. */
+	CustomlyAllocatedVector<float> Volume{ _alloc }; /**< Volume of each boundary particle, see the class note. */
+
+	std::vector<std::uint32_t> Offsets; /**< Start of the boundary neighbors of each fluid particle, fluid count + 1 entries. */
+	std::vector<std::uint32_t> Indices; /**< Boundary neighbor indices of all the fluid particles, back to back. */
+
+	BoundaryParticleSystem() noexcept = default;
+
+	BoundaryParticleSystem(const BoundaryParticleSystem&) = delete;
+	BoundaryParticleSystem& operator=(const BoundaryParticleSystem&) = delete;
+
+	/**
+	 * @brief Add a single boundary particle.
+	 */
+	void Add(float x, float y, float z) noexcept;
+
+	/**
+	 * @brief Sample the six faces of a box, the walls of a container.
+	 * @param box The box, in world space.
+	 * @param spacing The distance between two particles, half the smoothing radius or less keeps the walls tight.
+	 */
+	void SampleCuboid(const CuboidF& box, float spacing) noexcept;
+
+	/**
+	 * @brief Remove every boundary particle.
+	 */
+	void Clear() noexcept;
+
+	[[nodiscard]] std::size_t Size() const noexcept { return PositionX.size(); }
+
+	/**
+	 * @brief Whether particles were added or removed since the last neighbor search.
+	 */
+	[[nodiscard]] bool Changed() const noexcept { return _changed; }
+
+	/**
+	 * @brief Recompute the volumes if the boundary, the smoothing radius or the kernel changed.
+	 */
+	void UpdateVolumes(const SPHParams& params, JobSystem& jobs) noexcept;
+
+	/**
+	 * @brief Find the boundary particles around each fluid particle, along with the fluid neighbor list.
+	 * @param radius The search radius, the one of the fluid neighbor list.
+	 * @param jobs The job system running the search.
+	 * @param skip Optional mask, the fluid particles with a non-zero entry get an empty list.
+	 */
+	void FindNeighbors(const float* x, const float* y, const float* z, std::size_t count, float radius, JobSystem& jobs,
+		const std::uint32_t* skip = nullptr) noexcept;
+
+	/**
+	 * @brief Call func(b, dx, dy, dz, sqrDistance) for each boundary particle b closer than the smoothing radius to
+	 * the fluid particle i at (x, y, z), (dx, dy, dz) being the offset from b to i.
+	 * @note Reads the lists of the last FindNeighbors, nothing is called when there was no boundary to search.
+	 */
+	template<typename Func>
+	void ForEachInRadius(std::size_t i, float x, float y, float z, const SPHParams& params, Func&& func) const noexcept
+	{
+		if (Indices.empty())
+		{
+			return;
+		}
+
+		for (std::uint32_t n = Offsets[i]; n < Offsets[i + 1]; n++)
+		{
+			const std::uint32_t b = Indices[n];
+			const float dx = x - PositionX[b];
+			const float dy = y - PositionY[b];
+			const float dz = z - PositionZ[b];
+			const float sqrDistance = dx * dx + dy * dy + dz * dz;
+			if (sqrDistance >= params.SqrRadius || sqrDistance == 0.f) continue;
+
+			func(b, dx, dy, dz, sqrDistance);
+		}
+	}
+
+	/**
+	 * @brief Add the boundary contribution to the density of the fluid particles of [first, last) and update their pressure.
+	 */
+	void AddDensity(FluidParticleSystem& fluids, const SPHParams& params, std::size_t first, std::size_t last) const noexcept;
+
+	/**
+	 * @brief Add the pressure force of the boundary to the fluid particles of [first, last).
+	 */
+	void AddForces(FluidParticleSystem& fluids, const SPHParams& params, std::size_t first, std::size_t last) const noexcept;
+};
@@ -24,14 +24,16 @@ public:
 
 	BodyRef BodyRef; /**< Reference to the body associated with the collider. */
 
-	XMVECTOR BodyPosition = XMVectorZero();/**< Position of the body associated to the collider. */
-
 	float Restitution = 1.f; /**< Bounciness/Restition of the collider. */
 
 	bool IsTrigger = false; /**< Flag indicating if the collider is a trigger (non-physical). */
 	bool IsAttached = false; /**< Flag indicating if the collider is attached to a body. */
 
-	[[nodiscard]] CuboidF GetBounds() const noexcept;
+	/**
+	 * @brief Get the bounds of the collider placed on its body.
+	 * @param bodyPosition The position of the body, read from its row when it is needed.
+	 */
+	[[nodiscard]] CuboidF GetBounds(XMVECTOR bodyPosition) const noexcept;
 };
 
 /**
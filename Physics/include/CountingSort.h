@@ -0,0 +1,39 @@
+#pragma once
+
+#include "JobSystem.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+/**
+ * @brief Stable parallel sort of small integer keys, used to bucket particles by grid slot or by neighbor.
+ * @note LSD radix sort with RADIX_BITS digits: each chunk of keys counts its digits, a scan over the digits
+ * then the chunks gives every chunk its write offsets, and each chunk scatters its keys in order. Every pass
+ * is stable, so equal keys keep increasing indices and the result does not depend on the worker count.
+ * Nothing is allocated once the scratch arrays reached their size.
+ */
+class CountingSort
+{
+public:
+	static constexpr std::uint32_t RADIX_BITS = 11; /**< Bits of a digit, 2048 counters per chunk. */
+	static constexpr std::size_t GRAIN_SIZE = 4096; /**< Keys counted and scattered by one job. */
+
+	std::vector<std::uint32_t> SortedKeys; /**< The keys in increasing order. */
+	std::vector<std::uint32_t> Order; /**< Index of each sorted key in the input. */
+
+private:
+	std::vector<std::uint32_t> _scratchKeys;
+	std::vector<std::uint32_t> _scratchOrder;
+	std::vector<std::uint32_t> _counts; /**< Digit counts then write offsets of each chunk, chunk major. */
+
+public:
+	/**
+	 * @brief Sort the keys, the result is in SortedKeys and Order.
+	 * @param keys The key of each element.
+	 * @param count The number of keys.
+	 * @param maxKey An upper bound of the keys, the number of passes depends on its bit count.
+	 * @param jobs The job system running the passes.
+	 */
+	void Sort(const std::uint32_t* keys, std::size_t count, std::uint32_t maxKey, JobSystem& jobs) noexcept;
+};
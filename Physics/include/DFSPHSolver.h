@@ -0,0 +1,106 @@
+#pragma once
+
+#include "FluidParticleSystem.h"
+#include "NeighborList.h"
+#include "BoundaryParticles.h"
+#include "SPHKernels.h"
+#include "JobSystem.h"
+
+#include <cstddef>
+#include <vector>
+
+/**
+ * @brief Divergence-free SPH pressure solver (Bender and Koschier).
+ * @note Instead of an equation of state, pressure is solved for each step: a divergence-free solver removes
+ * the compression rate of the velocity field and a constant density solver corrects the density predicted
+ * at the end of the step. Both iterate until the average error is below a budget and are warm started with
+ * the stiffness of the previous step, kept in columns attached to the particles so it follows them. A particle far
+ * above the rest density, overlapping at the start or after a violent contact, is only brought down by
+ * MaxDensityCorrection per step.
+ * Densities are mass weighted, SPHParams::RestDensity is the rest density. The boundary particles add to the densities
+ * and gradients of their fluid neighbors and push back with the stiffness of the particle (Akinci et al. 2012).
+ */
+class DFSPHSolver
+{
+public:
+	/**
+	 * @brief Iterations and errors of the last solve.
+	 */
+	struct Stats
+	{
+		std::size_t DensityIterations = 0;
+		std::size_t DivergenceIterations = 0;
+		float DensityError = 0.f; /**< Average compression above the target density of the step relative to the rest density. */
+		float DivergenceError = 0.f; /**< Average compression rate over the step relative to the rest density. */
+	};
+
+	std::size_t MinIterations = 2; /**< Iterations done by each solver before accepting a non-zero error. */
+	std::size_t MaxDensityIterations = 100; /**< Iteration budget of the constant density solver. */
+	std::size_t MaxDivergenceIterations = 100; /**< Iteration budget of the divergence-free solver. */
+	float MaxDensityError = 0.001f; /**< Average compression the constant density solver stops at, 0.1 % by default. */
+	float MaxDivergenceError = 0.01f; /**< Average compression over a step the divergence-free solver stops at, 1 % by default. */
+	bool WarmStart = true; /**< Start each solve from the stiffness of the previous step, for the particles still compressing. */
+	float MaxDensityCorrection = 0.02f; /**< Largest density drop, relative to the rest density, the constant density solver asks of a particle in one step. */
+	/**
+	 * @brief Fraction of the stiffness of an iteration that is applied.
+	 * @note Next to a wall the gradients of the fluid and of the boundary cancel out, the particles pushed together
+	 * overshoot and a full Jacobi step diverges. Half a step keeps it converging everywhere.
+	 */
+	float JacobiWeight = 0.5f;
+
+private:
+	std::vector<float> _factors; /**< Inverse of the stiffness denominator of each particle, 0 for isolated particles. */
+	std::vector<float> _sources; /**< Stiffness of each particle for the current iteration. */
+	std::vector<float> _targets; /**< Density of each particle at the end of the step the constant density solver aims for. */
+	std::vector<float> _densityStiffness; /**< Constant density stiffness of the last step of each particle, warm starts the next one. */
+	std::vector<float> _divergenceStiffness; /**< Divergence-free stiffness of the last step of each particle, warm starts the next one. */
+
+	struct alignas(64) ChunkError
+	{
+		double Sum = 0.0;
+	};
+	std::vector<ChunkError> _chunkErrors; /**< Error sum of each chunk of particles, added up in chunk order so it does not depend on the scheduling. */
+
+	Stats _stats;
+
+public:
+	/**
+	 * @brief Attach the warm start columns to the particles, must be done before the first solve.
+	 */
+	void Attach(FluidParticleSystem& fluids) noexcept;
+
+	/**
+	 * @brief Compute the mass weighted density and the stiffness factor of every particle.
+	 * @note Pressure is set to 0 so the force pass of the SPH kernels only adds viscosity.
+	 * @param fluids The fluid particles.
+	 * @param neighbors The full neighbor list of the particles.
+	 * @param boundary The boundary particles, their neighbor lists searched along with the fluid one.
+	 * @param params The SPH parameters.
+	 * @param jobs The job system running the passes.
+	 */
+	void ComputeDensities(FluidParticleSystem& fluids, const NeighborList& neighbors, const BoundaryParticleSystem& boundary,
+		const SPHParams& params, JobSystem& jobs) noexcept;
+
+	/**
+	 * @brief Correct the velocities so the density stops changing, called at the start of the step.
+	 * @param deltaTime The time step.
+	 */
+	void SolveDivergence(FluidParticleSystem& fluids, const NeighborList& neighbors, const BoundaryParticleSystem& boundary,
+		const SPHParams& params, JobSystem& jobs, float deltaTime) noexcept;
+
+	/**
+	 * @brief Correct the velocities so the density predicted at the end of the step is the rest density,
+	 * called once the non-pressure forces were applied to the velocities.
+	 * @param deltaTime The time step.
+	 */
+	void SolveDensity(FluidParticleSystem& fluids, const NeighborList& neighbors, const BoundaryParticleSystem& boundary,
+		const SPHParams& params, JobSystem& jobs, float deltaTime) noexcept;
+
+	[[nodiscard]] const Stats& GetStats() const noexcept { return _stats; }
+
+private:
+	/**
+	 * @brief Sum the chunk errors in chunk order and reset them.
+	 */
+	[[nodiscard]] double collectError() noexcept;
+};
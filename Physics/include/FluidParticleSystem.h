@@ -0,0 +1,249 @@
+#pragma once
+
+#include "Allocators.h"
+#include "RigidBodySystem.h"
+#include "Integrator.h"
+
+#include <cstdint>
+#include <utility>
+#include <vector>
+
+/**
+ * @brief Structure of arrays holding the SPH state of every FLUID body of the world.
+ * @note Particles are addressed by a dense particle index in [0, Size()). Every column is a contiguous,
+ * cache line aligned array so the SPH passes stream through memory instead of chasing bodies and hash maps.
+ * The columns own the state of the particles: the position, velocity and mass of a body are loaded from its
+ * RigidBodySystem row when it becomes a fluid and stored back when it stops being one, the Body reads and
+ * writes the columns in between.
+ * The solvers keep their per-particle state in columns attached to the system, which resizes, swaps and
+ * permutes them along with its own so the state follows the particles.
+ */
+class FluidParticleSystem
+{
+public:
+	static constexpr std::uint32_t INVALID_INDEX = 0xFFFFFFFF; /**< Particle index of a body that is not a fluid. */
+
+private:
+	AlignedHeapAllocator _alloc; /**< Allocator of the columns, must be declared before them. */
+
+	std::vector<std::uint32_t> _particleOfBody; /**< Particle index of each body index, INVALID_INDEX if the body is not a fluid. */
+
+	std::vector<std::pair<std::uint64_t, std::uint32_t>> _sortKeys; /**< Morton code and particle index, scratch of SortByMortonOrder. */
+	CustomlyAllocatedVector<float> _floatScratch{ _alloc }; /**< Scratch column used to permute the float columns. */
+	CustomlyAllocatedVector<std::uint32_t> _indexScratch{ _alloc }; /**< Scratch column used to permute BodyIndices. */
+
+	std::vector<std::vector<float>*> _attachedFloats; /**< Float columns of the solvers, see Attach. */
+	std::vector<std::vector<std::uint32_t>*> _attachedIndices; /**< Integer columns of the solvers, see Attach. */
+	std::vector<float> _attachedFloatScratch; /**< Scratch column used to permute the attached float columns. */
+	std::vector<std::uint32_t> _attachedIndexScratch; /**< Scratch column used to permute the attached integer columns. */
+
+public:
+	CustomlyAllocatedVector<float> PositionX{ _alloc }; /**< X position of each particle. */
+	CustomlyAllocatedVector<float> PositionY{ _alloc }; /**< Y position of each particle. */
+	CustomlyAllocatedVector<float> PositionZ{ _alloc }; /**< Z position of each particle. */
+
+	CustomlyAllocatedVector<float> VelocityX{ _alloc }; /**< X velocity of each particle. */
+	CustomlyAllocatedVector<float> VelocityY{ _alloc }; /**< Y velocity of each particle. */
+	CustomlyAllocatedVector<float> VelocityZ{ _alloc }; /**< Z velocity of each particle. */
+
+	CustomlyAllocatedVector<float> ForceX{ _alloc }; /**< X component of the force accumulated during the step. */
+	CustomlyAllocatedVector<float> ForceY{ _alloc }; /**< Y component of the force accumulated during the step. */
+	CustomlyAllocatedVector<float> ForceZ{ _alloc }; /**< Z component of the force accumulated during the step. */
+
+	CustomlyAllocatedVector<float> ExternalForceX{ _alloc }; /**< X component of the force applied to the particle, held over the substeps of the next update and cleared after it. */
+	CustomlyAllocatedVector<float> ExternalForceY{ _alloc }; /**< Y component of the force applied to the particle. */
+	CustomlyAllocatedVector<float> ExternalForceZ{ _alloc }; /**< Z component of the force applied to the particle. */
+
+	CustomlyAllocatedVector<float> Mass{ _alloc }; /**< Mass of each particle. */
+	CustomlyAllocatedVector<float> InvMass{ _alloc }; /**< Inverse mass of each particle. */
+	CustomlyAllocatedVector<float> Density{ _alloc }; /**< SPH density of each particle. */
+	CustomlyAllocatedVector<float> NearDensity{ _alloc }; /**< SPH near density of each particle. */
+	CustomlyAllocatedVector<float> Pressure{ _alloc }; /**< Pressure derived from the density of each particle. */
+
+	CustomlyAllocatedVector<std::uint32_t> BodyIndices{ _alloc }; /**< Index in the world body array of each particle. */
+
+private:
+	/**
+	 * @brief Every float column above, resized, swapped and permuted together.
+	 */
+	CustomlyAllocatedVector<float>* const _columns[17] = {
+		&PositionX, &PositionY, &PositionZ, &VelocityX, &VelocityY, &VelocityZ, &ForceX, &ForceY, &ForceZ,
+		&ExternalForceX, &ExternalForceY, &ExternalForceZ, &Mass, &InvMass, &Density, &NearDensity, &Pressure };
+
+public:
+	FluidParticleSystem() noexcept = default;
+
+	FluidParticleSystem(const FluidParticleSystem&) = delete;
+	FluidParticleSystem& operator=(const FluidParticleSystem&) = delete;
+
+	/**
+	 * @brief Register the body at the given index as a fluid particle, its columns are zero until Load.
+	 * @param bodyIndex The index of the body in the world body array.
+	 * @return The dense index of the new particle.
+	 */
+	std::uint32_t Add(std::size_t bodyIndex) noexcept;
+
+	/**
+	 * @brief Unregister the fluid particle of a body, the last particle is moved into its slot.
+	 * @param bodyIndex The index of the body in the world body array.
+	 */
+	void Remove(std::size_t bodyIndex) noexcept;
+
+	/**
+	 * @brief Remove every particle, the attached columns stay attached.
+	 */
+	void Clear() noexcept;
+
+	/**
+	 * @brief Keep a column of per-particle state of a solver in step with the particles.
+	 * @note The column is resized to Size() and kept at it, new particles get 0, a removed particle takes the value
+	 * of the last one and SortByMortonOrder permutes it. Attaching a column twice does nothing. The column must
+	 * outlive the system or stay attached to it.
+	 */
+	void Attach(std::vector<float>& column) noexcept;
+
+	/**
+	 * @copydoc Attach(std::vector<float>&)
+	 */
+	void Attach(std::vector<std::uint32_t>& column) noexcept;
+
+	[[nodiscard]] std::size_t Size() const noexcept { return BodyIndices.size(); }
+
+	/**
+	 * @brief Get the particle index of a body.
+	 * @param bodyIndex The index of the body in the world body array.
+	 * @return The particle index, INVALID_INDEX if the body is not a fluid.
+	 */
+	[[nodiscard]] std::uint32_t ParticleOf(std::size_t bodyIndex) const noexcept
+	{
+		return bodyIndex < _particleOfBody.size() ? _particleOfBody[bodyIndex] : INVALID_INDEX;
+	}
+
+	/**
+	 * @brief Copy the position, velocity, mass and pending force of the row of a body into the columns of its particle.
+	 * @note The pending force of the row is consumed, it is added to the external force of the particle.
+	 */
+	void Load(std::uint32_t particle, RigidBodySystem& bodies, std::uint32_t slot) noexcept;
+
+	/**
+	 * @brief Write the position and velocity of a particle back to the row of its body.
+	 */
+	void Store(std::uint32_t particle, RigidBodySystem& bodies, std::uint32_t slot) const noexcept;
+
+	[[nodiscard]] XMVECTOR GetPosition(std::uint32_t particle) const noexcept
+	{
+		return XMVectorSet(PositionX[particle], PositionY[particle], PositionZ[particle], 0);
+	}
+
+	void SetPosition(std::uint32_t particle, XMVECTOR position) noexcept
+	{
+		PositionX[particle] = XMVectorGetX(position);
+		PositionY[particle] = XMVectorGetY(position);
+		PositionZ[particle] = XMVectorGetZ(position);
+	}
+
+	[[nodiscard]] XMVECTOR GetVelocity(std::uint32_t particle) const noexcept
+	{
+		return XMVectorSet(VelocityX[particle], VelocityY[particle], VelocityZ[particle], 0);
+	}
+
+	void SetVelocity(std::uint32_t particle, XMVECTOR velocity) noexcept
+	{
+		VelocityX[particle] = XMVectorGetX(velocity);
+		VelocityY[particle] = XMVectorGetY(velocity);
+		VelocityZ[particle] = XMVectorGetZ(velocity);
+	}
+
+	[[nodiscard]] XMVECTOR GetExternalForce(std::uint32_t particle) const noexcept
+	{
+		return XMVectorSet(ExternalForceX[particle], ExternalForceY[particle], ExternalForceZ[particle], 0);
+	}
+
+	void AddExternalForce(std::uint32_t particle, XMVECTOR force) noexcept
+	{
+		ExternalForceX[particle] += XMVectorGetX(force);
+		ExternalForceY[particle] += XMVectorGetY(force);
+		ExternalForceZ[particle] += XMVectorGetZ(force);
+	}
+
+	void ResetExternalForce(std::uint32_t particle) noexcept
+	{
+		ExternalForceX[particle] = 0.f;
+		ExternalForceY[particle] = 0.f;
+		ExternalForceZ[particle] = 0.f;
+	}
+
+	void SetMass(std::uint32_t particle, float mass) noexcept
+	{
+		Mass[particle] = mass;
+		InvMass[particle] = mass > 0.f ? 1.f / mass : 0.f;
+	}
+
+	/**
+	 * @brief Reset the forces of the particles of [first, last) to their external force.
+	 */
+	void ResetForces(std::size_t first, std::size_t last) noexcept;
+
+	/**
+	 * @brief Zero the external force of every particle, done once the update consumed it.
+	 */
+	void ClearExternalForces() noexcept;
+
+	/**
+	 * @brief Kick and drift the particles of [first, last) using the accumulated forces and reset them to the external force.
+	 * @param integrator The implementation to use, see Integrators::Select.
+	 * @param kickTime The time the velocities are kicked over, see Integrators::KickTime.
+	 * @param deltaTime The time step.
+	 * @param gravity The downward gravity force applied to every particle.
+	 */
+	void Integrate(const IntegratorTable& integrator, float kickTime, float deltaTime, float gravity,
+		std::size_t first, std::size_t last) noexcept;
+
+	/**
+	 * @brief Velocity half of a semi-implicit Euler Integrate of the particles of [first, last): apply the accumulated
+	 * forces and gravity, then reset the forces to the external force.
+	 * @param deltaTime The time step.
+	 * @param gravity The downward gravity force applied to every particle.
+	 */
+	void IntegrateVelocities(const IntegratorTable& integrator, float deltaTime, float gravity, std::size_t first, std::size_t last) noexcept;
+
+	/**
+	 * @brief Position half of Integrate: move the particles of [first, last) with their velocity.
+	 * @param deltaTime The time step.
+	 */
+	void IntegratePositions(const IntegratorTable& integrator, float deltaTime, std::size_t first, std::size_t last) noexcept;
+
+	/**
+	 * @brief Largest speed, acceleration and density of the particles, used to pick a stable time step.
+	 */
+	struct MotionBounds
+	{
+		float MaxSpeed = 0.f;
+		float MaxAcceleration = 0.f;
+		float MaxDensity = 0.f;
+	};
+
+	/**
+	 * @brief Compute the motion bounds from the current velocities, accumulated forces and densities.
+	 * @param gravity The downward gravity force applied to every particle.
+	 */
+	[[nodiscard]] MotionBounds ComputeMotionBounds(float gravity) const noexcept;
+
+	/**
+	 * @brief Permute every column so the particles are stored in Morton (Z-order) order of their grid cell.
+	 * @note Particles that are close in space end up close in memory, which turns most neighbor gathers
+	 * into cache hits. Particle indices change, the body to particle mapping is updated so bodies and their
+	 * BodyRef stay valid, but any particle index or neighbor list computed before the call is stale.
+	 * Particles with a NaN or infinite coordinate are moved after all the others.
+	 * @param cellSize The size of the cells the particles are sorted by, usually the interaction radius.
+	 */
+	void SortByMortonOrder(float cellSize) noexcept;
+
+	/**
+	 * @brief Raw pointers to the columns the integrator reads and writes.
+	 */
+	[[nodiscard]] IntegratorColumns Columns() noexcept;
+
+private:
+	void Resize(std::size_t size) noexcept;
+};
@@ -0,0 +1,117 @@
+#pragma once
+
+#include "FluidParticleSystem.h"
+#include "Shape.h"
+#include "JobSystem.h"
+
+#include <cstdint>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+/**
+ * @brief Rest detection of the fluid per grid cell, settled cells are frozen and skipped by the SPH passes.
+ * @note A cell is calm for a frame when its particles are slower than SleepSpeed, its particle count did not
+ * change, its average density changed by less than SleepDensityChange and no external force acts on it.
+ * After SleepFrames calm frames it falls asleep: its particles are stopped, their Asleep entry
+ * is set and the passes only visit the awake chunks. A sleeping cell wakes when it stops being calm,
+ * when one of its 26 neighbors was disturbed during the frame or when a wake box (a rigid body) overlaps it.
+ */
+class FluidSleepTracker
+{
+public:
+	float SleepSpeed = 2.f; /**< Speed under which a particle counts as still. */
+	float SleepDensityChange = 0.01f; /**< Relative change of the average cell density per frame under which a cell counts as still. */
+	std::size_t SleepFrames = 30; /**< Calm frames before a cell falls asleep. */
+
+private:
+	/**
+	 * @brief Sleep state of a grid cell, kept from frame to frame while the cell holds particles.
+	 */
+	struct Cell
+	{
+		int X = 0, Y = 0, Z = 0;
+		std::uint32_t Frame = 0; /**< Last frame a particle was found in the cell. */
+		std::uint32_t Count = 0;
+		std::uint32_t PreviousCount = 0;
+		float MaxSqrSpeed = 0.f;
+		double DensitySum = 0.0;
+		float PreviousDensity = 0.f; /**< Average density of the last frame. */
+		std::size_t CalmFrames = 0;
+		bool Forced = false; /**< An external force acts on one of the particles. */
+		bool Asleep = false;
+	};
+
+	std::unordered_map<std::uint64_t, Cell> _cells;
+	std::vector<Cell*> _particleCells; /**< Cell of each particle for the current frame. */
+	std::vector<Cell*> _woken; /**< Cells woken by a disturbed neighbor or a wake box this frame. */
+	std::vector<std::pair<std::uint32_t, std::uint32_t>> _awakeChunks; /**< Ranges of consecutive awake particles. */
+	std::vector<std::uint32_t> _asleep; /**< 1 while the cell of the particle sleeps, attached to the particles. */
+	std::uint32_t _frame = 0;
+	std::size_t _sleepingParticles = 0;
+	bool _changed = false; /**< Whether a particle fell asleep or woke up during the last update. */
+
+public:
+	/**
+	 * @brief Attach the Asleep column to the particles, must be done before the first update.
+	 */
+	void Attach(FluidParticleSystem& fluids) noexcept;
+
+	/**
+	 * @brief Update the sleep state of the cells from the frame start state of the particles and write the Asleep column.
+	 * @param fluids The fluid particles.
+	 * @param cellSize The size of the cells, usually the smoothing radius.
+	 * @param wakeBounds Boxes waking every cell they overlap, usually the bounds of the moving rigid bodies.
+	 */
+	void Update(FluidParticleSystem& fluids, float cellSize, const std::vector<CuboidF>& wakeBounds) noexcept;
+
+	/**
+	 * @brief Wake every particle and forget the cell states, used when sleeping is disabled.
+	 */
+	void WakeAll() noexcept;
+
+	/**
+	 * @brief Build the ranges of awake particles from the Asleep column, after the particles were reordered.
+	 * @param grainSize The maximum length of a range.
+	 */
+	void BuildAwakeChunks(std::size_t grainSize) noexcept;
+
+	/**
+	 * @brief Call func(first, last) in parallel on ranges covering the awake particles, the whole [0, count)
+	 * in chunks of grainSize when nothing sleeps.
+	 */
+	template<typename Func>
+	void ForEachAwakeChunk(JobSystem& jobs, std::size_t count, std::size_t grainSize, Func&& func) const noexcept
+	{
+		if (_sleepingParticles == 0)
+		{
+			jobs.ParallelForChunks(0, count, grainSize, func);
+			return;
+		}
+
+		jobs.ParallelFor(0, _awakeChunks.size(), 1, [&](const std::size_t chunk)
+		{
+			func(_awakeChunks[chunk].first, _awakeChunks[chunk].second);
+		});
+	}
+
+	[[nodiscard]] std::size_t SleepingParticles() const noexcept { return _sleepingParticles; }
+
+	/**
+	 * @brief 1 for each sleeping particle, 0 for the others.
+	 */
+	[[nodiscard]] const std::vector<std::uint32_t>& Asleep() const noexcept { return _asleep; }
+
+	/**
+	 * @brief Whether a particle fell asleep or woke up during the last update, the neighbor lists of those are stale.
+	 */
+	[[nodiscard]] bool Changed() const noexcept { return _changed; }
+
+private:
+	[[nodiscard]] static std::uint64_t CellKey(int x, int y, int z) noexcept;
+
+	/**
+	 * @brief Queue a sleeping cell to be woken at the end of the frame update.
+	 */
+	void wake(int x, int y, int z) noexcept;
+};
@@ -0,0 +1,91 @@
+#pragma once
+
+/**
+ * @file Integrator.h
+ * @brief Batched time integration of structure of arrays bodies, with scalar and AVX2 implementations.
+ * @note Included by a translation unit compiled with AVX flags, it must only declare plain data and
+ * functions, see SPHKernels.h.
+ */
+
+#include <cstddef>
+
+/**
+ * @brief Time integration scheme of the bodies and of the explicit fluid step.
+ * @note The force of a step is only known at its start, a is the acceleration of the step, gravity included.
+ * Both schemes kick then drift, they only differ by the time the velocity is kicked over.
+ */
+enum class IntegratorScheme
+{
+	SemiImplicitEuler, /**< v += a dt, then x += v dt. First order, the historical scheme. */
+	Leapfrog, /**< Staggered: v lives half a step behind x, v += a (dt' + dt) / 2 then x += v dt, dt' the previous step. Second order and time reversible. */
+};
+
+/**
+ * @brief Raw pointers to the columns read and written by the integrator.
+ */
+struct IntegratorColumns
+{
+	float* PositionX = nullptr;
+	float* PositionY = nullptr;
+	float* PositionZ = nullptr;
+	float* VelocityX = nullptr;
+	float* VelocityY = nullptr;
+	float* VelocityZ = nullptr;
+
+	const float* ForceX = nullptr;
+	const float* ForceY = nullptr;
+	const float* ForceZ = nullptr;
+	const float* InvMass = nullptr;
+};
+
+/**
+ * @brief v += a kickTime, then x += v deltaTime for the bodies in [begin, end), gravity is a downward force.
+ */
+using KickDriftFunction = void (*)(const IntegratorColumns& columns, float kickTime, float deltaTime, float gravity,
+	std::size_t begin, std::size_t end);
+
+/**
+ * @brief v += a kickTime for the bodies in [begin, end), the positions are left as they are.
+ */
+using KickFunction = void (*)(const IntegratorColumns& columns, float kickTime, float gravity, std::size_t begin, std::size_t end);
+
+/**
+ * @brief x += v deltaTime for the bodies in [begin, end), the forces are not read.
+ */
+using DriftFunction = void (*)(const IntegratorColumns& columns, float deltaTime, std::size_t begin, std::size_t end);
+
+/**
+ * @brief One implementation of the integration passes.
+ */
+struct IntegratorTable
+{
+	const char* Name = ""; /**< Instruction set of the implementation. */
+	KickDriftFunction KickDrift = nullptr;
+	KickFunction Kick = nullptr;
+	DriftFunction Drift = nullptr;
+};
+
+namespace Integrators
+{
+	/**
+	 * @return The scalar implementation.
+	 */
+	[[nodiscard]] const IntegratorTable& Scalar() noexcept;
+
+	/**
+	 * @return The AVX2 implementation, nullptr if the binary was built without it.
+	 */
+	[[nodiscard]] const IntegratorTable* AVX2() noexcept;
+
+	/**
+	 * @brief Pick the widest implementation supported by the running CPU and operating system.
+	 */
+	[[nodiscard]] const IntegratorTable& Select() noexcept;
+
+	/**
+	 * @brief Time the velocities are kicked over by a step of the scheme.
+	 * @param previousDeltaTime The previous step of the same bodies, 0 if they were not stepped with the scheme,
+	 * the first leapfrog step then kicks over half a step to stagger the velocities.
+	 */
+	[[nodiscard]] float KickTime(IntegratorScheme scheme, float deltaTime, float previousDeltaTime) noexcept;
+}
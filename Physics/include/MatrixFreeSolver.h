@@ -0,0 +1,619 @@
+#pragma once
+
+#include "JobSystem.h"
+
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <cstddef>
+#include <vector>
+
+/**
+ * @file MatrixFreeSolver.h
+ * @brief Matrix-free iterative solvers for systems over particle columns, shared by the implicit features.
+ * @note A system has N right hand side columns sharing one matrix (the three velocity components of a
+ * viscosity solve for example), each column is solved independently with its own scalars. The matrix is
+ * never stored, it is an operator evaluated from the particle state, typically by walking a neighbor list:
+ *
+ *     struct Operator
+ *     {
+ *         // result[d][i] = (A x)[d][i] for every column d and every i in [first, last)
+ *         void Multiply(SolverColumns<N> x, SolverColumns<N> result, std::size_t first, std::size_t last) const noexcept;
+ *         // A_ii, used by the Jacobi preconditioner and relaxation, must be non-zero
+ *         float Diagonal(std::size_t i) const noexcept;
+ *     };
+ *
+ * Reductions are computed per fixed block of particles and summed in block order, so the results do not
+ * depend on the worker count or on which worker ran which block.
+ */
+
+/**
+ * @brief N columns of one float per particle, not owning.
+ */
+template<std::size_t N>
+struct SolverColumns
+{
+	std::array<float*, N> Columns{};
+
+	float* operator[](std::size_t column) const noexcept { return Columns[column]; }
+};
+
+/**
+ * @brief N owned columns of one float per particle, the work vectors of the solvers.
+ */
+template<std::size_t N>
+class SolverStorage
+{
+	std::array<std::vector<float>, N> _columns;
+
+public:
+	void Resize(std::size_t count) noexcept
+	{
+		for (auto& column : _columns)
+		{
+			column.resize(count);
+		}
+	}
+
+	[[nodiscard]] SolverColumns<N> Columns() noexcept
+	{
+		SolverColumns<N> columns;
+		for (std::size_t d = 0; d < N; d++)
+		{
+			columns.Columns[d] = _columns[d].data();
+		}
+		return columns;
+	}
+};
+
+/**
+ * @brief Iteration budget and convergence criterion of a solve.
+ */
+struct SolverSettings
+{
+	std::size_t MaxIterations = 50; /**< Iteration budget. */
+	float Tolerance = 1e-3f; /**< Residual norm, relative to the right hand side norm, the solve stops at. */
+	float JacobiWeight = 2.f / 3.f; /**< Relaxation weight of the Jacobi solver. */
+	bool RecordHistory = false; /**< Record the relative residual of every iteration in the telemetry. */
+};
+
+/**
+ * @brief Convergence telemetry of the last solve.
+ */
+struct SolverTelemetry
+{
+	std::size_t Iterations = 0;
+	float InitialResidual = 0.f; /**< Relative residual of the initial guess. */
+	float Residual = 0.f; /**< Relative residual of the solution, all columns together. */
+	bool Converged = false; /**< Whether the residual reached the tolerance within the iteration budget. */
+	std::vector<float> ResidualHistory; /**< Relative residual after each iteration, only filled with RecordHistory. */
+};
+
+/**
+ * @brief Parallel matrix-free conjugate gradient, BiCGStab and Jacobi solvers for N columns sharing a matrix.
+ * @note The solvers are Jacobi preconditioned. The work vectors are kept between solves so a solve does not
+ * allocate once they reached the particle count.
+ */
+template<std::size_t N>
+class MatrixFreeSolver
+{
+public:
+	using Scalars = std::array<double, N>;
+
+	static constexpr std::size_t BLOCK_SIZE = 256; /**< Particles of one reduction block, also the parallel grain. */
+
+	SolverSettings Settings;
+
+private:
+	SolverStorage<N> _residual;
+	SolverStorage<N> _shadow; /**< BiCGStab shadow residual. */
+	SolverStorage<N> _direction;
+	SolverStorage<N> _product;
+	SolverStorage<N> _preconditioned;
+	SolverStorage<N> _stabilizer; /**< BiCGStab second product. */
+
+	std::vector<Scalars> _blockFirst; /**< First partial sums of each block. */
+	std::vector<Scalars> _blockSecond; /**< Second partial sums of each block. */
+
+	SolverTelemetry _telemetry;
+
+public:
+	/**
+	 * @brief Call func(first, last, firstSums, secondSums) on fixed blocks covering [0, count) in parallel
+	 * and add up the sums each block accumulated, in block order.
+	 * @return The first sums, the second ones are written to second.
+	 */
+	template<typename Func>
+	Scalars Reduce(JobSystem& jobs, std::size_t count, Scalars& second, Func&& func) noexcept
+	{
+		const std::size_t blocks = (count + BLOCK_SIZE - 1) / BLOCK_SIZE;
+		_blockFirst.assign(blocks, Scalars{});
+		_blockSecond.assign(blocks, Scalars{});
+
+		jobs.ParallelFor(0, blocks, 1, [&](const std::size_t block)
+		{
+			const std::size_t first = block * BLOCK_SIZE;
+			const std::size_t last = first + BLOCK_SIZE < count ? first + BLOCK_SIZE : count;
+			func(first, last, _blockFirst[block], _blockSecond[block]);
+		});
+
+		Scalars sum{};
+		second = Scalars{};
+		for (std::size_t block = 0; block < blocks; block++)
+		{
+			for (std::size_t d = 0; d < N; d++)
+			{
+				sum[d] += _blockFirst[block][d];
+				second[d] += _blockSecond[block][d];
+			}
+		}
+		return sum;
+	}
+
+	/**
+	 * @brief Dot product of each column of a with the same column of b.
+	 */
+	Scalars Dot(JobSystem& jobs, SolverColumns<N> a, SolverColumns<N> b, std::size_t count) noexcept
+	{
+		Scalars unused;
+		return Reduce(jobs, count, unused, [&](std::size_t first, std::size_t last, Scalars& sums, Scalars&)
+		{
+			for (std::size_t d = 0; d < N; d++)
+			{
+				sums[d] = BlockDot(a[d], b[d], first, last);
+			}
+		});
+	}
+
+	/**
+	 * @brief y += alpha * x, with one alpha per column.
+	 */
+	static void Axpy(JobSystem& jobs, const std::array<float, N>& alpha, SolverColumns<N> x, SolverColumns<N> y, std::size_t count) noexcept
+	{
+		jobs.ParallelForChunks(0, count, BLOCK_SIZE, [&](const std::size_t first, const std::size_t last)
+		{
+			for (std::size_t d = 0; d < N; d++)
+			{
+				const float a = alpha[d];
+				const float* __restrict source = x[d];
+				float* __restrict target = y[d];
+				for (std::size_t i = first; i < last; i++)
+				{
+					target[i] += a * source[i];
+				}
+			}
+		});
+	}
+
+	/**
+	 * @brief Solve A x = b with the preconditioned conjugate gradient, A must be symmetric positive definite.
+	 * @param x The initial guess, overwritten with the solution.
+	 * @param b The right hand side.
+	 */
+	template<typename Operator>
+	const SolverTelemetry& ConjugateGradient(JobSystem& jobs, const Operator& op, SolverColumns<N> x, SolverColumns<N> b, std::size_t count) noexcept
+	{
+		double sqrRhsNorm = 0.0;
+		if (!begin(jobs, count, x, b, sqrRhsNorm))
+		{
+			return _telemetry;
+		}
+
+		const SolverColumns<N> r = _residual.Columns();
+		const SolverColumns<N> p = _direction.Columns();
+		const SolverColumns<N> q = _product.Columns();
+
+		// r = b - A x, p = z = r / diagonal
+		Scalars sqrResidual;
+		Scalars residualDotZ = Reduce(jobs, count, sqrResidual, [&](std::size_t first, std::size_t last, Scalars& rz, Scalars& rr)
+		{
+			op.Multiply(x, q, first, last);
+			for (std::size_t i = first; i < last; i++)
+			{
+				const float invDiagonal = 1.f / op.Diagonal(i);
+				for (std::size_t d = 0; d < N; d++)
+				{
+					const float residual = b[d][i] - q[d][i];
+					r[d][i] = residual;
+					p[d][i] = residual * invDiagonal;
+					rz[d] += static_cast<double>(residual) * p[d][i];
+					rr[d] += static_cast<double>(residual) * residual;
+				}
+			}
+		});
+		_telemetry.InitialResidual = relativeResidual(sqrResidual, sqrRhsNorm);
+		_telemetry.Residual = _telemetry.InitialResidual;
+		_telemetry.Converged = _telemetry.Residual <= Settings.Tolerance;
+
+		while (_telemetry.Residual > Settings.Tolerance && _telemetry.Iterations < Settings.MaxIterations)
+		{
+			// q = A p
+			Scalars unused;
+			const Scalars directionDotProduct = Reduce(jobs, count, unused, [&](std::size_t first, std::size_t last, Scalars& pq, Scalars&)
+			{
+				op.Multiply(p, q, first, last);
+				for (std::size_t d = 0; d < N; d++)
+				{
+					pq[d] = BlockDot(p[d], q[d], first, last);
+				}
+			});
+
+			// A converged column has a zero residual, its step stays 0 instead of 0 / 0
+			std::array<float, N> alpha;
+			for (std::size_t d = 0; d < N; d++)
+			{
+				alpha[d] = static_cast<float>(Ratio(residualDotZ[d], directionDotProduct[d]));
+			}
+
+			// x += alpha p, r -= alpha q
+			const Scalars newResidualDotZ = Reduce(jobs, count, sqrResidual, [&](std::size_t first, std::size_t last, Scalars& rz, Scalars& rr)
+			{
+				for (std::size_t i = first; i < last; i++)
+				{
+					const float invDiagonal = 1.f / op.Diagonal(i);
+					for (std::size_t d = 0; d < N; d++)
+					{
+						x[d][i] += alpha[d] * p[d][i];
+						const float residual = r[d][i] - alpha[d] * q[d][i];
+						r[d][i] = residual;
+						rz[d] += static_cast<double>(residual) * residual * invDiagonal;
+						rr[d] += static_cast<double>(residual) * residual;
+					}
+				}
+			});
+			endIteration(sqrResidual, sqrRhsNorm);
+			if (_telemetry.Converged)
+			{
+				break;
+			}
+
+			std::array<float, N> beta;
+			for (std::size_t d = 0; d < N; d++)
+			{
+				beta[d] = static_cast<float>(Ratio(newResidualDotZ[d], residualDotZ[d]));
+			}
+			residualDotZ = newResidualDotZ;
+
+			// p = r / diagonal + beta p
+			jobs.ParallelForChunks(0, count, BLOCK_SIZE, [&](const std::size_t first, const std::size_t last)
+			{
+				for (std::size_t i = first; i < last; i++)
+				{
+					const float invDiagonal = 1.f / op.Diagonal(i);
+					for (std::size_t d = 0; d < N; d++)
+					{
+						p[d][i] = r[d][i] * invDiagonal + beta[d] * p[d][i];
+					}
+				}
+			});
+		}
+
+		return _telemetry;
+	}
+
+	/**
+	 * @brief Solve A x = b with the right preconditioned BiCGStab, for non-symmetric matrices.
+	 * @param x The initial guess, overwritten with the solution.
+	 * @param b The right hand side.
+	 */
+	template<typename Operator>
+	const SolverTelemetry& BiCGStab(JobSystem& jobs, const Operator& op, SolverColumns<N> x, SolverColumns<N> b, std::size_t count) noexcept
+	{
+		double sqrRhsNorm = 0.0;
+		if (!begin(jobs, count, x, b, sqrRhsNorm))
+		{
+			return _telemetry;
+		}
+
+		const SolverColumns<N> r = _residual.Columns();
+		const SolverColumns<N> shadow = _shadow.Columns();
+		const SolverColumns<N> p = _direction.Columns();
+		const SolverColumns<N> v = _product.Columns();
+		const SolverColumns<N> y = _preconditioned.Columns();
+		const SolverColumns<N> t = _stabilizer.Columns();
+
+		// r = shadow = b - A x, p = v = 0
+		Scalars sqrResidual;
+		Scalars rho = Reduce(jobs, count, sqrResidual, [&](std::size_t first, std::size_t last, Scalars& shadowDotR, Scalars& rr)
+		{
+			op.Multiply(x, v, first, last);
+			for (std::size_t d = 0; d < N; d++)
+			{
+				for (std::size_t i = first; i < last; i++)
+				{
+					const float residual = b[d][i] - v[d][i];
+					r[d][i] = residual;
+					shadow[d][i] = residual;
+					p[d][i] = 0.f;
+					v[d][i] = 0.f;
+				}
+				shadowDotR[d] = BlockDot(r[d], r[d], first, last);
+				rr[d] = shadowDotR[d];
+			}
+		});
+		_telemetry.InitialResidual = relativeResidual(sqrResidual, sqrRhsNorm);
+		_telemetry.Residual = _telemetry.InitialResidual;
+		_telemetry.Converged = _telemetry.Residual <= Settings.Tolerance;
+
+		Scalars previousRho, alpha, omega;
+		previousRho.fill(1.0);
+		alpha.fill(1.0);
+		omega.fill(1.0);
+
+		while (_telemetry.Residual > Settings.Tolerance && _telemetry.Iterations < Settings.MaxIterations)
+		{
+			std::array<float, N> beta, omegaF;
+			for (std::size_t d = 0; d < N; d++)
+			{
+				beta[d] = static_cast<float>(Ratio(rho[d], previousRho[d]) * Ratio(alpha[d], omega[d]));
+				omegaF[d] = static_cast<float>(omega[d]);
+			}
+
+			// p = r + beta (p - omega v), y = p / diagonal
+			jobs.ParallelForChunks(0, count, BLOCK_SIZE, [&](const std::size_t first, const std::size_t last)
+			{
+				for (std::size_t i = first; i < last; i++)
+				{
+					const float invDiagonal = 1.f / op.Diagonal(i);
+					for (std::size_t d = 0; d < N; d++)
+					{
+						p[d][i] = r[d][i] + beta[d] * (p[d][i] - omegaF[d] * v[d][i]);
+						y[d][i] = p[d][i] * invDiagonal;
+					}
+				}
+			});
+
+			// v = A y, the product reads y from neighboring blocks so it waits for the whole update
+			Scalars unused;
+			const Scalars shadowDotV = Reduce(jobs, count, unused, [&](std::size_t first, std::size_t last, Scalars& sv, Scalars&)
+			{
+				op.Multiply(y, v, first, last);
+				for (std::size_t d = 0; d < N; d++)
+				{
+					sv[d] = BlockDot(shadow[d], v[d], first, last);
+				}
+			});
+
+			std::array<float, N> alphaF;
+			for (std::size_t d = 0; d < N; d++)
+			{
+				alpha[d] = Ratio(rho[d], shadowDotV[d]);
+				alphaF[d] = static_cast<float>(alpha[d]);
+			}
+
+			// x += alpha y, s = r - alpha v stored in r, z = s / diagonal stored in y
+			jobs.ParallelForChunks(0, count, BLOCK_SIZE, [&](const std::size_t first, const std::size_t last)
+			{
+				for (std::size_t i = first; i < last; i++)
+				{
+					const float invDiagonal = 1.f / op.Diagonal(i);
+					for (std::size_t d = 0; d < N; d++)
+					{
+						x[d][i] += alphaF[d] * y[d][i];
+						r[d][i] -= alphaF[d] * v[d][i];
+						y[d][i] = r[d][i] * invDiagonal;
+					}
+				}
+			});
+
+			// t = A z, omega = (t . s) / (t . t)
+			Scalars sqrProduct;
+			const Scalars productDotS = Reduce(jobs, count, sqrProduct, [&](std::size_t first, std::size_t last, Scalars& ts, Scalars& tt)
+			{
+				op.Multiply(y, t, first, last);
+				for (std::size_t d = 0; d < N; d++)
+				{
+					ts[d] = BlockDot(t[d], r[d], first, last);
+					tt[d] = BlockDot(t[d], t[d], first, last);
+				}
+			});
+
+			for (std::size_t d = 0; d < N; d++)
+			{
+				omega[d] = Ratio(productDotS[d], sqrProduct[d]);
+				omegaF[d] = static_cast<float>(omega[d]);
+			}
+
+			// x += omega z, r = s - omega t
+			previousRho = rho;
+			rho = Reduce(jobs, count, sqrResidual, [&](std::size_t first, std::size_t last, Scalars& shadowDotR, Scalars& rr)
+			{
+				for (std::size_t d = 0; d < N; d++)
+				{
+					for (std::size_t i = first; i < last; i++)
+					{
+						x[d][i] += omegaF[d] * y[d][i];
+						r[d][i] -= omegaF[d] * t[d][i];
+					}
+					shadowDotR[d] = BlockDot(shadow[d], r[d], first, last);
+					rr[d] = BlockDot(r[d], r[d], first, last);
+				}
+			});
+			endIteration(sqrResidual, sqrRhsNorm);
+		}
+
+		return _telemetry;
+	}
+
+	/**
+	 * @brief Solve A x = b with weighted Jacobi relaxation, x += JacobiWeight * (b - A x) / diagonal.
+	 * @note Cheaper per iteration than the Krylov solvers and robust, but converges slowly on large systems.
+	 * @param x The initial guess, overwritten with the solution.
+	 * @param b The right hand side.
+	 */
+	template<typename Operator>
+	const SolverTelemetry& Jacobi(JobSystem& jobs, const Operator& op, SolverColumns<N> x, SolverColumns<N> b, std::size_t count) noexcept
+	{
+		double sqrRhsNorm = 0.0;
+		if (!begin(jobs, count, x, b, sqrRhsNorm))
+		{
+			return _telemetry;
+		}
+
+		const SolverColumns<N> q = _product.Columns();
+		const float weight = Settings.JacobiWeight;
+
+		for (bool first = true; ; first = false)
+		{
+			// Every product reads the same iterate, x is only updated once they are all done
+			Scalars unused;
+			const Scalars sqrResidual = Reduce(jobs, count, unused, [&](std::size_t begin, std::size_t end, Scalars& rr, Scalars&)
+			{
+				op.Multiply(x, q, begin, end);
+				for (std::size_t d = 0; d < N; d++)
+				{
+					for (std::size_t i = begin; i < end; i++)
+					{
+						const float residual = b[d][i] - q[d][i];
+						q[d][i] = residual;
+						rr[d] += static_cast<double>(residual) * residual;
+					}
+				}
+			});
+
+			if (first)
+			{
+				_telemetry.InitialResidual = relativeResidual(sqrResidual, sqrRhsNorm);
+				_telemetry.Residual = _telemetry.InitialResidual;
+			}
+			else
+			{
+				endIteration(sqrResidual, sqrRhsNorm);
+			}
+
+			if (_telemetry.Residual <= Settings.Tolerance || _telemetry.Iterations >= Settings.MaxIterations)
+			{
+				break;
+			}
+
+			jobs.ParallelForChunks(0, count, BLOCK_SIZE, [&](const std::size_t begin, const std::size_t end)
+			{
+				for (std::size_t i = begin; i < end; i++)
+				{
+					const float step = weight / op.Diagonal(i);
+					for (std::size_t d = 0; d < N; d++)
+					{
+						x[d][i] += step * q[d][i];
+					}
+				}
+			});
+		}
+
+		_telemetry.Converged = _telemetry.Residual <= Settings.Tolerance;
+		return _telemetry;
+	}
+
+	[[nodiscard]] const SolverTelemetry& GetTelemetry() const noexcept { return _telemetry; }
+
+	/**
+	 * @brief Clear the telemetry, for callers skipping a solve that has nothing to do.
+	 */
+	void ResetTelemetry() noexcept
+	{
+		_telemetry.Iterations = 0;
+		_telemetry.InitialResidual = 0.f;
+		_telemetry.Residual = 0.f;
+		_telemetry.Converged = true;
+		_telemetry.ResidualHistory.clear();
+	}
+
+	/**
+	 * @brief Dot product of a and b over [first, last), with independent partial sums the compiler can vectorize.
+	 */
+	static double BlockDot(const float* __restrict a, const float* __restrict b, std::size_t first, std::size_t last) noexcept
+	{
+		constexpr std::size_t LANES = 8;
+		float lanes[LANES] = {};
+
+		std::size_t i = first;
+		for (; i + LANES <= last; i += LANES)
+		{
+			for (std::size_t lane = 0; lane < LANES; lane++)
+			{
+				lanes[lane] += a[i + lane] * b[i + lane];
+			}
+		}
+
+		double sum = 0.0;
+		for (; i < last; i++)
+		{
+			sum += static_cast<double>(a[i]) * b[i];
+		}
+		for (const float lane : lanes)
+		{
+			sum += lane;
+		}
+		return sum;
+	}
+
+private:
+	/**
+	 * @brief Reset the telemetry, size the work vectors and compute the right hand side norm.
+	 * @return false if there is nothing to solve, b being zero or empty.
+	 */
+	bool begin(JobSystem& jobs, std::size_t count, SolverColumns<N> x, SolverColumns<N> b, double& sqrRhsNorm) noexcept
+	{
+		ResetTelemetry();
+
+		if (count == 0)
+		{
+			return false;
+		}
+
+		_residual.Resize(count);
+		_shadow.Resize(count);
+		_direction.Resize(count);
+		_product.Resize(count);
+		_preconditioned.Resize(count);
+		_stabilizer.Resize(count);
+
+		const Scalars sqrNorms = Dot(jobs, b, b, count);
+		sqrRhsNorm = 0.0;
+		for (const double sqrNorm : sqrNorms)
+		{
+			sqrRhsNorm += sqrNorm;
+		}
+
+		// The solution of A x = 0 is 0
+		if (sqrRhsNorm == 0.0)
+		{
+			for (std::size_t d = 0; d < N; d++)
+			{
+				std::fill(x[d], x[d] + count, 0.f);
+			}
+			return false;
+		}
+
+		_telemetry.Converged = false;
+		return true;
+	}
+
+	static float relativeResidual(const Scalars& sqrResidual, double sqrRhsNorm) noexcept
+	{
+		double sum = 0.0;
+		for (const double value : sqrResidual)
+		{
+			sum += value;
+		}
+		return static_cast<float>(std::sqrt(sum / sqrRhsNorm));
+	}
+
+	void endIteration(const Scalars& sqrResidual, double sqrRhsNorm) noexcept
+	{
+		_telemetry.Iterations++;
+		_telemetry.Residual = relativeResidual(sqrResidual, sqrRhsNorm);
+		_telemetry.Converged = _telemetry.Residual <= Settings.Tolerance;
+		if (Settings.RecordHistory)
+		{
+			_telemetry.ResidualHistory.push_back(_telemetry.Residual);
+		}
+	}
+
+	/**
+	 * @brief numerator / denominator, 0 when the denominator is 0 so a converged column stops moving.
+	 */
+	static double Ratio(double numerator, double denominator) noexcept
+	{
+		return denominator != 0.0 ? numerator / denominator : 0.0;
+	}
+};
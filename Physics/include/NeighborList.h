@@ -0,0 +1,162 @@
+#pragma once
+
+#include "UniformGrid.h"
+#include "CountingSort.h"
+#include "JobSystem.h"
+
+#include <algorithm>
+#include <cstdint>
+#include <vector>
+
+/**
+ * @brief Parallel build of compressed sparse row lists: each chunk of particles gathers into its own buffer,
+ * then the buffers are copied back to back in chunk order.
+ * @note The result is the same as a serial build whatever the worker count. The buffers keep their capacity,
+ * so nothing is allocated once they reached their size.
+ */
+class ChunkedListBuilder
+{
+public:
+	static constexpr std::size_t GRAIN_SIZE = 256; /**< Particles gathered by one job. */
+
+private:
+	std::vector<std::vector<std::uint32_t>> _chunks; /**< Indices gathered by each chunk. */
+	std::vector<std::uint32_t> _chunkStarts; /**< Start of each chunk in the final indices. */
+
+public:
+	/**
+	 * @brief Build the lists of count particles.
+	 * @param offsets Receives the start of each list, count + 1 entries.
+	 * @param indices Receives the lists back to back.
+	 * @param gather gather(i, list) appends the entries of particle i to list.
+	 */
+	template<typename Gather>
+	void Build(std::size_t count, JobSystem& jobs, std::vector<std::uint32_t>& offsets, std::vector<std::uint32_t>& indices,
+		Gather&& gather) noexcept
+	{
+		const std::size_t chunks = (count + GRAIN_SIZE - 1) / GRAIN_SIZE;
+		_chunks.resize(chunks);
+		_chunkStarts.resize(chunks);
+		offsets.resize(count + 1);
+
+		// Offsets are relative to the chunk until its start is known
+		jobs.ParallelFor(0, chunks, 1, [&](const std::size_t chunk)
+		{
+			const std::size_t first = chunk * GRAIN_SIZE;
+			const std::size_t last = std::min(first + GRAIN_SIZE, count);
+			auto& list = _chunks[chunk];
+			list.clear();
+			for (std::size_t i = first; i < last; i++)
+			{
+				offsets[i] = static_cast<std::uint32_t>(list.size());
+				gather(i, list);
+			}
+		});
+
+		std::uint32_t start = 0;
+		for (std::size_t chunk = 0; chunk < chunks; chunk++)
+		{
+			_chunkStarts[chunk] = start;
+			start += static_cast<std::uint32_t>(_chunks[chunk].size());
+		}
+		indices.resize(start);
+		offsets[count] = start;
+
+		jobs.ParallelFor(0, chunks, 1, [&](const std::size_t chunk)
+		{
+			const std::size_t first = chunk * GRAIN_SIZE;
+			const std::size_t last = std::min(first + GRAIN_SIZE, count);
+			const std::uint32_t chunkStart = _chunkStarts[chunk];
+			std::copy(_chunks[chunk].begin(), _chunks[chunk].end(), indices.begin() + chunkStart);
+			for (std::size_t i = first; i < last; i++)
+			{
+				offsets[i] += chunkStart;
+			}
+		});
+	}
+};
+
+/**
+ * @brief Compressed sparse row list of the neighbors of every particle.
+ * @note The neighbors of particle i are Indices[Offsets[i], Offsets[i + 1]). A particle is never its own
+ * neighbor and only particles strictly closer than the build radius are kept.
+ * Built with an interaction radius plus a skin, the list stays valid (Verlet list) until a particle moved
+ * more than half of the skin since the build.
+ * A half list stores each pair once, in the list of the particle whose cell comes first in the half-shell
+ * stencil, for passes applying equal and opposite contributions. It comes with its reverse: the entries of
+ * Indices naming particle j are ReverseEntries[ReverseOffsets[j], ReverseOffsets[j + 1]), in increasing order,
+ * so a pass can gather the contributions written to the entries instead of scattering them.
+ */
+class NeighborList
+{
+public:
+	std::vector<std::uint32_t> Offsets; /**< Start of the neighbors of each particle, Size() + 1 entries. */
+	std::vector<std::uint32_t> Indices; /**< Neighbor particle indices of all particles, back to back. */
+	std::vector<std::uint32_t> ReverseOffsets; /**< Start of the entries naming each particle, Size() + 1 entries, half lists only. */
+	std::vector<std::uint32_t> ReverseEntries; /**< Indices entries naming each particle, back to back, half lists only. */
+
+private:
+	ChunkedListBuilder _builder; /**< Gathers the lists in parallel. */
+	CountingSort _reverseSort; /**< Sorts the entries by neighbor to build the reverse list. */
+	std::vector<float> _buildX; /**< X position of each particle when the list was built. */
+	std::vector<float> _buildY; /**< Y position of each particle when the list was built. */
+	std::vector<float> _buildZ; /**< Z position of each particle when the list was built. */
+	float _buildRadius = 0.f; /**< Radius the list was built with. */
+	bool _half = false; /**< Whether the list stores each pair once. */
+
+public:
+
+	/**
+	 * @brief Gather the in-radius neighbors of every particle from the grid candidates.
+	 * @param grid The grid built on the same positions.
+	 * @param x The x position of each particle.
+	 * @param y The y position of each particle.
+	 * @param z The z position of each particle.
+	 * @param count The number of particles.
+	 * @param radius The interaction radius.
+	 * @param jobs The job system running the build.
+	 * @param half Store each pair once by walking the half-shell stencil of the grid.
+	 * @param skip Optional mask, the particles with a non-zero entry get an empty list but still appear in the lists of the others.
+	 */
+	void Build(const UniformGrid& grid, const float* x, const float* y, const float* z, std::size_t count, float radius,
+		JobSystem& jobs, bool half = false, const std::uint32_t* skip = nullptr) noexcept;
+
+	/**
+	 * @brief Check if the list has to be rebuilt for the given positions.
+	 * @param x The x position of each particle.
+	 * @param y The y position of each particle.
+	 * @param z The z position of each particle.
+	 * @param count The number of particles.
+	 * @param radius The radius the list would be built with, interaction radius plus skin.
+	 * @param skin The skin included in the radius, a null skin always requires a rebuild.
+	 * @return true if the particle count or the radius changed or a particle moved more than skin / 2.
+	 */
+	[[nodiscard]] bool NeedsRebuild(const float* x, const float* y, const float* z, std::size_t count, float radius, float skin) const noexcept;
+
+	/**
+	 * @brief Empty the list, the arrays keep their capacity.
+	 */
+	void Clear() noexcept;
+
+	[[nodiscard]] bool IsHalf() const noexcept { return _half; }
+
+	[[nodiscard]] std::size_t Size() const noexcept { return Offsets.empty() ? 0 : Offsets.size() - 1; }
+
+	[[nodiscard]] float AverageLength() const noexcept { return Size() == 0 ? 0.f : static_cast<float>(Indices.size()) / Size(); }
+
+	/**
+	 * @brief Average list length of the particles the list was built for.
+	 * @param skip The mask given to Build, the skipped particles have an empty list and are not counted.
+	 * @return 0 if every particle was skipped.
+	 */
+	[[nodiscard]] float AverageLength(const std::uint32_t* skip) const noexcept;
+
+	[[nodiscard]] const std::uint32_t* begin(std::size_t particle) const noexcept { return Indices.data() + Offsets[particle]; }
+	[[nodiscard]] const std::uint32_t* end(std::size_t particle) const noexcept { return Indices.data() + Offsets[particle + 1]; }
+
+private:
+	/**
+	 * @brief Build ReverseOffsets and ReverseEntries from Offsets and Indices with a counting sort.
+	 */
+	void buildReverse(std::size_t count, JobSystem& jobs) noexcept;
+};
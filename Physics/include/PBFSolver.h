@@ -0,0 +1,118 @@
+#pragma once
+
+#include "FluidParticleSystem.h"
+#include "NeighborList.h"
+#include "BoundaryParticles.h"
+#include "SPHKernels.h"
+#include "JobSystem.h"
+
+#include <cstddef>
+#include <vector>
+
+/**
+ * @brief Position Based Fluids solver (Macklin and Müller).
+ * @note The particles are moved to their predicted position, then a density constraint per particle is
+ * projected with Jacobi iterations over the neighbor list and the velocities are derived from the
+ * corrected positions. XSPH viscosity smooths the resulting velocity field. A few iterations per step keep
+ * the fluid stable at frame rate steps where an equation of state needs many substeps.
+ * Densities are mass weighted, SPHParams::RestDensity is the rest density. The boundary particles add to the densities
+ * and constraint gradients of their fluid neighbors and push back with the multiplier of the particle (Akinci et al. 2012).
+ * Relaxation and MaxCorrection are relative to the cubic lattice on which the particles have the rest density.
+ */
+class PBFSolver
+{
+public:
+	/**
+	 * @brief Iterations and error of the last solve.
+	 */
+	struct Stats
+	{
+		std::size_t Iterations = 0;
+		float DensityError = 0.f; /**< Average compression relative to the rest density before the last iteration. */
+	};
+
+	std::size_t Iterations = 4; /**< Constraint projections per step. */
+	float Relaxation = 1.f; /**< Constraint force mixing added to the denominator of the multipliers, as a fraction of the one of a particle at rest, softens sparse neighborhoods. */
+	float MaxCorrection = 0.1f; /**< Largest position correction of one iteration, as a fraction of the particle spacing at rest. */
+	float TensileStrength = 0.1f; /**< Strength of the artificial pressure preventing particle clumping, 0 disables it. */
+	float TensileDistance = 0.2f; /**< Distance, as a fraction of the smoothing radius, at which the artificial pressure equals TensileStrength. */
+	float XSPHViscosity = 0.01f; /**< Fraction of the smoothed neighbor velocity difference blended into each velocity. */
+
+private:
+	std::vector<float> _lambdas; /**< Constraint multiplier of each particle for the current iteration. */
+	std::vector<float> _deltaX; /**< X position correction of each particle for the current iteration. */
+	std::vector<float> _deltaY; /**< Y position correction of each particle for the current iteration. */
+	std::vector<float> _deltaZ; /**< Z position correction of each particle for the current iteration. */
+	std::vector<float> _startX; /**< X position of each particle at the start of the step, the fluid columns hold the prediction while it is projected. */
+	std::vector<float> _startY; /**< Y position of each particle at the start of the step. */
+	std::vector<float> _startZ; /**< Z position of each particle at the start of the step. */
+
+	struct alignas(64) ChunkError
+	{
+		double Sum = 0.0;
+	};
+	std::vector<ChunkError> _chunkErrors; /**< Error sum of each chunk of particles, added up in chunk order so it does not depend on the scheduling. */
+
+	float _restSpacing = 0.f; /**< Spacing of the cubic lattice on which the particles have the rest density. */
+	float _restGradientSum = 0.f; /**< Sum of the squared constraint gradients of a particle of that lattice. */
+	float _restLatticeDensity = 0.f; /**< Rest density the lattice was measured for. */
+	float _restLatticeRadius = 0.f; /**< Smoothing radius the lattice was measured for. */
+	SPHSmoothingKernel _restLatticeKernel = SPHSmoothingKernel::Spiky; /**< Kernel the lattice was measured for. */
+	bool _restLatticeValid = false;
+
+	Stats _stats;
+
+public:
+	/**
+	 * @brief Attach the start position columns to the particles, they follow a reorder between the prediction and
+	 * the velocity update. Must be done before the first step.
+	 */
+	void Attach(FluidParticleSystem& fluids) noexcept;
+
+	/**
+	 * @brief Keep the current positions as the start positions and integrate the particles to their prediction with
+	 * semi-implicit Euler, the forces are then reset to the external force.
+	 * @param integrator The implementation to use, see Integrators::Select.
+	 * @param deltaTime The time step.
+	 * @param gravity The downward gravity force applied to every particle.
+	 */
+	void PredictPositions(FluidParticleSystem& fluids, const IntegratorTable& integrator, JobSystem& jobs, float deltaTime,
+		float gravity) noexcept;
+
+	/**
+	 * @brief Project the density constraints on the predicted positions.
+	 * @param fluids The fluid particles, the position columns hold the prediction.
+	 * @param neighbors The full neighbor list of the predicted positions.
+	 * @param boundary The boundary particles, their neighbor lists searched along with the fluid one.
+	 * @param params The SPH parameters.
+	 * @param jobs The job system running the passes.
+	 */
+	void SolveDensity(FluidParticleSystem& fluids, const NeighborList& neighbors, const BoundaryParticleSystem& boundary,
+		const SPHParams& params, JobSystem& jobs) noexcept;
+
+	/**
+	 * @brief Derive the velocities from the distance between the start and the projected positions.
+	 * @param deltaTime The time step.
+	 */
+	void UpdateVelocities(FluidParticleSystem& fluids, JobSystem& jobs, float deltaTime) noexcept;
+
+	/**
+	 * @brief Blend the velocity of each particle toward the smoothed velocity of its neighbors.
+	 * @note Reads the densities of the last iteration of SolveDensity.
+	 */
+	void ApplyViscosity(FluidParticleSystem& fluids, const NeighborList& neighbors, const SPHParams& params, JobSystem& jobs) noexcept;
+
+	/**
+	 * @brief Measure the rest lattice again at the next solve, when particles are added or removed or the SPH
+	 * settings change. A change of the rest density, smoothing radius or kernel is also caught by the solve.
+	 */
+	void InvalidateRestLattice() noexcept { _restLatticeValid = false; }
+
+	[[nodiscard]] const Stats& GetStats() const noexcept { return _stats; }
+
+private:
+	/**
+	 * @brief Sum the chunk errors in chunk order and reset them.
+	 */
+	[[nodiscard]] double collectError() noexcept;
+};
@@ -1,21 +1,36 @@
 #pragma once
 
-#include "cstddef"
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+
+/**
+ * @brief Layout of the 32-bit handles of the slot maps: the slot index in the low REF_INDEX_BITS bits, the
+ * generation of the slot in the remaining ones.
+ * @note A world holds at most 2^24 bodies and colliders. A slot can be reused 255 times, then it is retired so
+ * a handle to a destroyed object never aliases a new one, see SlotMap.
+ */
+constexpr std::uint32_t REF_INDEX_BITS = 24;
+constexpr std::uint32_t REF_INDEX_MASK = (1u << REF_INDEX_BITS) - 1;
+constexpr std::uint32_t REF_GEN_MASK = 0xFFFFFFFFu >> REF_INDEX_BITS;
 
 struct BodyRef {
-	std::size_t Index;
-	std::size_t GenIndex;
+	std::uint32_t Handle = 0; /**< Packed slot index and generation. */
+
+	[[nodiscard]] static constexpr BodyRef Make(std::uint32_t index, std::uint32_t genIndex) noexcept {
+		return { (genIndex << REF_INDEX_BITS) | (index & REF_INDEX_MASK) };
+	}
+
+	[[nodiscard]] constexpr std::uint32_t Index() const noexcept { return Handle & REF_INDEX_MASK; }
+	[[nodiscard]] constexpr std::uint32_t GenIndex() const noexcept { return Handle >> REF_INDEX_BITS; }
 
 	constexpr bool operator==(const BodyRef& other) const {
-		return (Index == other.Index) && (GenIndex == other.GenIndex);
+		return Handle == other.Handle;
 	}
 };
 struct BodyRefHash {
-	std::size_t operator()(const BodyRef& pair) const {
-		const std::size_t hashA = std::hash<size_t>{}(pair.Index);
-		const std::size_t hashB = std::hash<size_t>{}(pair.GenIndex);
-		// XOR for the hash
-		return hashA ^ hashB;
+	std::size_t operator()(const BodyRef& ref) const {
+		return std::hash<std::uint32_t>{}(ref.Handle);
 	}
 };
 
@@ -42,10 +57,16 @@ struct BodyRefPairHash
 };
 
 struct ColliderRef {
-	std::size_t Index;
-	std::size_t GenIndex;
+	std::uint32_t Handle = 0; /**< Packed slot index and generation. */
+
+	[[nodiscard]] static constexpr ColliderRef Make(std::uint32_t index, std::uint32_t genIndex) noexcept {
+		return { (genIndex << REF_INDEX_BITS) | (index & REF_INDEX_MASK) };
+	}
+
+	[[nodiscard]] constexpr std::uint32_t Index() const noexcept { return Handle & REF_INDEX_MASK; }
+	[[nodiscard]] constexpr std::uint32_t GenIndex() const noexcept { return Handle >> REF_INDEX_BITS; }
 
 	constexpr bool operator==(const ColliderRef& other) const {
-		return Index == other.Index && GenIndex == other.GenIndex;
+		return Handle == other.Handle;
 	}
-};
\ No newline at end of file
+};
@@ -0,0 +1,194 @@
+#pragma once
+
+#include "Allocators.h"
+#include "Integrator.h"
+#include "JobSystem.h"
+
+#include <DirectXMath.h>
+
+#include <cstdint>
+#include <utility>
+#include <vector>
+
+using namespace DirectX;
+
+/**
+ * @brief Structure of arrays owning the hot state of every body of the world: position, velocity, pending force
+ * and mass, one row per body slot.
+ * @note The Body stored in the world slot map is a view on its row (see Body), so the state is never copied
+ * around: the integrator streams the rows of the DYNAMIC bodies in place, 11 floats per body.
+ * The rows of the fluid bodies are only read when they become fluid and written when they stop being one, the
+ * FluidParticleSystem owns their state in between.
+ */
+class RigidBodySystem
+{
+private:
+	AlignedHeapAllocator _alloc; /**< Allocator of the columns, must be declared before them. */
+
+public:
+	CustomlyAllocatedVector<float> PositionX{ _alloc }; /**< X position of each body. */
+	CustomlyAllocatedVector<float> PositionY{ _alloc }; /**< Y position of each body. */
+	CustomlyAllocatedVector<float> PositionZ{ _alloc }; /**< Z position of each body. */
+
+	CustomlyAllocatedVector<float> VelocityX{ _alloc }; /**< X velocity of each body. */
+	CustomlyAllocatedVector<float> VelocityY{ _alloc }; /**< Y velocity of each body. */
+	CustomlyAllocatedVector<float> VelocityZ{ _alloc }; /**< Z velocity of each body. */
+
+	CustomlyAllocatedVector<float> ForceX{ _alloc }; /**< X component of the force applied to the body since the last step. */
+	CustomlyAllocatedVector<float> ForceY{ _alloc }; /**< Y component of the force applied to the body since the last step. */
+	CustomlyAllocatedVector<float> ForceZ{ _alloc }; /**< Z component of the force applied to the body since the last step. */
+
+	CustomlyAllocatedVector<float> Mass{ _alloc }; /**< Mass of each body, negative if the body is disabled. */
+	CustomlyAllocatedVector<float> InvMass{ _alloc }; /**< Inverse mass of each body, updated with the mass, 0 if the body is disabled. */
+
+private:
+	std::vector<std::uint32_t> _dynamic; /**< 1 if the body of the slot is a DYNAMIC body. */
+	std::vector<std::pair<std::uint32_t, std::uint32_t>> _dynamicChunks; /**< Ranges of consecutive enabled DYNAMIC slots. */
+	bool _chunksDirty = false;
+
+	std::vector<std::uint32_t> _synchronous; /**< Slots whose velocity was set since the last step, see StartStaggeredKicks. */
+	std::vector<std::uint8_t> _isSynchronous; /**< 1 if the slot is in _synchronous. */
+
+public:
+	RigidBodySystem() noexcept = default;
+
+	RigidBodySystem(const RigidBodySystem&) = delete;
+	RigidBodySystem& operator=(const RigidBodySystem&) = delete;
+
+	[[nodiscard]] std::size_t Size() const noexcept { return Mass.size(); }
+
+	/**
+	 * @brief Grow the columns to the slot count of the body slot map, the new rows are reset.
+	 */
+	void Resize(std::size_t slotCount) noexcept;
+
+	/**
+	 * @brief Remove every row.
+	 */
+	void Clear() noexcept;
+
+	/**
+	 * @brief Reset the row of a slot to a disabled body at rest at the origin, for a created or destroyed body.
+	 */
+	void Reset(std::uint32_t slot) noexcept;
+
+	/**
+	 * @brief Set whether the body of a slot is integrated by the body step, static and fluid bodies are not.
+	 */
+	void SetDynamic(std::uint32_t slot, bool dynamic) noexcept;
+
+	[[nodiscard]] XMVECTOR GetPosition(std::uint32_t slot) const noexcept
+	{
+		return XMVectorSet(PositionX[slot], PositionY[slot], PositionZ[slot], 0);
+	}
+
+	void SetPosition(std::uint32_t slot, XMVECTOR position) noexcept
+	{
+		PositionX[slot] = XMVectorGetX(position);
+		PositionY[slot] = XMVectorGetY(position);
+		PositionZ[slot] = XMVectorGetZ(position);
+	}
+
+	[[nodiscard]] XMVECTOR GetVelocity(std::uint32_t slot) const noexcept
+	{
+		return XMVectorSet(VelocityX[slot], VelocityY[slot], VelocityZ[slot], 0);
+	}
+
+	/**
+	 * @brief Set the velocity of a body, taken as the velocity at the current time, see StartStaggeredKicks.
+	 */
+	void SetVelocity(std::uint32_t slot, XMVECTOR velocity) noexcept
+	{
+		VelocityX[slot] = XMVectorGetX(velocity);
+		VelocityY[slot] = XMVectorGetY(velocity);
+		VelocityZ[slot] = XMVectorGetZ(velocity);
+		markSynchronous(slot);
+	}
+
+	[[nodiscard]] XMVECTOR GetForce(std::uint32_t slot) const noexcept
+	{
+		return XMVectorSet(ForceX[slot], ForceY[slot], ForceZ[slot], 0);
+	}
+
+	void AddForce(std::uint32_t slot, XMVECTOR force) noexcept
+	{
+		ForceX[slot] += XMVectorGetX(force);
+		ForceY[slot] += XMVectorGetY(force);
+		ForceZ[slot] += XMVectorGetZ(force);
+	}
+
+	void ResetForce(std::uint32_t slot) noexcept
+	{
+		ForceX[slot] = 0.f;
+		ForceY[slot] = 0.f;
+		ForceZ[slot] = 0.f;
+	}
+
+	/**
+	 * @brief Set the mass of a body, a negative mass disables it and takes it out of the body step.
+	 */
+	void SetMass(std::uint32_t slot, float mass) noexcept
+	{
+		if ((Mass[slot] >= 0.f) != (mass >= 0.f))
+		{
+			_chunksDirty = true;
+		}
+		Mass[slot] = mass;
+		InvMass[slot] = mass > 0.f ? 1.f / mass : 0.f;
+	}
+
+	/**
+	 * @brief Split the enabled DYNAMIC slots into ranges of at most grainSize consecutive slots, only when they changed.
+	 */
+	void BuildDynamicChunks(std::size_t grainSize) noexcept;
+
+	/**
+	 * @brief Call func(first, last) in parallel on the ranges built by BuildDynamicChunks.
+	 */
+	template<typename Func>
+	void ForEachDynamicChunk(JobSystem& jobs, Func&& func) const noexcept
+	{
+		jobs.ParallelFor(0, _dynamicChunks.size(), 1, [&](const std::size_t chunk)
+		{
+			func(_dynamicChunks[chunk].first, _dynamicChunks[chunk].second);
+		});
+	}
+
+	/**
+	 * @brief Kick the bodies whose velocity was set since the last step by an extra time, before Integrate.
+	 * @note A staggered scheme keeps the velocity of a body half a step behind its position, but a velocity set from
+	 * outside (a new or newly DYNAMIC body, a contact response) is the one at the current time. Its first kick must
+	 * be half a step, the extra time is that minus the kick time of the step, 0 for a synchronous scheme.
+	 * @param integrator The implementation to use, see Integrators::Select.
+	 * @param extraKickTime The time added to the kick of these bodies.
+	 * @param gravity The downward gravity force applied to every body.
+	 */
+	void StartStaggeredKicks(const IntegratorTable& integrator, float extraKickTime, float gravity) noexcept;
+
+	/**
+	 * @brief Integrate the bodies of the slots [first, last) and consume their pending forces.
+	 * @param integrator The implementation to use, see Integrators::Select.
+	 * @param kickTime The time the velocities are kicked over, see Integrators::KickTime.
+	 * @param deltaTime The time step.
+	 * @param gravity The downward gravity force applied to every body.
+	 */
+	void Integrate(const IntegratorTable& integrator, float kickTime, float deltaTime, float gravity,
+		std::size_t first, std::size_t last) noexcept;
+
+private:
+	[[nodiscard]] IntegratorColumns columns() noexcept;
+
+	void markSynchronous(std::uint32_t slot) noexcept
+	{
+		if (_isSynchronous[slot] == 0)
+		{
+			_isSynchronous[slot] = 1;
+			_synchronous.push_back(slot);
+		}
+	}
+
+	/**
+	 * @brief Whether the body step moves the body of a slot, disabled bodies stay where they are.
+	 */
+	[[nodiscard]] bool integrated(std::uint32_t slot) const noexcept { return _dynamic[slot] != 0 && Mass[slot] >= 0.f; }
+};
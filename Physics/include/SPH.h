@@ -1,40 +1,18 @@
 #pragma once
-#include "Utility.h"
+
+/**
+ * @brief SPH settings of the fluid bodies, edited at runtime by the samples.
+ * @note The kernel scaling factors derived from them live in SPHParams (see SPHKernels.h), the world
+ * recomputes them whenever one of these settings changes.
+ * TargetDensity is the WCSPH target of the equation of state. RestDensity is the mass weighted rest density of
+ * the DFSPH and PBF solvers, 0 lets the world measure it on the fluid the first time they step it.
+ */
 namespace SPH {
 
 	inline float SmoothingRadius = 15;
 	inline float TargetDensity = 50;
+	inline float RestDensity = 0;
 	inline float PressureMultiplier = 25;
 	inline float nearPressureMultiplier = 0.5;
 	inline float ViscosityStrength = 5000;
-	//inline float SpikyPow2ScalingFactor = 6 / (PI * Pow(SmoothingRadius, 4));;
-	//inline float SpikyPow3ScalingFactor = 10 / (PI * Pow(SmoothingRadius, 5));;
-	//inline float SpikyPow2DerivativeScalingFactor = 12 / (PI * Pow(SmoothingRadius, 4));
-	//inline float SpikyPow3DerivativeScalingFactor = 30 / (PI * Pow(SmoothingRadius, 5));
-	//inline float Poly6ScalingFactor = 4 / (PI * Pow(SmoothingRadius, 8));
-	inline float SpikyPow2ScalingFactor = 15.0f / (PI * Pow(SmoothingRadius, 5));
-	inline float SpikyPow3ScalingFactor = 315.0f / (64.0f * PI * Pow(SmoothingRadius, 9));
-	inline float SpikyPow2DerivativeScalingFactor = -30.0f / (PI * Pow(SmoothingRadius, 5));
-	inline float SpikyPow3DerivativeScalingFactor = -945.0f / (32.0f * PI * Pow(SmoothingRadius, 9));
-	inline float Poly6ScalingFactor = 315.0f / (64.0f * PI * Pow(SmoothingRadius, 9));
-
-
-	float SmoothingKernelPoly6(float radius, float dst);
-
-	float SpikyKernelPow3(float radius, float dst);
-	float SpikyKernelPow2(float radius, float dst);
-
-	float DerivativeSpikyPow3(float radius, float dst);
-
-	float DerivativeSpikyPow2(float radius, float dst);
-
-	float DensityKernel(float radius, float dst);
-
-	float NearDensityKernel(float radius, float dst);
-
-	float DensityDerivative(float radius, float dst);
-
-	float NearDensityDerivative(float radius, float dst);
-
-	float ViscosityKernel(float radius, float dst);
-}
\ No newline at end of file
+}
@@ -0,0 +1,77 @@
+#pragma once
+
+/**
+ * @file SPHKernelPolicies.h
+ * @brief Smoothing kernel policies, the SPH passes are templates on them so the chosen kernel is inlined
+ * in their inner loops. Value is W(r) and Slope is dW/dr, both are only called for r < h.
+ * @note Must not be included by the translation units compiled with AVX flags, see SPHKernels.h.
+ */
+
+#include "SPHKernels.h"
+
+struct SpikyKernel
+{
+	static float Value(const SPHParams& k, float distance, float) noexcept
+	{
+		const float q = k.SmoothingRadius - distance;
+		return q * q * k.KernelScale;
+	}
+
+	static float Slope(const SPHParams& k, float distance, float) noexcept
+	{
+		return (distance - k.SmoothingRadius) * k.DerivativeScale;
+	}
+};
+
+struct Poly6Kernel
+{
+	static float Value(const SPHParams& k, float, float sqrDistance) noexcept
+	{
+		const float v = k.SqrRadius - sqrDistance;
+		return v * v * v * k.KernelScale;
+	}
+
+	static float Slope(const SPHParams& k, float distance, float sqrDistance) noexcept
+	{
+		const float v = k.SqrRadius - sqrDistance;
+		return -distance * v * v * k.DerivativeScale;
+	}
+};
+
+struct WendlandKernel
+{
+	static float Value(const SPHParams& k, float distance, float) noexcept
+	{
+		const float q = distance * k.InvRadius;
+		const float t = 1.f - q;
+		return t * t * t * t * (1.f + 4.f * q) * k.KernelScale;
+	}
+
+	static float Slope(const SPHParams& k, float distance, float) noexcept
+	{
+		const float q = distance * k.InvRadius;
+		const float t = 1.f - q;
+		return -q * t * t * t * k.DerivativeScale;
+	}
+};
+
+/**
+ * @brief Call func with a default constructed policy of the kernel, func is usually a generic lambda
+ * instantiated once per kernel.
+ */
+template<typename Func>
+void DispatchSmoothingKernel(SPHSmoothingKernel kernel, Func&& func) noexcept
+{
+	switch (kernel)
+	{
+	case SPHSmoothingKernel::Spiky:
+		func(SpikyKernel{});
+		break;
+	case SPHSmoothingKernel::Poly6:
+		func(Poly6Kernel{});
+		break;
+	case SPHSmoothingKernel::Wendland:
+		func(WendlandKernel{});
+		break;
+	}
+}
@@ -0,0 +1,171 @@
+#pragma once
+
+/**
+ * @file SPHKernels.h
+ * @brief Batched SPH kernels with scalar, AVX2 and AVX-512 implementations.
+ * @note The step runs two sweeps over the neighbor lists: density and near density first, then the pressure
+ * and viscosity forces, which only depend on the densities, together.
+ * @note This header is included by translation units compiled with AVX flags, it must only declare plain
+ * data and functions: an inline function defined here could be compiled with AVX instructions and picked
+ * by the linker for the whole program.
+ */
+
+#include <cstddef>
+#include <cstdint>
+
+/**
+ * @brief Raw pointers to the fluid columns and neighbor list read and written by the kernels.
+ */
+struct SPHParticleColumns
+{
+	const float* PositionX = nullptr;
+	const float* PositionY = nullptr;
+	const float* PositionZ = nullptr;
+	const float* VelocityX = nullptr;
+	const float* VelocityY = nullptr;
+	const float* VelocityZ = nullptr;
+	const float* Mass = nullptr;
+
+	float* Density = nullptr;
+	float* NearDensity = nullptr;
+	float* Pressure = nullptr;
+	float* ForceX = nullptr;
+	float* ForceY = nullptr;
+	float* ForceZ = nullptr;
+
+	const std::uint32_t* NeighborOffsets = nullptr; /**< CSR offsets, see NeighborList. */
+	const std::uint32_t* NeighborIndices = nullptr; /**< CSR neighbor indices, see NeighborList. */
+	const std::uint32_t* ReverseOffsets = nullptr; /**< CSR offsets of the reverse half list, see NeighborList. */
+	const std::uint32_t* ReverseEntries = nullptr; /**< Entries of the half list naming each particle, see NeighborList. */
+};
+
+/**
+ * @brief Smoothing kernel used for the density, the pressure gradient and the viscosity.
+ */
+enum class SPHSmoothingKernel
+{
+	Spiky, /**< (h - r)^2 * 6 / (pi h^4), the only kernel with SIMD implementations. */
+	Poly6, /**< (h^2 - r^2)^3 * 315 / (64 pi h^9). */
+	Wendland, /**< Wendland C2, (1 - q)^4 (1 + 4q) * 21 / (2 pi h^3) with q = r / h. */
+};
+
+/**
+ * @brief SPH settings and the kernel constants derived from them.
+ * @note Built by SPHKernels::MakeParams when a setting changes, the passes never recompute a power of h.
+ */
+struct SPHParams
+{
+	float SmoothingRadius = 0.f; /**< Smoothing radius h. */
+	float TargetDensity = 0.f;
+	float RestDensity = 0.f; /**< Mass weighted rest density of the DFSPH and PBF solvers, see World::GetRestDensity. */
+	float PressureMultiplier = 0.f;
+	float ViscosityStrength = 0.f;
+	SPHSmoothingKernel Kernel = SPHSmoothingKernel::Spiky;
+
+	float SqrRadius = 0.f; /**< h^2, pairs at a squared distance >= h^2 are rejected before any sqrt. */
+	float InvRadius = 0.f; /**< 1 / h. */
+	float KernelScale = 0.f; /**< Normalisation factor of the smoothing kernel. */
+	float DerivativeScale = 0.f; /**< Normalisation factor of the smoothing kernel slope. */
+	float NearKernelScale = 0.f; /**< 10 / (pi h^5), the near density kernel is (h - r)^3 * NearKernelScale. */
+	float SelfDensity = 0.f; /**< Smoothing kernel at distance 0, the contribution of a particle to its own density. */
+	float SelfNearDensity = 0.f; /**< Near density kernel at distance 0. */
+};
+
+/**
+ * @brief Kernel applied to the particles in [begin, end).
+ */
+using SPHKernelFunction = void (*)(const SPHParticleColumns& columns, const SPHParams& params, std::size_t begin, std::size_t end);
+
+/**
+ * @brief One implementation of the two SPH sweeps.
+ */
+struct SPHKernelTable
+{
+	const char* Name = ""; /**< Instruction set of the implementation. */
+	SPHKernelFunction Density = nullptr; /**< Write Density, NearDensity and Pressure. */
+	SPHKernelFunction Forces = nullptr; /**< Add the pressure and viscosity forces to Force. */
+};
+
+/**
+ * @brief Contribution of each pair of the half neighbor list to its second particle, indexed by list entry.
+ * @note The pair kernels add the first particle's share straight to its columns and write the second one's to
+ * the entry of the pair, so every value is written by the job owning the first particle and nothing has to be
+ * zeroed. The finish passes then gather the entries naming each particle through the reverse list, in entry
+ * order, which makes the sums independent of the worker count and of the scheduling.
+ */
+struct SPHPairAccumulator
+{
+	float* Density = nullptr;
+	float* NearDensity = nullptr;
+	float* ForceX = nullptr;
+	float* ForceY = nullptr;
+	float* ForceZ = nullptr;
+};
+
+/**
+ * @brief Kernel evaluating once each pair of the half neighbor lists of the particles in [begin, end).
+ */
+using SPHPairKernelFunction = void (*)(const SPHParticleColumns& columns, const SPHParams& params,
+	const SPHPairAccumulator& accumulator, std::size_t begin, std::size_t end);
+
+/**
+ * @brief The symmetric pair sweeps, see World::SymmetricPairs.
+ */
+struct SPHPairKernelTable
+{
+	SPHPairKernelFunction Density = nullptr; /**< Write the pair density and near density of the first particles, without the self contribution, and of each entry. */
+	SPHPairKernelFunction Forces = nullptr; /**< Add equal and opposite pressure and viscosity forces to the first particles and write them to each entry, reads the final Density and Pressure. */
+};
+
+namespace SPHKernels
+{
+	/**
+	 * @brief Compute the kernel constants from the SPH settings.
+	 */
+	[[nodiscard]] SPHParams MakeParams(float smoothingRadius, float targetDensity, float pressureMultiplier,
+		float viscosityStrength, SPHSmoothingKernel kernel) noexcept;
+
+	/**
+	 * @return The scalar implementation specialized for the kernel.
+	 */
+	[[nodiscard]] const SPHKernelTable& Scalar(SPHSmoothingKernel kernel) noexcept;
+
+	/**
+	 * @return The AVX2 + FMA implementation of the spiky kernel, nullptr if the binary was built without it.
+	 */
+	[[nodiscard]] const SPHKernelTable* AVX2() noexcept;
+
+	/**
+	 * @return The AVX-512 implementation of the spiky kernel, nullptr if the binary was built without it.
+	 */
+	[[nodiscard]] const SPHKernelTable* AVX512() noexcept;
+
+	/**
+	 * @brief Whether the running CPU and operating system support AVX2 + FMA, also used by the other SIMD passes.
+	 */
+	[[nodiscard]] bool HasAVX2() noexcept;
+
+	/**
+	 * @brief Pick the widest implementation of the kernel supported by the running CPU and operating system.
+	 * @note Only the spiky kernel has SIMD implementations, the other kernels use their scalar specialization.
+	 */
+	[[nodiscard]] const SPHKernelTable& Select(SPHSmoothingKernel kernel) noexcept;
+
+	/**
+	 * @return The symmetric pair sweeps specialized for the kernel.
+	 */
+	[[nodiscard]] const SPHPairKernelTable& Pairs(SPHSmoothingKernel kernel) noexcept;
+
+	/**
+	 * @brief Add the self contribution and the pair entries naming the particles in [begin, end) to Density and
+	 * NearDensity, then write Pressure.
+	 */
+	void FinishDensityPairs(const SPHParticleColumns& columns, const SPHParams& params,
+		const SPHPairAccumulator& accumulator, std::size_t begin, std::size_t end) noexcept;
+
+	/**
+	 * @brief Add the pair entries naming the particles in [begin, end) to Force.
+	 */
+	void FinishForcePairs(const SPHParticleColumns& columns, const SPHPairAccumulator& accumulator,
+		std::size_t begin, std::size_t end) noexcept;
+}
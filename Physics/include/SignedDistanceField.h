@@ -0,0 +1,108 @@
+#pragma once
+
+#include "FluidParticleSystem.h"
+#include "Shape.h"
+#include "JobSystem.h"
+
+#include <cstdint>
+#include <unordered_map>
+#include <vector>
+
+/**
+ * @brief Static scenery baked once into a sparse signed distance field, the fluid particles are pushed out of it
+ * with one trilinear lookup per particle instead of colliders in the octree.
+ * @note The distance is positive in free space and negative inside the solids. Only the bricks of
+ * BRICK_CELLS^3 cells that hold distances under Band are stored, in a hash map keyed by brick coordinate, so a
+ * large container costs its walls only. Away from the stored bricks the field reads as Band, a particle further
+ * than Band inside a solid is not pushed out. Containers added as analytic are evaluated exactly per particle
+ * and never baked, the usual box around a fluid costs no memory and has perfectly flat walls.
+ */
+class SignedDistanceField
+{
+public:
+	static constexpr int BRICK_CELLS = 8; /**< Cells per brick edge, a brick stores (BRICK_CELLS + 1)^3 nodes. */
+	static constexpr int BRICK_NODES = BRICK_CELLS + 1;
+
+	float CellSize = 5.f; /**< Distance between two nodes of the baked grid. */
+	float Band = 20.f; /**< Distance to the surfaces under which bricks are kept. */
+	float ParticleRadius = 2.5f; /**< Distance kept between the particle centers and the surfaces. */
+	float Restitution = 0.f; /**< Part of the normal velocity reflected when a particle hits a surface. */
+	float Friction = 0.f; /**< Part of the tangential velocity removed when a particle hits a surface. */
+
+private:
+	/**
+	 * @brief A box, solid or a container keeping the fluid inside.
+	 */
+	struct Box
+	{
+		float Min[3];
+		float Max[3];
+		bool Container;
+	};
+
+	/**
+	 * @brief A solid sphere.
+	 */
+	struct Ball
+	{
+		float Center[3];
+		float Radius;
+	};
+
+	std::vector<Box> _boxes; /**< Boxes baked into the grid. */
+	std::vector<Ball> _balls; /**< Spheres baked into the grid. */
+	std::vector<Box> _analyticContainers; /**< Containers evaluated exactly at each query. */
+
+	std::unordered_map<std::uint64_t, std::uint32_t> _brickOfKey; /**< Index of the brick at each brick coordinate. */
+	std::vector<float> _distances; /**< Node distances of the bricks, BRICK_NODES^3 per brick. */
+	float _bakedCellSize = 0.f; /**< Cell size of the last bake. */
+	bool _dirty = false; /**< Set when geometry was added since the last bake. */
+
+public:
+	/**
+	 * @brief Add a box to the static geometry.
+	 * @param box The box, in world space.
+	 * @param container Keep the fluid inside the box instead of outside.
+	 * @param analytic Evaluate the container exactly at each query instead of baking it, only for containers.
+	 */
+	void AddCuboid(const CuboidF& box, bool container = false, bool analytic = false) noexcept;
+
+	/**
+	 * @brief Add a solid sphere to the static geometry.
+	 */
+	void AddSphere(const SphereF& sphere) noexcept;
+
+	/**
+	 * @brief Remove every shape and the baked bricks.
+	 */
+	void Clear() noexcept;
+
+	[[nodiscard]] bool Empty() const noexcept { return _boxes.empty() && _balls.empty() && _analyticContainers.empty(); }
+
+	[[nodiscard]] std::size_t BrickCount() const noexcept { return _brickOfKey.size(); }
+
+	/**
+	 * @brief Bake the shapes into the bricks, only if geometry was added or CellSize changed since the last bake.
+	 */
+	void Bake() noexcept;
+
+	/**
+	 * @brief Signed distance and its gradient at a point, the gradient points away from the surfaces.
+	 * @return The signed distance, Band when no surface is near.
+	 */
+	float Sample(float x, float y, float z, float& gradientX, float& gradientY, float& gradientZ) const noexcept;
+
+	/**
+	 * @brief Push the particles closer than ParticleRadius to a surface back out and remove their velocity into it.
+	 * @param grainSize Particles processed by one job.
+	 */
+	void Resolve(FluidParticleSystem& fluids, JobSystem& jobs, std::size_t grainSize) const noexcept;
+
+private:
+	[[nodiscard]] static std::uint64_t BrickKey(int x, int y, int z) noexcept;
+
+	/**
+	 * @brief Exact distance to the baked shapes, used to fill the bricks.
+	 */
+	[[nodiscard]] float shapeDistance(float x, float y, float z) const noexcept;
+};
@@ -0,0 +1,223 @@
+#pragma once
+
+#include "Refs.h"
+
+#include <cassert>
+#include <cstdint>
+#include <vector>
+
+/**
+ * @brief Set of slot indices kept back to back for iteration, with O(1) insertion and removal.
+ * @note Removing an index moves the last one into its place, the order is not kept.
+ */
+class DenseIndexSet
+{
+private:
+	std::vector<std::uint32_t> _indices; /**< The indices of the set, back to back. */
+	std::vector<std::uint32_t> _positions; /**< Position of each index in _indices, indexed by slot. */
+
+public:
+	void Add(std::uint32_t index) noexcept
+	{
+		if (index >= _positions.size())
+		{
+			_positions.resize(index + 1);
+		}
+		_positions[index] = static_cast<std::uint32_t>(_indices.size());
+		_indices.push_back(index);
+	}
+
+	/**
+	 * @brief Remove an index, it must be in the set.
+	 */
+	void Remove(std::uint32_t index) noexcept
+	{
+		const std::uint32_t position = _positions[index];
+		const std::uint32_t last = _indices.back();
+		_indices[position] = last;
+		_positions[last] = position;
+		_indices.pop_back();
+	}
+
+	[[nodiscard]] bool Contains(std::uint32_t index) const noexcept
+	{
+		return index < _positions.size() && _positions[index] < _indices.size() && _indices[_positions[index]] == index;
+	}
+
+	void Reserve(std::size_t count) noexcept
+	{
+		_indices.reserve(count);
+		_positions.reserve(count);
+	}
+
+	void Clear() noexcept
+	{
+		_indices.clear();
+		_positions.clear();
+	}
+
+	[[nodiscard]] std::size_t Size() const noexcept { return _indices.size(); }
+
+	[[nodiscard]] const std::vector<std::uint32_t>& Indices() const noexcept { return _indices; }
+};
+
+/**
+ * @brief Storage of objects addressed by generational 32-bit handles, with O(1) creation and destruction.
+ * @note Objects stay at their slot, so a slot index is stable for as long as the object lives and can be stored
+ * in other structures. Destroyed slots go to a free list and are reused first, bumping their generation so the
+ * old handles no longer match. The free list is a queue: a slot waits for every slot freed before it, so its
+ * generation grows as slowly as possible, and a slot whose generation reached REF_GEN_MASK is retired instead
+ * of being freed, a stale handle can never address a new object. The live slots are also listed densely for
+ * iteration.
+ * @tparam T The type of the objects, reset to T{} when their slot is created.
+ * @tparam Ref The handle type, BodyRef or ColliderRef.
+ */
+template<typename T, typename Ref>
+class SlotMap
+{
+private:
+	std::vector<T> _slots; /**< Object of each slot, live or not. */
+	std::vector<std::uint32_t> _generations; /**< Current generation of each slot. */
+	std::vector<std::uint32_t> _freeSlots; /**< Destroyed slots, the ones before _freeHead were already reused. */
+	std::size_t _freeHead = 0; /**< First slot of _freeSlots to reuse, the oldest destroyed one. */
+	DenseIndexSet _active; /**< The live slots. */
+
+public:
+	/**
+	 * @brief Reserve the storage of count slots.
+	 */
+	void Reserve(std::size_t count) noexcept
+	{
+		_slots.reserve(count);
+		_generations.reserve(count);
+		_active.Reserve(count);
+	}
+
+	/**
+	 * @brief Create an object in a free slot, or in a new one if there is none.
+	 * @return The handle of the object.
+	 */
+	Ref Create() noexcept
+	{
+		std::uint32_t index;
+		if (_freeHead < _freeSlots.size())
+		{
+			index = _freeSlots[_freeHead++];
+			_slots[index] = T{};
+
+			// Drop the reused front once it is the larger half, so the queue does not grow forever
+			if (_freeHead * 2 >= _freeSlots.size())
+			{
+				_freeSlots.erase(_freeSlots.begin(), _freeSlots.begin() + static_cast<std::ptrdiff_t>(_freeHead));
+				_freeHead = 0;
+			}
+		}
+		else
+		{
+			index = static_cast<std::uint32_t>(_slots.size());
+			assert(index <= REF_INDEX_MASK && "Too many slots for the index bits of the handles");
+			_slots.emplace_back();
+			_generations.push_back(0);
+		}
+
+		_active.Add(index);
+		return Ref::Make(index, _generations[index]);
+	}
+
+	/**
+	 * @brief Create count objects at once, the storage grows once for all of them.
+	 * @param refs Receives the handles of the objects, count entries.
+	 */
+	void Create(std::size_t count, Ref* refs) noexcept
+	{
+		const std::size_t free = _freeSlots.size() - _freeHead;
+		const std::size_t reused = count < free ? count : free;
+		Reserve(_slots.size() + count - reused);
+		for (std::size_t i = 0; i < count; i++)
+		{
+			refs[i] = Create();
+		}
+	}
+
+	/**
+	 * @brief Destroy the object of a handle, the handle must be valid.
+	 * @note A slot that used its last generation is retired, it keeps its storage but is never reused.
+	 */
+	void Destroy(Ref ref) noexcept
+	{
+		const std::uint32_t index = ref.Index();
+		_active.Remove(index);
+		if (_generations[index] == REF_GEN_MASK)
+		{
+			return;
+		}
+
+		_generations[index]++;
+		_freeSlots.push_back(index);
+	}
+
+	/**
+	 * @brief Whether the handle addresses a live object.
+	 */
+	[[nodiscard]] bool Contains(Ref ref) const noexcept
+	{
+		const std::uint32_t index = ref.Index();
+		return index < _generations.size() && _generations[index] == ref.GenIndex() && _active.Contains(index);
+	}
+
+	/**
+	 * @brief Check a batch of handles once and write their slot indices, for loops using the unchecked operator[].
+	 * @param indices Receives the slot index of each handle, count entries.
+	 * @return false if a handle does not address a live object, the indices are then incomplete.
+	 */
+	[[nodiscard]] bool Resolve(const Ref* refs, std::size_t count, std::uint32_t* indices) const noexcept
+	{
+		for (std::size_t i = 0; i < count; i++)
+		{
+			if (!Contains(refs[i]))
+			{
+				return false;
+			}
+			indices[i] = refs[i].Index();
+		}
+		return true;
+	}
+
+	/**
+	 * @brief Remove every object, the storage keeps its capacity.
+	 */
+	void Clear() noexcept
+	{
+		_slots.clear();
+		_generations.clear();
+		_freeSlots.clear();
+		_freeHead = 0;
+		_active.Clear();
+	}
+
+	/**
+	 * @brief Number of live objects.
+	 */
+	[[nodiscard]] std::size_t Size() const noexcept { return _active.Size(); }
+
+	/**
+	 * @brief Object of a slot, without checking the generation.
+	 */
+	[[nodiscard]] T& operator[](std::uint32_t index) noexcept { return _slots[index]; }
+	[[nodiscard]] const T& operator[](std::uint32_t index) const noexcept { return _slots[index]; }
+
+	/**
+	 * @brief Current handle of a live slot.
+	 */
+	[[nodiscard]] Ref RefAt(std::uint32_t index) const noexcept { return Ref::Make(index, _generations[index]); }
+
+	/**
+	 * @brief Indices of the live slots, in no particular order.
+	 */
+	[[nodiscard]] const std::vector<std::uint32_t>& Active() const noexcept { return _active.Indices(); }
+
+	/**
+	 * @brief Objects of every slot, indexed by slot, the destroyed ones included.
+	 */
+	[[nodiscard]] std::vector<T>& Slots() noexcept { return _slots; }
+};
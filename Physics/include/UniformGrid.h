@@ -0,0 +1,176 @@
+#pragma once
+
+#include "CountingSort.h"
+#include "JobSystem.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <vector>
+
+/**
+ * @brief Cell-linked uniform grid rebuilt every step with a counting sort.
+ * @note Cells are mapped to a power of two table with a spatial hash, particles are sorted by table slot so
+ * the particles of a slot are contiguous in SortedIndices[CellStart[slot], CellEnd[slot]), in increasing order.
+ * Building the grid is linear in the particle count, runs on the job system (see CountingSort) and does not
+ * allocate once the arrays reached their size.
+ */
+class UniformGrid
+{
+public:
+	static constexpr float MAX_CELL_COORD = 1 << 30; /**< Cell coordinates are clamped to it, non-finite positions get it. */
+
+	std::vector<std::uint32_t> CellStart; /**< First sorted particle of each table slot. */
+	std::vector<std::uint32_t> CellEnd; /**< One past the last sorted particle of each table slot. */
+	std::vector<std::uint32_t> SortedIndices; /**< Particle indices sorted by table slot. */
+	std::vector<std::uint32_t> ParticleSlots; /**< Table slot of each particle. */
+
+private:
+	float _cellSize = 1.f;
+	float _invCellSize = 1.f;
+	std::uint32_t _tableMask = 0;
+	CountingSort _sort; /**< Sorts the particles by slot. */
+
+public:
+	/**
+	 * @brief Bucket the particles by cell.
+	 * @param x The x position of each particle.
+	 * @param y The y position of each particle.
+	 * @param z The z position of each particle.
+	 * @param count The number of particles.
+	 * @param cellSize The size of a cell, usually the interaction radius.
+	 * @param jobs The job system running the passes.
+	 */
+	void Build(const float* x, const float* y, const float* z, std::size_t count, float cellSize, JobSystem& jobs) noexcept;
+
+	/**
+	 * @brief Empty the grid, the arrays keep their capacity.
+	 */
+	void Clear() noexcept;
+
+	[[nodiscard]] float CellSize() const noexcept { return _cellSize; }
+
+	[[nodiscard]] int CellCoord(float position) const noexcept { return CellCoord(position, _invCellSize); }
+
+	/**
+	 * @brief Cell coordinate of a position along an axis, for cells of size 1 / invCellSize.
+	 * @note The cast of a NaN or of a value beyond the int range is undefined, one exploding particle would then
+	 * corrupt the hash of the whole grid. Far positions are clamped and NaN goes to the last cell, where the
+	 * distance checks of the callers reject it.
+	 */
+	[[nodiscard]] static int CellCoord(float position, float invCellSize) noexcept
+	{
+		const float cell = std::floor(position * invCellSize);
+		if (std::isnan(cell))
+		{
+			return static_cast<int>(MAX_CELL_COORD);
+		}
+		return static_cast<int>(std::clamp(cell, -MAX_CELL_COORD, MAX_CELL_COORD));
+	}
+
+	[[nodiscard]] std::uint32_t Slot(int x, int y, int z) const noexcept
+	{
+		// Teschner et al. spatial hash, the large primes spread neighboring cells over the whole table
+		return ((static_cast<std::uint32_t>(x) * 73856093u) ^
+			(static_cast<std::uint32_t>(y) * 19349663u) ^
+			(static_cast<std::uint32_t>(z) * 83492791u)) & _tableMask;
+	}
+
+	/**
+	 * @brief Call func(particleIndex) for every particle stored in the 27 cells around a position.
+	 * @note Particles of other cells sharing a table slot are visited too, callers filter by distance.
+	 * @param x The x of the position.
+	 * @param y The y of the position.
+	 * @param z The z of the position.
+	 * @param func The function called for each candidate particle.
+	 */
+	template<typename Func>
+	void ForEachCandidate(float x, float y, float z, Func&& func) const noexcept
+	{
+		if (SortedIndices.empty())
+		{
+			return;
+		}
+
+		const int cellX = CellCoord(x);
+		const int cellY = CellCoord(y);
+		const int cellZ = CellCoord(z);
+
+		std::uint32_t visited[27];
+		int visitedCount = 0;
+
+		for (int dx = -1; dx <= 1; dx++)
+		{
+			for (int dy = -1; dy <= 1; dy++)
+			{
+				for (int dz = -1; dz <= 1; dz++)
+				{
+					const std::uint32_t slot = Slot(cellX + dx, cellY + dy, cellZ + dz);
+
+					// Two neighboring cells can share a slot, only walk it once
+					bool alreadyVisited = false;
+					for (int v = 0; v < visitedCount; v++)
+					{
+						if (visited[v] == slot)
+						{
+							alreadyVisited = true;
+							break;
+						}
+					}
+					if (alreadyVisited)
+					{
+						continue;
+					}
+					visited[visitedCount++] = slot;
+
+					for (std::uint32_t s = CellStart[slot]; s < CellEnd[slot]; s++)
+					{
+						func(SortedIndices[s]);
+					}
+				}
+			}
+		}
+	}
+
+	/**
+	 * @brief Call func(particleIndex, offsetX, offsetY, offsetZ) for every particle stored in the half-shell
+	 * stencil around a position: its own cell and the 13 neighboring cells that come after it.
+	 * @note Each pair of neighboring cells is visited from one of the two cells only. The offset is the one of
+	 * the stencil cell being walked, callers compare it with the cell of the candidate to reject particles of
+	 * other cells sharing a table slot, and walk the own cell (null offset) one way only.
+	 * @param x The x of the position.
+	 * @param y The y of the position.
+	 * @param z The z of the position.
+	 * @param func The function called for each candidate particle.
+	 */
+	template<typename Func>
+	void ForEachHalfShellCandidate(float x, float y, float z, Func&& func) const noexcept
+	{
+		if (SortedIndices.empty())
+		{
+			return;
+		}
+
+		const int cellX = CellCoord(x);
+		const int cellY = CellCoord(y);
+		const int cellZ = CellCoord(z);
+
+		for (int dx = 0; dx <= 1; dx++)
+		{
+			for (int dy = dx == 0 ? 0 : -1; dy <= 1; dy++)
+			{
+				for (int dz = dx == 0 && dy == 0 ? 0 : -1; dz <= 1; dz++)
+				{
+					// A slot shared by several stencil cells is walked once per cell, the caller's cell check
+					// keeps only the particles of the cell being walked so nothing is reported twice
+					const std::uint32_t slot = Slot(cellX + dx, cellY + dy, cellZ + dz);
+
+					for (std::uint32_t s = CellStart[slot]; s < CellEnd[slot]; s++)
+					{
+						func(SortedIndices[s], dx, dy, dz);
+					}
+				}
+			}
+		}
+	}
+};
@@ -0,0 +1,43 @@
+#pragma once
+
+#include "FluidParticleSystem.h"
+#include "NeighborList.h"
+#include "SPHKernels.h"
+#include "MatrixFreeSolver.h"
+#include "JobSystem.h"
+
+#include <vector>
+
+/**
+ * @brief Implicit SPH viscosity solved with a matrix-free preconditioned conjugate gradient.
+ * @note Solves (I - dt * ViscosityStrength * L) v' = v for the new velocities, L being the same neighbor
+ * Laplacian the explicit force sweep applies: (L v)_i = sum_j W_ij (v_j - v_i). The matrix is symmetric
+ * positive definite for any step, so high viscosities no longer limit the time step. The matrix is never
+ * stored, each product walks the neighbor list, and the diagonal is used as the preconditioner.
+ */
+class ViscositySolver
+{
+public:
+	SolverSettings Settings; /**< Iteration budget and tolerance of the conjugate gradient. */
+
+private:
+	MatrixFreeSolver<3> _solver; /**< Conjugate gradient over the three velocity components. */
+	std::vector<float> _diagonal; /**< Diagonal of the matrix of each particle. */
+	SolverStorage<3> _rhs; /**< Velocities before the solve. */
+
+public:
+	/**
+	 * @brief Replace the velocities of the particles with the solution of the implicit viscosity step.
+	 * @param fluids The fluid particles, their velocities are the initial guess and the right hand side.
+	 * @param neighbors The full neighbor list of the particles.
+	 * @param params The SPH parameters, ViscosityStrength scales the Laplacian.
+	 * @param jobs The job system running the passes.
+	 * @param deltaTime The time step.
+	 */
+	void Solve(FluidParticleSystem& fluids, const NeighborList& neighbors, const SPHParams& params, JobSystem& jobs, float deltaTime) noexcept;
+
+	/**
+	 * @brief Iterations and residual of the last solve.
+	 */
+	[[nodiscard]] const SolverTelemetry& GetStats() const noexcept { return _solver.GetTelemetry(); }
+};
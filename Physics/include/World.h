@@ -1,16 +1,58 @@
 #pragma once
 
 #include "Body.h"
-#include "Particle.h"
+#include "FluidParticleSystem.h"
+#include "RigidBodySystem.h"
 #include "refs.h"
 #include "Contact.h"
 #include "QuadTree.h"
+#include "UniformGrid.h"
+#include "NeighborList.h"
+#include "SPHKernels.h"
+#include "DFSPHSolver.h"
+#include "PBFSolver.h"
+#include "ViscositySolver.h"
+#include "FluidSleep.h"
+#include "BlockTimeSteps.h"
+#include "BoundaryParticles.h"
+#include "SignedDistanceField.h"
+#include "SlotMap.h"
 #include "SPH.h"
+#include "JobSystem.h"
+#include <array>
 #include <vector>
 #include <unordered_set>
 #include <unordered_map>
 #include <stdexcept>
 
+/**
+ * @brief Pressure solver of the fluid bodies.
+ */
+enum class FluidSolver
+{
+	WCSPH, /**< Weakly compressible SPH, the pressure follows the density through SPH::PressureMultiplier. */
+	DFSPH, /**< Divergence-free SPH, the pressure is solved for to keep the rest density, see DFSPHSolver. */
+	PBF, /**< Position Based Fluids, density constraints projected on the predicted positions, see PBFSolver. */
+};
+
+/**
+ * @brief Counters of the last updates, used to tune the simulation settings.
+ */
+struct SimulationStats
+{
+	std::size_t NeighborRebuilds = 0; /**< Number of times the fluid neighbor list was rebuilt since SetUp. */
+	float AverageNeighbors = 0.f; /**< Average neighbor list length of the particles updated by the last rebuild. */
+	std::size_t ParticleReorders = 0; /**< Number of times the fluid particles were sorted in Morton order since SetUp. */
+	std::size_t Substeps = 0; /**< Number of fluid substeps of the last update. */
+	float SmallestTimeStep = 0.f; /**< Shortest fluid substep of the last update. */
+	std::size_t DensityIterations = 0; /**< DFSPH constant density iterations of the last update, all substeps included. */
+	std::size_t DivergenceIterations = 0; /**< DFSPH divergence-free iterations of the last update, all substeps included. */
+	std::size_t ConstraintIterations = 0; /**< PBF constraint projections of the last update, all substeps included. */
+	std::size_t ViscosityIterations = 0; /**< Implicit viscosity conjugate gradient iterations of the last update, all substeps included. */
+	std::size_t SleepingParticles = 0; /**< Fluid particles frozen by the sleep tracking during the last update. */
+	std::size_t ParticleSteps = 0; /**< WCSPH particle density and force evaluations of the last update, all substeps included. */
+};
+
 /**
  * @brief Represents the physics world containing bodies and interactions.
  * @note This class manages the simulation of physics entities.
@@ -18,27 +60,143 @@
 
 class World {
 private:
-	std::vector<Body> _bodies; /**< A collection of all the bodies in the world. */
-	std::vector<Collider> _colliders; /**< A collection of all the colliders in the world. */
+	SlotMap<Body, BodyRef> _bodies; /**< A collection of all the bodies in the world. */
+	SlotMap<Collider, ColliderRef> _colliders; /**< A collection of all the colliders in the world. */
+	std::array<DenseIndexSet, 4> _bodiesOfType; /**< Live bodies of each BodyType, so each system only walks the bodies it updates. */
 
 	HeapAllocator _heapAlloc; /**< Allocator used to track memory usage. */
 	std::unordered_set<ColliderRefPair, ColliderRefPairHash, std::equal_to<ColliderRefPair>, StandardAllocator<ColliderRefPair>> _colRefPairs{ _heapAlloc }; /**< A set of colliderRef pairs for collision detection. */
 
 	ContactListener* _contactListener = nullptr; /**< A listener for contact events between colliders. */
 
-	std::unordered_map<BodyRef, ParticleData, BodyRefHash, std::equal_to<BodyRef>, StandardAllocator<std::pair<const BodyRef, ParticleData>>> _particlesData{ _heapAlloc }; /**< A map of particle data associated with bodies. */
-
-	SpatialHashGrid grid;
-	std::vector<BodyRef> _neighbors;
+	RigidBodySystem _rigidBodies; /**< Position, velocity, force and mass of every body slot, the bodies are views on its rows. */
+	std::vector<std::uint32_t> _boundedColliders; /**< Slots of the colliders inserted in the OctTree this step. */
+	std::vector<CuboidF> _colliderBounds; /**< Bounds of each collider in _boundedColliders, computed once per step. */
+
+	FluidParticleSystem _fluids; /**< SPH state of the FLUID bodies stored as structure of arrays, it owns their position and velocity. */
+
+	UniformGrid _grid; /**< Counting sort grid of the fluid particles, rebuilt every step. */
+	NeighborList _neighbors; /**< In-radius neighbors of the fluid particles, shared by all the SPH passes. */
+	bool _neighborsDirty = true; /**< Set when fluid particles are added or removed, forces a neighbor rebuild. */
+	std::size_t _stepsSinceReorder = 0; /**< Fluid steps since the particles were last sorted in Morton order. */
+
+	SPHParams _sphParams; /**< SPH settings and kernel constants, recomputed when a setting changes. */
+	float _measuredRestDensity = 0.f; /**< Rest density measured on the fluid while SPH::RestDensity is 0, 0 until it is measured. */
+	std::vector<float> _restDensitySamples; /**< Fluid density of each particle, scratch of the rest density measurement. */
+	const SPHKernelTable* _sphKernels = &SPHKernels::Select(SPHSmoothingKernel::Spiky); /**< Widest implementation of the kernel the CPU supports. */
+	const SPHPairKernelTable* _sphPairKernels = &SPHKernels::Pairs(SPHSmoothingKernel::Spiky); /**< Pair sweeps of the kernel. */
+	const IntegratorTable* _integrator = &Integrators::Select(); /**< Widest implementation of the integrator the CPU supports. */
+	float _previousBodyStep = 0.f; /**< Last leapfrog step of the dynamic bodies, 0 before the first one, see Integrators::KickTime. */
+	float _previousFluidStep = 0.f; /**< Last leapfrog step of the explicit fluid integration, 0 when the last step used another path. */
+
+	DFSPHSolver _dfsph; /**< Pressure solver of the DFSPH mode. */
+	PBFSolver _pbf; /**< Constraint solver of the PBF mode. */
+	ViscositySolver _viscosity; /**< Implicit viscosity solver, used when ImplicitViscosity is set. */
+	FluidSleepTracker _sleep; /**< Rest detection of the fluid cells, used when FluidSleeping is set. */
+	std::vector<CuboidF> _wakeBounds; /**< Bounds of the moving rigid bodies, they wake the fluid cells they overlap. */
+	BlockTimeStepper _blockSteps; /**< Per particle time step levels, used when BlockTimeSteps is set. */
+	BoundaryParticleSystem _boundary; /**< Static walls sampled with particles, felt by the fluid in the WCSPH sweeps and the DFSPH and PBF solves. */
+	SignedDistanceField _staticGeometry; /**< Static scenery baked into a distance field, the particles are pushed out of it after each move. */
+
+	std::vector<float> _pairBuffer; /**< Storage of the pair accumulator, PAIR_ACCUMULATOR_COLUMNS columns of one value per neighbor list entry. */
+
+	SimulationStats _stats;
+
+	JobSystem _jobSystem; /**< Workers running the parallel passes, started in SetUp. */
+	std::size_t _workerCount = 0; /**< Requested worker count, 0 uses every hardware thread. */
 public:
 	float Gravity = 500.f;
 
-	std::vector<size_t> BodyGenIndices; /**< Indices of generated bodies. */
-	std::vector<size_t> ColliderGenIndices; /**< Indices of generated colliders. */
+	/**
+	 * @brief Time integration scheme of the dynamic bodies and of the explicit WCSPH fluid step.
+	 * @note DFSPH, PBF, the implicit viscosity and the block time steps split the step around their solves and keep
+	 * semi-implicit Euler. With Leapfrog the velocities of the bodies lag half a step behind their positions, a
+	 * velocity set through Body::SetVelocity is taken as the current one and staggered by the next step.
+	 */
+	IntegratorScheme Integrator = IntegratorScheme::SemiImplicitEuler;
+
+	/**
+	 * @brief Extra distance added to the smoothing radius when building the fluid neighbor list.
+	 * @note With a positive skin the list is only rebuilt once a particle moved more than half of it, 0 rebuilds every step.
+	 */
+	float NeighborSkin = 0.f;
+
+	/**
+	 * @brief Number of fluid steps between two Morton order sorts of the fluid particle storage, 0 disables it.
+	 * @note The sort is done at the first neighbor list rebuild once the interval elapsed so it never forces an extra rebuild.
+	 */
+	std::size_t ParticleReorderInterval = 32;
+
+	/**
+	 * @brief Evaluate each fluid pair once and apply equal and opposite contributions instead of evaluating it from both sides.
+	 * @note Uses a half neighbor list built with a half-shell stencil, the contribution to the second particle of
+	 * each pair is written to its list entry and gathered through the reverse list. It halves the kernel evaluations
+	 * at the cost of a gather pass and of the scalar kernels. Like every other fluid pass, it writes each value from
+	 * one job and sums in a fixed order, so the fluid update is bitwise reproducible whatever the worker count.
+	 */
+	bool SymmetricPairs = false;
+
+	/**
+	 * @brief Smoothing kernel of the fluid, only the spiky kernel has SIMD implementations.
+	 * @note The kernels are normalised differently, SPH::TargetDensity has to be tuned for each of them. A measured
+	 * rest density follows the kernel.
+	 */
+	SPHSmoothingKernel FluidKernel = SPHSmoothingKernel::Spiky;
+
+	/**
+	 * @brief Split the fluid update into substeps short enough for the CFL conditions instead of stepping the whole frame at once.
+	 * @note Calm fluids keep a single step per frame, fast or strongly accelerated particles get more.
+	 */
+	bool AdaptiveTimeStep = true;
+
+	/**
+	 * @brief Pressure solver of the fluid.
+	 * @note DFSPH and PBF keep the fluid at the rest density of GetRestDensity, SPH::TargetDensity and
+	 * SPH::PressureMultiplier are unused and the pressure only resists compression so much longer steps stay stable. PBF replaces SPH::ViscosityStrength
+	 * with the XSPH viscosity of its solver.
+	 */
+	FluidSolver Solver = FluidSolver::WCSPH;
+
+	/**
+	 * @brief Solve the fluid viscosity implicitly after the other forces instead of adding it in the force sweep.
+	 * @note Costs a conjugate gradient solve per substep but removes the viscosity time step limit, so very viscous
+	 * fluids no longer need many substeps. Ignored by PBF, the solve walks the full neighbor list so SymmetricPairs is too.
+	 */
+	bool ImplicitViscosity = false;
+
+	/**
+	 * @brief Freeze the fluid cells that settled and skip their particles in the SPH passes.
+	 * @note Only used with WCSPH and explicit viscosity, the global solves need every particle. The pair
+	 * sweeps are not used while it is on.
+	 */
+	bool FluidSleeping = false;
+
+	/**
+	 * @brief Give each fluid particle its own step, the frame time divided by a power of two picked from its local
+	 * CFL conditions, instead of stepping every particle with the step of the fastest one.
+	 * @note Only used with WCSPH, explicit viscosity and the adaptive time step, the finest step is the frame time
+	 * split into MaxSubsteps rounded down to a power of two. The pair sweeps are not used while it is on.
+	 */
+	bool BlockTimeSteps = false;
+
+	/**
+	 * @brief Fraction of the smoothing radius a particle may travel in one substep, the CFL number.
+	 */
+	float CourantFactor = 0.4f;
+
+	/**
+	 * @brief Fraction of the viscosity relaxation time a substep may last.
+	 */
+	float ViscosityStepFactor = 0.5f;
+
+	/**
+	 * @brief Upper bound of the substeps of one update, the last ones are stretched to cover the frame time.
+	 */
+	std::size_t MaxSubsteps = 8;
 
 	OctTree OctTree{ _heapAlloc };/**< OctTree for collision checks */
 
-	World() noexcept = default;
+	World() noexcept;
 
 	void SetUp(int initSize = 100) noexcept;
 
@@ -48,18 +206,137 @@ public:
 
 	//bodies
 	[[nodiscard]] BodyRef CreateBody(BodyType type = BodyType::DYNAMIC) noexcept;
+
+	/**
+	 * @brief Create count bodies of the same type at once, for scene setup.
+	 * @return The references of the bodies, in creation order.
+	 */
+	[[nodiscard]] std::vector<BodyRef> CreateBodies(std::size_t count, BodyType type = BodyType::DYNAMIC) noexcept;
+
+	/**
+	 * @brief Destroy a body, its colliders must be destroyed first.
+	 */
 	void DestroyBody(const BodyRef bodyRef);
 	[[nodiscard]] Body& GetBody(const BodyRef bodyRef);
 
+	/**
+	 * @brief Change the type of a body, moving it to the list of its new type and in or out of the fluid.
+	 * @note Writing Body::Type directly leaves the body in the list of the type it was created with.
+	 */
+	void SetBodyType(const BodyRef bodyRef, BodyType type);
+
+	/**
+	 * @brief Slot indices of the live bodies of a type, in no particular order.
+	 */
+	[[nodiscard]] const std::vector<std::uint32_t>& GetBodyIndices(BodyType type) const noexcept
+	{
+		return _bodiesOfType[static_cast<std::size_t>(type)].Indices();
+	}
+
+	/**
+	 * @brief Check a batch of body references once and get their slot indices, for hot loops using BodyAt.
+	 * @throws std::runtime_error if a reference does not address a live body.
+	 */
+	[[nodiscard]] std::vector<std::uint32_t> ResolveBodies(const std::vector<BodyRef>& bodyRefs) const;
+
+	/**
+	 * @brief Body of a slot index given by ResolveBodies, without any check.
+	 */
+	[[nodiscard]] Body& BodyAt(std::uint32_t index) noexcept { return _bodies[index]; }
+
 	//coliders
 	[[nodiscard]] ColliderRef CreateCollider(const BodyRef bodyRef) noexcept;
+
+	/**
+	 * @brief Create one collider attached to each of the given bodies at once, for scene setup.
+	 * @return The references of the colliders, in the order of the bodies.
+	 */
+	[[nodiscard]] std::vector<ColliderRef> CreateColliders(const std::vector<BodyRef>& bodyRefs) noexcept;
 	[[nodiscard]] Collider& GetCollider(const ColliderRef colRef);
 	void DestroyCollider(const ColliderRef colRef);
 
+	/**
+	 * @brief Check a batch of collider references once and get their slot indices, for hot loops using ColliderAt.
+	 * @throws std::runtime_error if a reference does not address a live collider.
+	 */
+	[[nodiscard]] std::vector<std::uint32_t> ResolveColliders(const std::vector<ColliderRef>& colRefs) const;
+
+	/**
+	 * @brief Collider of a slot index given by ResolveColliders, without any check.
+	 */
+	[[nodiscard]] Collider& ColliderAt(std::uint32_t index) noexcept { return _colliders[index]; }
+
 	void SetContactListener(ContactListener* listener) {
 		_contactListener = listener;
 	}
 
+	[[nodiscard]] const SimulationStats& GetStats() const noexcept { return _stats; }
+
+	/**
+	 * @brief Settings of the DFSPH solver: iteration budgets, error targets and warm starting.
+	 */
+	[[nodiscard]] DFSPHSolver& GetDFSPHSolver() noexcept { return _dfsph; }
+
+	/**
+	 * @brief Settings of the PBF solver: iterations, relaxation, artificial pressure and XSPH viscosity.
+	 */
+	[[nodiscard]] PBFSolver& GetPBFSolver() noexcept { return _pbf; }
+
+	/**
+	 * @brief Settings of the implicit viscosity solver: iteration budget and tolerance.
+	 */
+	[[nodiscard]] ViscositySolver& GetViscositySolver() noexcept { return _viscosity; }
+
+	/**
+	 * @brief Settings of the fluid sleep tracking: speed and density thresholds and the frames before sleeping.
+	 */
+	[[nodiscard]] FluidSleepTracker& GetFluidSleep() noexcept { return _sleep; }
+
+	/**
+	 * @brief Mass weighted rest density of the DFSPH and PBF solvers.
+	 * @note SPH::RestDensity, or when it is 0 the density the fluid had the first time one of these solvers stepped
+	 * it, measured again when particles are added or removed or an SPH setting changes. 0 until then.
+	 */
+	[[nodiscard]] float GetRestDensity() const noexcept { return _sphParams.RestDensity; }
+
+	/**
+	 * @brief Static boundary of the fluid, sample the walls once with it instead of keeping the particles in by hand.
+	 * @note Every solver reads it, see BoundaryParticleSystem.
+	 */
+	[[nodiscard]] BoundaryParticleSystem& GetBoundaryParticles() noexcept { return _boundary; }
+
+	/**
+	 * @brief State of the fluid particles, addressed with ParticleOf of the body slot index.
+	 * @note The columns own the state of a FLUID body: its position, velocity and mass are read from its row when
+	 * the particle is created, and written back when the body stops being a fluid. The Body of a particle reads
+	 * and writes the columns, a loop over many particles should use them directly. A force goes in the external
+	 * force columns and lasts for the next update.
+	 */
+	[[nodiscard]] FluidParticleSystem& GetFluidParticles() noexcept { return _fluids; }
+
+	/**
+	 * @brief Static geometry of the fluid, baked at the next update after shapes are added.
+	 * @note Every solver reads it, the particles are projected out of the surfaces after each position update.
+	 */
+	[[nodiscard]] SignedDistanceField& GetStaticGeometry() noexcept { return _staticGeometry; }
+
+	/**
+	 * @brief Name of the instruction set used by the SPH kernels, picked at runtime.
+	 */
+	[[nodiscard]] const char* GetSPHKernelName() const noexcept { return _sphKernels->Name; }
+
+	/**
+	 * @brief Name of the instruction set used by the integrator, picked at runtime.
+	 */
+	[[nodiscard]] const char* GetIntegratorName() const noexcept { return _integrator->Name; }
+
+	/**
+	 * @brief Set the number of threads running the parallel passes, the calling thread included.
+	 * @param workerCount The number of threads, 0 uses every hardware thread and 1 runs single-threaded.
+	 */
+	void SetWorkerCount(std::size_t workerCount) noexcept;
+	[[nodiscard]] std::size_t GetWorkerCount() const noexcept { return _jobSystem.WorkerCount(); }
+
 private:
 
 	void UpdateBodies(const float deltaTime) noexcept;
@@ -68,104 +345,167 @@ private:
 
 	void UpdateOctTreeCollisions(const BVHNode& node) noexcept;
 
+	/**
+	 * @brief Whether two colliders intersect, the bodies of both must be live as they are read unchecked.
+	 */
 	[[nodiscard]] bool Overlap(const Collider& colA, const Collider& colB) noexcept;
 
 	void UpdateGlobalCollisions() noexcept; //old code unused
 
-	float SmoothingKernel(float radius, float distance);
-	float SmoothingKernelDerivative(float radius, float distance);
 	float ViscosityKernelLaplacian(float h, float r)
 	{
 		if (r >= h) return 0.0f;
 		return 45.0f / (XM_PI * pow(h, 6)) * (h - r); // this is the standard Laplacian of viscosity kernel
 	}
 
-
-	XMVECTOR ProcessDensity(BodyRef bodyref);
 	float ConvertDensityToPressure(float density);
 	float ConvertNearDensityToPressure(float nearDensity);
-	XMVECTOR ProcessPressureForce(BodyRef bodyref);
 	float CalculateSharedPressure(float density1, float density2);
 	float CalculateSharedNearPressure(float density1, float density2);
-	XMVECTOR ProcessViscosityForce(BodyRef bodyref);
-
-	void updateGrid() {
-#ifdef TRACY_ENABLE
-		ZoneScoped;
-#endif
-		grid.clear();
-		for (auto& [ref, data] : _particlesData) {
-			grid.insertParticle(ref, data.Position = GetBody(ref).Position);
-		}
-	}
-
-	void computeNeighborsDensity() {
-#ifdef TRACY_ENABLE
-		ZoneScoped;
-#endif
-		for (auto& [ref, data] : _particlesData) {
-			std::vector<BodyRef> neighbors = grid.findNeighbors(data.Position);
-
-			float density = 0;
-
-			for (auto& otherRef : neighbors)
-			{
-				float distance = XMVectorGetX(XMVector3Length(XMVectorSubtract(GetBody(ref).Position, GetBody(otherRef).Position)));
-				float influence = SmoothingKernel(SPH::SmoothingRadius, distance);
-				density += influence;
-			}
-			data.Density = density;
-		}
-	}
-	void computeNeighborsPressure() {
-#ifdef TRACY_ENABLE
-		ZoneScoped;
-#endif
-		for (auto& [ref, data] : _particlesData) {
-			std::vector<BodyRef> neighbors = grid.findNeighbors(data.Position);
-
-			XMVECTOR pressureForce = XMVectorZero();
-
-			for (auto& otherRef : neighbors)
-			{
-				if (ref == otherRef) continue;
-				auto& otherParticle = GetBody(otherRef);
-				XMVECTOR offset = XMVectorSubtract(GetBody(ref).Position, otherParticle.Position);
-				float distance = XMVectorGetX(XMVector3Length(offset));
-				XMVECTOR direction = distance == 0 ? g_XMIdentityR1 : offset / distance;
-				float slope = SmoothingKernelDerivative(SPH::SmoothingRadius, distance);
-				float density = _particlesData.at(otherRef).Density;
-				float sharedPressure = CalculateSharedPressure(density, data.Density);
-				pressureForce += sharedPressure * direction * slope * otherParticle.Mass / density;
-			}
-			GetBody(ref).ApplyForce(pressureForce / data.Density);
-		}
-	}
-	void computeNeighborsViscosity() {
-#ifdef TRACY_ENABLE
-		ZoneScoped;
-#endif
-		for (auto& [ref, data] : _particlesData) {
-			std::vector<BodyRef> neighbors = grid.findNeighbors(data.Position);
-
-			auto& thisParticle = GetBody(ref);
-			XMVECTOR viscosityForce = XMVectorZero();
-
-			for (auto& otherRef : neighbors)
-			{
-				if (ref == otherRef) continue;
-				auto& otherParticle = GetBody(otherRef);
 
-				XMVECTOR r = thisParticle.Position - otherParticle.Position;
-				float distance = XMVectorGetX(XMVector3Length(r));
-
-				if (distance > SPH::SmoothingRadius) continue;
-
-				float influence = SmoothingKernel(SPH::SmoothingRadius, distance);
-				viscosityForce += (otherParticle.Velocity - thisParticle.Velocity) * influence * thisParticle.Mass;
-
-			}
-			GetBody(ref).ApplyForce(viscosityForce * SPH::ViscosityStrength);
-		}
-	}
+	/**
+	 * @brief Run the SPH step on the fluid particles: load the new ones, compute the density, pressure
+	 * and viscosity forces and integrate them in the fluid columns, then clear their external forces.
+	 * @param deltaTime The time step.
+	 */
+	void UpdateFluids(const float deltaTime) noexcept;
+
+	void updateGrid(float cellSize) noexcept;
+
+	/**
+	 * @brief Build the CSR neighbor list of the fluid particles from the grid, once per step or only when
+	 * a particle moved more than half of the NeighborSkin since the last build.
+	 */
+	void updateNeighbors() noexcept;
+
+	/**
+	 * @brief Rebuild the SPH parameter block and pick the kernel implementations if a setting changed.
+	 */
+	void updateSPHParams() noexcept;
+
+	/**
+	 * @brief Set the rest density of the SPH parameters, measuring it on the fluid if SPH::RestDensity is 0 and it
+	 * was not measured yet.
+	 * @note The measurement is the 90th percentile of the fluid densities, the particles of the surface miss
+	 * neighbors and a few overlapping ones are far above the bulk. Needs the full neighbor list.
+	 */
+	void updateRestDensity() noexcept;
+
+	/**
+	 * @brief Longest fluid time step satisfying the velocity, acceleration and viscosity CFL conditions.
+	 * @note Reads the densities and the forces accumulated by the passes of the current substep.
+	 */
+	[[nodiscard]] float stableTimeStep() const noexcept;
+
+	/**
+	 * @brief Length of the next fluid substep, the whole remaining time when the adaptive time step is disabled.
+	 * @param remainingTime The part of the update not simulated yet.
+	 * @param substeps The substeps already done in this update.
+	 */
+	[[nodiscard]] float nextSubstep(float remainingTime, std::size_t substeps) const noexcept;
+
+	/**
+	 * @brief Whether the current settings use the half neighbor list and the pair sweeps.
+	 */
+	[[nodiscard]] bool usesSymmetricPairs() const noexcept;
+
+	/**
+	 * @brief Bind a created body to its row of the rigid body system and enable it.
+	 */
+	void bindBody(std::uint32_t index, BodyType type) noexcept;
+
+	/**
+	 * @brief Add a live body to the list of a type, and to the fluid particles for FLUID.
+	 */
+	void listBody(std::uint32_t index, BodyType type) noexcept;
+
+	/**
+	 * @brief Remove a body from the list of its type, and from the fluid particles if it is listed as FLUID.
+	 */
+	void unlistBody(std::uint32_t index) noexcept;
+
+	/**
+	 * @brief Whether the current settings let fluid cells sleep.
+	 */
+	[[nodiscard]] bool usesFluidSleeping() const noexcept;
+
+	/**
+	 * @brief Whether the current settings step the fluid particles with their own time step levels.
+	 */
+	[[nodiscard]] bool usesBlockTimeSteps() const noexcept;
+
+	/**
+	 * @brief Run the WCSPH update of a frame with the block time steps, one tick per step start of a used level.
+	 * @param deltaTime The time step.
+	 * @return The number of ticks processed.
+	 */
+	std::size_t stepBlockTimeSteps(float deltaTime) noexcept;
+
+	/**
+	 * @brief Gather the particles the SPH passes run on at this step: the awake ones, and with the block time
+	 * steps only those starting a step. Done again after every reorder of the particles.
+	 */
+	void selectActiveParticles() noexcept;
+
+	/**
+	 * @brief Call func(first, last) in parallel on ranges covering the particles picked by selectActiveParticles.
+	 */
+	template<typename Func>
+	void forEachActiveChunk(Func&& func) noexcept;
+
+	/**
+	 * @brief Call func(first, last) in parallel on ranges covering every fluid particle.
+	 */
+	template<typename Func>
+	void forEachFluidChunk(Func&& func) noexcept;
+
+	/**
+	 * @brief Semi-implicit Euler kick of every fluid particle, the forces are reset to the external ones.
+	 */
+	void integrateFluidVelocities(float deltaTime) noexcept;
+
+	/**
+	 * @brief Move every fluid particle with its velocity.
+	 */
+	void integrateFluidPositions(float deltaTime) noexcept;
+
+	/**
+	 * @brief Update the sleep state of the fluid cells, the moving rigid bodies wake the cells they overlap.
+	 */
+	void updateFluidSleep() noexcept;
+
+	/**
+	 * @brief SPH parameters of the force sweeps, without viscosity when it is solved implicitly.
+	 */
+	[[nodiscard]] SPHParams forceParams() const noexcept;
+
+	/**
+	 * @brief Run the implicit viscosity solve on the current velocities and add its iterations to the stats.
+	 * @param deltaTime The time step.
+	 */
+	void solveViscosity(float deltaTime) noexcept;
+
+	[[nodiscard]] SPHParticleColumns fluidColumns() noexcept;
+
+	/**
+	 * @brief First sweep over the neighbors: density, near density and pressure.
+	 */
+	void computeNeighborsDensity() noexcept;
+
+	/**
+	 * @brief Second sweep over the neighbors: pressure and viscosity forces together.
+	 */
+	void computeNeighborsForces() noexcept;
+
+	/**
+	 * @brief Size the pair accumulator for the current neighbor list, see SPHPairAccumulator.
+	 */
+	[[nodiscard]] SPHPairAccumulator pairAccumulator() noexcept;
+
+	void computePairsDensity() noexcept;
+
+	/**
+	 * @brief Pressure and viscosity forces evaluated once per pair of the half neighbor list.
+	 */
+	void computePairsForces() noexcept;
 };
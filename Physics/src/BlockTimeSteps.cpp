@@ -0,0 +1,187 @@
+#include "BlockTimeSteps.h"
+
+#include <algorithm>
+#include <cmath>
+
+#ifdef TRACY_ENABLE
+#include <Tracy.hpp>
+#include <TracyC.h>
+#endif
+
+void BlockTimeStepper::Attach(FluidParticleSystem& fluids) noexcept
+{
+	fluids.Attach(_timeStepLevels);
+}
+
+void BlockTimeStepper::Begin(float frameStep, std::uint32_t maxLevel) noexcept
+{
+	_frameStep = frameStep;
+	_maxLevel = maxLevel;
+	_tick = 0;
+	_finestLevel = 0;
+	_evaluations = 0;
+}
+
+void BlockTimeStepper::SelectActive(const FluidParticleSystem& fluids, const FluidSleepTracker& sleep, std::size_t grainSize) noexcept
+{
+#ifdef TRACY_ENABLE
+	ZoneScoped;
+#endif
+	const auto count = static_cast<std::uint32_t>(fluids.Size());
+	_inactive.resize(count);
+	_levels.resize(count);
+	_activeChunks.clear();
+	_activeParticles = 0;
+
+	// Every particle starts a step at the first tick, whatever level it had at the end of the last frame
+	const std::vector<std::uint32_t>& asleep = sleep.Asleep();
+	for (std::uint32_t i = 0; i < count; i++)
+	{
+		const bool active = asleep[i] == 0 && (_tick == 0 || _tick % period(_timeStepLevels[i]) == 0);
+		_inactive[i] = active ? 0 : 1;
+	}
+
+	std::uint32_t i = 0;
+	while (i < count)
+	{
+		if (_inactive[i] != 0)
+		{
+			i++;
+			continue;
+		}
+
+		const std::uint32_t first = i;
+		while (i < count && _inactive[i] == 0 && i - first < grainSize)
+		{
+			i++;
+		}
+		_activeChunks.emplace_back(first, i);
+		_activeParticles += i - first;
+	}
+}
+
+void BlockTimeStepper::Kick(FluidParticleSystem& fluids, const NeighborList& neighbors, const FluidSleepTracker& sleep,
+	const Limits& limits, JobSystem& jobs) noexcept
+{
+#ifdef TRACY_ENABLE
+	ZoneScoped;
+#endif
+	_evaluations += _activeParticles;
+
+	// Level of the local CFL conditions of each active particle
+	ForEachActiveChunk(jobs, [&](const std::size_t first, const std::size_t last)
+	{
+		for (std::size_t i = first; i < last; i++)
+		{
+			float step = _frameStep;
+
+			const float speed = std::sqrt(fluids.VelocityX[i] * fluids.VelocityX[i] + fluids.VelocityY[i] * fluids.VelocityY[i] +
+				fluids.VelocityZ[i] * fluids.VelocityZ[i]);
+			if (speed > 0.f)
+			{
+				step = std::min(step, limits.CourantFactor * limits.SmoothingRadius / speed);
+			}
+
+			const float invMass = fluids.InvMass[i];
+			const float accelerationX = fluids.ForceX[i] * invMass;
+			const float accelerationY = (fluids.ForceY[i] - limits.Gravity) * invMass;
+			const float accelerationZ = fluids.ForceZ[i] * invMass;
+			const float acceleration = std::sqrt(accelerationX * accelerationX + accelerationY * accelerationY + accelerationZ * accelerationZ);
+			if (acceleration > 0.f)
+			{
+				step = std::min(step, limits.CourantFactor * std::sqrt(limits.SmoothingRadius / acceleration));
+			}
+
+			const float viscosityRate = limits.ViscosityStrength * fluids.Density[i];
+			if (viscosityRate > 0.f)
+			{
+				step = std::min(step, limits.ViscosityStepFactor / viscosityRate);
+			}
+
+			std::uint32_t level = 0;
+			while (level < _maxLevel && LevelStep(level) > step)
+			{
+				level++;
+			}
+			_levels[i] = level;
+		}
+	});
+
+	// Limit the level to one coarser than the neighbors, align it with the tick and kick. Only the level of the
+	// particle itself is written, the neighbors read the picked level of the active particles
+	const std::vector<std::uint32_t>& asleep = sleep.Asleep();
+	ForEachActiveChunk(jobs, [&](const std::size_t first, const std::size_t last)
+	{
+		for (std::size_t i = first; i < last; i++)
+		{
+			std::uint32_t level = _levels[i];
+			for (const std::uint32_t* it = neighbors.begin(i); it != neighbors.end(i); ++it)
+			{
+				const std::uint32_t j = *it;
+				if (asleep[j] != 0)
+				{
+					continue;
+				}
+
+				const std::uint32_t neighborLevel = _inactive[j] == 0 ? _levels[j] : _timeStepLevels[j];
+				level = std::max(level, neighborLevel > 0 ? neighborLevel - 1 : 0);
+			}
+
+			while (_tick % period(level) != 0)
+			{
+				level++;
+			}
+			_timeStepLevels[i] = level;
+
+			const float step = LevelStep(level);
+			const float invMass = fluids.InvMass[i];
+
+			fluids.VelocityX[i] += fluids.ForceX[i] * invMass * step;
+			fluids.VelocityY[i] += (fluids.ForceY[i] - limits.Gravity) * invMass * step;
+			fluids.VelocityZ[i] += fluids.ForceZ[i] * invMass * step;
+
+			fluids.ForceX[i] = fluids.ExternalForceX[i];
+			fluids.ForceY[i] = fluids.ExternalForceY[i];
+			fluids.ForceZ[i] = fluids.ExternalForceZ[i];
+		}
+	});
+}
+
+float BlockTimeStepper::Drift(FluidParticleSystem& fluids, const FluidSleepTracker& sleep, const IntegratorTable& integrator,
+	JobSystem& jobs, std::size_t grainSize) noexcept
+{
+#ifdef TRACY_ENABLE
+	ZoneScoped;
+#endif
+	const std::vector<std::uint32_t>& asleep = sleep.Asleep();
+	std::uint32_t usedLevels = 0;
+	for (std::size_t i = 0; i < fluids.Size(); i++)
+	{
+		if (asleep[i] == 0)
+		{
+			usedLevels |= 1u << _timeStepLevels[i];
+		}
+	}
+
+	// The next tick is the first one starting the step of a used level
+	std::uint32_t next = TickCount();
+	for (std::uint32_t level = 0; level <= _maxLevel; level++)
+	{
+		if ((usedLevels & (1u << level)) == 0)
+		{
+			continue;
+		}
+
+		const std::uint32_t levelPeriod = period(level);
+		next = std::min(next, (_tick / levelPeriod + 1) * levelPeriod);
+		_finestLevel = std::max(_finestLevel, level);
+	}
+
+	const float step = static_cast<float>(next - _tick) * LevelStep(_maxLevel);
+	jobs.ParallelForChunks(0, fluids.Size(), grainSize, [&](const std::size_t first, const std::size_t last)
+	{
+		fluids.IntegratePositions(integrator, step, first, last);
+	});
+	_tick = next;
+	return step;
+}
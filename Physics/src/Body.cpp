@@ -2,5 +2,10 @@
 
 void Body::ApplyForce(const XMVECTOR &force) noexcept
 {
-    _force = XMVectorAdd(_force, force);
-}
\ No newline at end of file
+    if (_type == BodyType::FLUID)
+    {
+        _fluids->AddExternalForce(particle(), force);
+        return;
+    }
+    _system->AddForce(_slot, force);
+}
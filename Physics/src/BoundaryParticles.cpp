@@ -0,0 +1,228 @@
+#include "BoundaryParticles.h"
+#include "SPHKernelPolicies.h"
+
+#include <algorithm>
+#include <cmath>
+
+#ifdef TRACY_ENABLE
+#include <Tracy.hpp>
+#include <TracyC.h>
+#endif
+
+void BoundaryParticleSystem::Add(float x, float y, float z) noexcept
+{
+	PositionX.push_back(x);
+	PositionY.push_back(y);
+	PositionZ.push_back(z);
+	Volume.push_back(0.f);
+
+	_gridCellSize = 0.f;
+	_volumeRadius = 0.f;
+	_changed = true;
+}
+
+void BoundaryParticleSystem::SampleCuboid(const CuboidF& box, float spacing) noexcept
+{
+	const float minX = XMVectorGetX(box.MinBound()), maxX = XMVectorGetX(box.MaxBound());
+	const float minY = XMVectorGetY(box.MinBound()), maxY = XMVectorGetY(box.MaxBound());
+	const float minZ = XMVectorGetZ(box.MinBound()), maxZ = XMVectorGetZ(box.MaxBound());
+
+	// The spacing is stretched so both ends of every edge get a particle
+	auto divisions = [spacing](float size) noexcept
+	{
+		return std::max(1, static_cast<int>(std::ceil(size / spacing)));
+	};
+	const int countX = divisions(maxX - minX);
+	const int countY = divisions(maxY - minY);
+	const int countZ = divisions(maxZ - minZ);
+
+	for (int i = 0; i <= countX; i++)
+	{
+		const float x = minX + (maxX - minX) * static_cast<float>(i) / static_cast<float>(countX);
+		for (int j = 0; j <= countY; j++)
+		{
+			const float y = minY + (maxY - minY) * static_cast<float>(j) / static_cast<float>(countY);
+
+			// Inside the x and y faces only the two z faces are on the surface
+			const bool onEdge = i == 0 || i == countX || j == 0 || j == countY;
+			const int stepZ = onEdge ? 1 : countZ;
+			for (int k = 0; k <= countZ; k += stepZ)
+			{
+				Add(x, y, minZ + (maxZ - minZ) * static_cast<float>(k) / static_cast<float>(countZ));
+			}
+		}
+	}
+}
+
+void BoundaryParticleSystem::Clear() noexcept
+{
+	PositionX.clear();
+	PositionY.clear();
+	PositionZ.clear();
+	Volume.clear();
+	Offsets.clear();
+	Indices.clear();
+	_grid.Clear();
+
+	_gridCellSize = 0.f;
+	_volumeRadius = 0.f;
+	_changed = true;
+}
+
+void BoundaryParticleSystem::UpdateVolumes(const SPHParams& params, JobSystem& jobs) noexcept
+{
+#ifdef TRACY_ENABLE
+	ZoneScoped;
+#endif
+	if (_volumeRadius == params.SmoothingRadius && _volumeKernel == params.Kernel)
+	{
+		return;
+	}
+
+	// The neighbor grid may be built for a larger radius, the candidates are filtered by distance anyway
+	if (_gridCellSize < params.SmoothingRadius)
+	{
+		_grid.Build(PositionX.data(), PositionY.data(), PositionZ.data(), Size(), params.SmoothingRadius, jobs);
+		_gridCellSize = params.SmoothingRadius;
+	}
+
+	DispatchSmoothingKernel(params.Kernel, [&](auto kernel)
+	{
+		using Kernel = decltype(kernel);
+
+		jobs.ParallelFor(0, Size(), ChunkedListBuilder::GRAIN_SIZE, [&](const std::size_t b)
+		{
+			float weightSum = Kernel::Value(params, 0.f, 0.f);
+			_grid.ForEachCandidate(PositionX[b], PositionY[b], PositionZ[b], [&](const std::uint32_t k)
+			{
+				if (k == b) return;
+
+				const float dx = PositionX[b] - PositionX[k];
+				const float dy = PositionY[b] - PositionY[k];
+				const float dz = PositionZ[b] - PositionZ[k];
+				const float sqrDistance = dx * dx + dy * dy + dz * dz;
+				if (sqrDistance >= params.SqrRadius) return;
+
+				weightSum += Kernel::Value(params, std::sqrt(sqrDistance), sqrDistance);
+			});
+			Volume[b] = 1.f / weightSum;
+		});
+	});
+
+	_volumeRadius = params.SmoothingRadius;
+	_volumeKernel = params.Kernel;
+}
+
+void BoundaryParticleSystem::FindNeighbors(const float* x, const float* y, const float* z, std::size_t count, float radius,
+	JobSystem& jobs, const std::uint32_t* skip) noexcept
+{
+#ifdef TRACY_ENABLE
+	ZoneScoped;
+#endif
+	if (_gridCellSize != radius)
+	{
+		_grid.Build(PositionX.data(), PositionY.data(), PositionZ.data(), Size(), radius, jobs);
+		_gridCellSize = radius;
+	}
+
+	const float sqrRadius = radius * radius;
+
+	_builder.Build(count, jobs, Offsets, Indices, [&](const std::size_t i, std::vector<std::uint32_t>& list)
+	{
+		if (skip != nullptr && skip[i] != 0)
+		{
+			return;
+		}
+
+		_grid.ForEachCandidate(x[i], y[i], z[i], [&](const std::uint32_t b)
+		{
+			const float dx = x[i] - PositionX[b];
+			const float dy = y[i] - PositionY[b];
+			const float dz = z[i] - PositionZ[b];
+			if (dx * dx + dy * dy + dz * dz < sqrRadius)
+			{
+				list.push_back(b);
+			}
+		});
+	});
+
+	_changed = false;
+}
+
+void BoundaryParticleSystem::AddDensity(FluidParticleSystem& fluids, const SPHParams& params, std::size_t first, std::size_t last) const noexcept
+{
+	if (Indices.empty())
+	{
+		return;
+	}
+
+	DispatchSmoothingKernel(params.Kernel, [&](auto kernel)
+	{
+		using Kernel = decltype(kernel);
+
+		for (std::size_t i = first; i < last; i++)
+		{
+			float density = 0.f;
+			for (std::uint32_t n = Offsets[i]; n < Offsets[i + 1]; n++)
+			{
+				const std::uint32_t b = Indices[n];
+				const float dx = fluids.PositionX[i] - PositionX[b];
+				const float dy = fluids.PositionY[i] - PositionY[b];
+				const float dz = fluids.PositionZ[i] - PositionZ[b];
+				const float sqrDistance = dx * dx + dy * dy + dz * dz;
+				if (sqrDistance >= params.SqrRadius) continue;
+
+				density += Volume[b] * Kernel::Value(params, std::sqrt(sqrDistance), sqrDistance);
+			}
+
+			if (density == 0.f) continue;
+
+			// The boundary stands for fluid at the density of the particle, TargetDensity once the fluid is at rest
+			fluids.Density[i] += fluids.Density[i] * density;
+			fluids.Pressure[i] = (fluids.Density[i] - params.TargetDensity) * params.PressureMultiplier;
+		}
+	});
+}
+
+void BoundaryParticleSystem::AddForces(FluidParticleSystem& fluids, const SPHParams& params, std::size_t first, std::size_t last) const noexcept
+{
+	if (Indices.empty())
+	{
+		return;
+	}
+
+	DispatchSmoothingKernel(params.Kernel, [&](auto kernel)
+	{
+		using Kernel = decltype(kernel);
+
+		for (std::size_t i = first; i < last; i++)
+		{
+			// The boundary mirrors the pressure of the particle, the shared pressure of the pair is the particle's own
+			const float pressure = fluids.Pressure[i];
+			if (pressure == 0.f) continue;
+
+			float pressureX = 0.f, pressureY = 0.f, pressureZ = 0.f;
+			for (std::uint32_t n = Offsets[i]; n < Offsets[i + 1]; n++)
+			{
+				const std::uint32_t b = Indices[n];
+				const float dx = fluids.PositionX[i] - PositionX[b];
+				const float dy = fluids.PositionY[i] - PositionY[b];
+				const float dz = fluids.PositionZ[i] - PositionZ[b];
+				const float sqrDistance = dx * dx + dy * dy + dz * dz;
+				if (sqrDistance >= params.SqrRadius || sqrDistance == 0.f) continue;
+
+				// Same form as the fluid pairs, the mass over density of the neighbor is the boundary volume
+				const float distance = std::sqrt(sqrDistance);
+				const float scale = pressure * Kernel::Slope(params, distance, sqrDistance) * Volume[b] / distance;
+				pressureX += dx * scale;
+				pressureY += dy * scale;
+				pressureZ += dz * scale;
+			}
+
+			const float invDensity = 1.f / fluids.Density[i];
+			fluids.ForceX[i] += pressureX * invDensity;
+			fluids.ForceY[i] += pressureY * invDensity;
+			fluids.ForceZ[i] += pressureZ * invDensity;
+		}
+	});
+}
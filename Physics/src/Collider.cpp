@@ -1,17 +1,17 @@
 #include "Collider.h"
 
-CuboidF Collider::GetBounds() const noexcept
+CuboidF Collider::GetBounds(XMVECTOR bodyPosition) const noexcept
 {
 	switch (Shape.index())
 	{
 	case static_cast<int>(ShapeType::Sphere):
 	{
 		auto sphere = std::get<SphereF>(Shape);
-		return CuboidF::FromCenter(sphere.Center(), { sphere.Radius(), sphere.Radius(), sphere.Radius()}) + BodyPosition;
+		return CuboidF::FromCenter(sphere.Center(), { sphere.Radius(), sphere.Radius(), sphere.Radius()}) + bodyPosition;
 	}
 	case static_cast<int>(ShapeType::Cuboid):
 	{
-		return std::get<CuboidF>(Shape) + BodyPosition;
+		return std::get<CuboidF>(Shape) + bodyPosition;
 	}
 	}
 	return { XMVectorZero(), XMVectorZero() };
@@ -26,8 +26,8 @@ bool ColliderRefPair::operator==(const ColliderRefPair& other) const
 
 std::size_t ColliderRefPairHash::operator()(const ColliderRefPair& pair) const
 {
-	const std::size_t hashA = std::hash<size_t>{}(pair.ColRefA.Index);
-	const std::size_t hashB = std::hash<size_t>{}(pair.ColRefB.Index);
+	const std::size_t hashA = std::hash<std::uint32_t>{}(pair.ColRefA.Index());
+	const std::size_t hashB = std::hash<std::uint32_t>{}(pair.ColRefB.Index());
 
 	// XOR for the hash
 	return hashA ^ hashB;
@@ -12,7 +12,7 @@ void Contact::Resolve()
 		const SphereF& sphere0 = std::get<SphereF>(CollidingBodies[0].collider->Shape);
 		const SphereF& sphere1 = std::get<SphereF>(CollidingBodies[1].collider->Shape);
 
-		const auto delta = XMVectorSubtract(XMVectorSubtract(XMVectorAdd(CollidingBodies[0].body->Position, sphere0.Center()), CollidingBodies[1].body->Position), sphere1.Center());
+		const auto delta = XMVectorSubtract(XMVectorSubtract(XMVectorAdd(CollidingBodies[0].body->GetPosition(), sphere0.Center()), CollidingBodies[1].body->GetPosition()), sphere1.Center());
 
 		float length = XMVectorGetX(XMVector3Length(delta));
 
@@ -36,20 +36,20 @@ void Contact::Resolve()
 
 
 		auto closestX = Clamp(
-			XMVectorGetX(CollidingBodies[0].body->Position) + XMVectorGetX(sphere.Center()),
-			XMVectorGetX(cuboid.MinBound()) + XMVectorGetX(CollidingBodies[1].body->Position),
-			XMVectorGetX(cuboid.MaxBound()) + XMVectorGetX(CollidingBodies[1].body->Position)
+			XMVectorGetX(CollidingBodies[0].body->GetPosition()) + XMVectorGetX(sphere.Center()),
+			XMVectorGetX(cuboid.MinBound()) + XMVectorGetX(CollidingBodies[1].body->GetPosition()),
+			XMVectorGetX(cuboid.MaxBound()) + XMVectorGetX(CollidingBodies[1].body->GetPosition())
 		);
 
 		auto closestY = Clamp(
-			XMVectorGetY(CollidingBodies[0].body->Position) + XMVectorGetY(sphere.Center()),
-			XMVectorGetY(cuboid.MinBound()) + XMVectorGetY(CollidingBodies[1].body->Position),
-			XMVectorGetY(cuboid.MaxBound()) + XMVectorGetY(CollidingBodies[1].body->Position)
+			XMVectorGetY(CollidingBodies[0].body->GetPosition()) + XMVectorGetY(sphere.Center()),
+			XMVectorGetY(cuboid.MinBound()) + XMVectorGetY(CollidingBodies[1].body->GetPosition()),
+			XMVectorGetY(cuboid.MaxBound()) + XMVectorGetY(CollidingBodies[1].body->GetPosition())
 		);
 		auto closestZ = Clamp(
-			XMVectorGetZ(CollidingBodies[0].body->Position) + XMVectorGetZ(sphere.Center()),
-			XMVectorGetZ(cuboid.MinBound()) + XMVectorGetZ(CollidingBodies[1].body->Position),
-			XMVectorGetZ(cuboid.MaxBound()) + XMVectorGetZ(CollidingBodies[1].body->Position)
+			XMVectorGetZ(CollidingBodies[0].body->GetPosition()) + XMVectorGetZ(sphere.Center()),
+			XMVectorGetZ(cuboid.MinBound()) + XMVectorGetZ(CollidingBodies[1].body->GetPosition()),
+			XMVectorGetZ(cuboid.MaxBound()) + XMVectorGetZ(CollidingBodies[1].body->GetPosition())
 		);
 
 		const XMVECTOR closest = XMVectorSet(closestX, closestY, closestZ, 0);
@@ -57,7 +57,7 @@ void Contact::Resolve()
 		//const XMVECTOR delta = CollidingBodies[0].body->Position + sphere.Center() - closest;
 
 		XMVECTOR delta = XMVectorSubtract(
-			XMVectorAdd(CollidingBodies[0].body->Position, sphere.Center()),
+			XMVectorAdd(CollidingBodies[0].body->GetPosition(), sphere.Center()),
 			closest
 		);
 
@@ -72,7 +72,7 @@ void Contact::Resolve()
 		else
 		{
 			//Normal = g_XMIdentityR1;
-			Normal = -XMVector3Normalize(CollidingBodies[0].body->Velocity);
+			Normal = -XMVector3Normalize(CollidingBodies[0].body->GetVelocity());
 		}
 
 	}
@@ -96,8 +96,8 @@ void Contact::Resolve()
 		// Calculate delta vector between the centers of the two cuboids
 		const auto delta = XMVectorSubtract(
 			XMVectorSubtract(
-			XMVectorAdd(CollidingBodies[0].body->Position, cuboid0.Center()),
-			CollidingBodies[1].body->Position
+			XMVectorAdd(CollidingBodies[0].body->GetPosition(), cuboid0.Center()),
+			CollidingBodies[1].body->GetPosition()
 		),
 			cuboid1.Center()
 		);
@@ -126,7 +126,7 @@ void Contact::Resolve()
 	}
 	}
 
-	const auto mass1 = CollidingBodies[0].body->Mass, mass2 = CollidingBodies[1].body->Mass;
+	const auto mass1 = CollidingBodies[0].body->GetMass(), mass2 = CollidingBodies[1].body->GetMass();
 	const auto rest1 = CollidingBodies[0].collider->Restitution, rest2 = CollidingBodies[1].collider->Restitution;
 
 	Restitution = (mass1 * rest1 + mass2 * rest2) / (mass1 + mass2);
@@ -139,7 +139,7 @@ void Contact::Resolve()
 
 float Contact::CalculateSeparateVelocity() const noexcept
 {
-	const auto relativeVelocity = XMVectorSubtract(CollidingBodies[0].body->Velocity, CollidingBodies[1].body->Velocity);
+	const auto relativeVelocity = XMVectorSubtract(CollidingBodies[0].body->GetVelocity(), CollidingBodies[1].body->GetVelocity());
 	return XMVectorGetX(XMVector3Dot(relativeVelocity, Normal));
 	//return result; // relativeVelocity.Dot(Normal);
 }
@@ -156,8 +156,8 @@ void Contact::ResolveVelocityAndInterpenetration() const noexcept
 
 	const float deltaVelocity = newSeparatingVelocity - separatingVelocity;
 
-	const float inverseMass1 = 1.f / CollidingBodies[0].body->Mass;
-	const float inverseMass2 = 1.f / CollidingBodies[1].body->Mass;
+	const float inverseMass1 = 1.f / CollidingBodies[0].body->GetMass();
+	const float inverseMass2 = 1.f / CollidingBodies[1].body->GetMass();
 
 	const float totalInverseMass = inverseMass1 + inverseMass2;
 
@@ -168,22 +168,22 @@ void Contact::ResolveVelocityAndInterpenetration() const noexcept
 	const float impulse = deltaVelocity / totalInverseMass;
 	const auto impulsePerIMass = XMVectorScale(Normal, impulse);
 
-	if (CollidingBodies[0].body->Type == BodyType::DYNAMIC || CollidingBodies[0].body->Type == BodyType::FLUID)
+	if (CollidingBodies[0].body->GetType() == BodyType::DYNAMIC || CollidingBodies[0].body->GetType() == BodyType::FLUID)
 	{
-		CollidingBodies[0].body->Velocity = XMVectorAdd(CollidingBodies[0].body->Velocity, XMVectorScale(impulsePerIMass, inverseMass1));
+		CollidingBodies[0].body->SetVelocity(XMVectorAdd(CollidingBodies[0].body->GetVelocity(), XMVectorScale(impulsePerIMass, inverseMass1)));
 	}
-	if (CollidingBodies[1].body->Type == BodyType::DYNAMIC || CollidingBodies[1].body->Type == BodyType::FLUID)
+	if (CollidingBodies[1].body->GetType() == BodyType::DYNAMIC || CollidingBodies[1].body->GetType() == BodyType::FLUID)
 	{
-		CollidingBodies[1].body->Velocity = XMVectorSubtract(CollidingBodies[1].body->Velocity, XMVectorScale(impulsePerIMass, inverseMass2));
+		CollidingBodies[1].body->SetVelocity(XMVectorSubtract(CollidingBodies[1].body->GetVelocity(), XMVectorScale(impulsePerIMass, inverseMass2)));
 	}
 
-	if (CollidingBodies[0].body->Type == BodyType::STATIC)
+	if (CollidingBodies[0].body->GetType() == BodyType::STATIC)
 	{
-		CollidingBodies[1].body->Velocity = XMVectorSubtract(CollidingBodies[1].body->Velocity, XMVectorScale(impulsePerIMass, inverseMass1));
+		CollidingBodies[1].body->SetVelocity(XMVectorSubtract(CollidingBodies[1].body->GetVelocity(), XMVectorScale(impulsePerIMass, inverseMass1)));
 	}
-	if (CollidingBodies[1].body->Type == BodyType::STATIC)
+	if (CollidingBodies[1].body->GetType() == BodyType::STATIC)
 	{
-		CollidingBodies[0].body->Velocity = XMVectorAdd(CollidingBodies[0].body->Velocity, XMVectorScale(impulsePerIMass, inverseMass2));
+		CollidingBodies[0].body->SetVelocity(XMVectorAdd(CollidingBodies[0].body->GetVelocity(), XMVectorScale(impulsePerIMass, inverseMass2)));
 	}
 }
 
@@ -191,8 +191,8 @@ void Contact::ResolveInterpenetration() const noexcept
 {
 	if (Penetration <= 0) return;
 
-	const float inverseMass1 = 1.f / CollidingBodies[0].body->Mass;
-	const float inverseMass2 = 1.f / CollidingBodies[1].body->Mass;
+	const float inverseMass1 = 1.f / CollidingBodies[0].body->GetMass();
+	const float inverseMass2 = 1.f / CollidingBodies[1].body->GetMass();
 	const float totalInverseMass = inverseMass1 + inverseMass2;
 
 	if (totalInverseMass <= 0) {
@@ -201,14 +201,14 @@ void Contact::ResolveInterpenetration() const noexcept
 
 	const auto movePerIMass = XMVectorScale(Normal, (Penetration / totalInverseMass));
 
-	if (CollidingBodies[0].body->Type == BodyType::DYNAMIC || CollidingBodies[0].body->Type == BodyType::FLUID)
+	if (CollidingBodies[0].body->GetType() == BodyType::DYNAMIC || CollidingBodies[0].body->GetType() == BodyType::FLUID)
 	{
-		CollidingBodies[0].body->Position = XMVectorAdd(CollidingBodies[0].body->Position, XMVectorScale(movePerIMass, inverseMass1));
+		CollidingBodies[0].body->SetPosition(XMVectorAdd(CollidingBodies[0].body->GetPosition(), XMVectorScale(movePerIMass, inverseMass1)));
 	}
 
-	if (CollidingBodies[1].body->Type == BodyType::DYNAMIC || CollidingBodies[1].body->Type == BodyType::FLUID)
+	if (CollidingBodies[1].body->GetType() == BodyType::DYNAMIC || CollidingBodies[1].body->GetType() == BodyType::FLUID)
 	{
-		CollidingBodies[1].body->Position = XMVectorSubtract(CollidingBodies[1].body->Position, XMVectorScale(movePerIMass, inverseMass2));
+		CollidingBodies[1].body->SetPosition(XMVectorSubtract(CollidingBodies[1].body->GetPosition(), XMVectorScale(movePerIMass, inverseMass2)));
 	}
 }
 
@@ -0,0 +1,75 @@
+#include "CountingSort.h"
+
+#include <algorithm>
+
+#ifdef TRACY_ENABLE
+#include <Tracy.hpp>
+#include <TracyC.h>
+#endif
+
+void CountingSort::Sort(const std::uint32_t* keys, std::size_t count, std::uint32_t maxKey, JobSystem& jobs) noexcept
+{
+#ifdef TRACY_ENABLE
+	ZoneScoped;
+#endif
+	constexpr std::size_t DIGITS = std::size_t{ 1 } << RADIX_BITS;
+	constexpr std::uint32_t DIGIT_MASK = DIGITS - 1;
+
+	SortedKeys.resize(count);
+	Order.resize(count);
+	_scratchKeys.resize(count);
+	_scratchOrder.resize(count);
+
+	jobs.ParallelFor(0, count, GRAIN_SIZE, [&](const std::size_t i)
+	{
+		SortedKeys[i] = keys[i];
+		Order[i] = static_cast<std::uint32_t>(i);
+	});
+
+	const std::size_t chunks = (count + GRAIN_SIZE - 1) / GRAIN_SIZE;
+	_counts.resize(chunks * DIGITS);
+
+	for (std::uint32_t shift = 0; shift < 32 && (maxKey >> shift) != 0; shift += RADIX_BITS)
+	{
+		jobs.ParallelFor(0, chunks, 1, [&](const std::size_t chunk)
+		{
+			const std::size_t first = chunk * GRAIN_SIZE;
+			const std::size_t last = std::min(first + GRAIN_SIZE, count);
+			std::uint32_t* counts = _counts.data() + chunk * DIGITS;
+			std::fill(counts, counts + DIGITS, 0u);
+			for (std::size_t i = first; i < last; i++)
+			{
+				counts[(SortedKeys[i] >> shift) & DIGIT_MASK]++;
+			}
+		});
+
+		// Digit major, then chunk order: the keys of a digit are written chunk after chunk, which keeps the pass stable
+		std::uint32_t offset = 0;
+		for (std::size_t digit = 0; digit < DIGITS; digit++)
+		{
+			for (std::size_t chunk = 0; chunk < chunks; chunk++)
+			{
+				std::uint32_t& counter = _counts[chunk * DIGITS + digit];
+				const std::uint32_t chunkCount = counter;
+				counter = offset;
+				offset += chunkCount;
+			}
+		}
+
+		jobs.ParallelFor(0, chunks, 1, [&](const std::size_t chunk)
+		{
+			const std::size_t first = chunk * GRAIN_SIZE;
+			const std::size_t last = std::min(first + GRAIN_SIZE, count);
+			std::uint32_t* cursors = _counts.data() + chunk * DIGITS;
+			for (std::size_t i = first; i < last; i++)
+			{
+				const std::uint32_t destination = cursors[(SortedKeys[i] >> shift) & DIGIT_MASK]++;
+				_scratchKeys[destination] = SortedKeys[i];
+				_scratchOrder[destination] = Order[i];
+			}
+		});
+
+		SortedKeys.swap(_scratchKeys);
+		Order.swap(_scratchOrder);
+	}
+}
@@ -0,0 +1,340 @@
+#include "DFSPHSolver.h"
+#include "SPHKernelPolicies.h"
+
+#include <algorithm>
+#include <cmath>
+
+#ifdef TRACY_ENABLE
+#include <Tracy.hpp>
+#include <TracyC.h>
+#endif
+
+namespace
+{
+	constexpr std::size_t GRAIN_SIZE = 128; /**< Particles processed by one job of the solver passes. */
+
+	/**
+	 * @brief Call func(j, gradX, gradY, gradZ) with the kernel gradient at particle i of each in-radius neighbor j.
+	 */
+	template<typename Kernel, typename Func>
+	void ForEachGradient(const FluidParticleSystem& f, const NeighborList& neighbors, const SPHParams& k, std::size_t i, Func&& func) noexcept
+	{
+		for (const std::uint32_t* it = neighbors.begin(i); it != neighbors.end(i); ++it)
+		{
+			const std::uint32_t j = *it;
+			const float dx = f.PositionX[i] - f.PositionX[j];
+			const float dy = f.PositionY[i] - f.PositionY[j];
+			const float dz = f.PositionZ[i] - f.PositionZ[j];
+			const float sqrDistance = dx * dx + dy * dy + dz * dz;
+			if (sqrDistance >= k.SqrRadius || sqrDistance == 0.f) continue;
+
+			const float distance = std::sqrt(sqrDistance);
+			const float scale = Kernel::Slope(k, distance, sqrDistance) / distance;
+			func(j, dx * scale, dy * scale, dz * scale);
+		}
+	}
+
+	/**
+	 * @brief Call func(mass, gradX, gradY, gradZ) with the mass psi_b = rho_0 V_b of each in-radius boundary particle
+	 * b of particle i and the kernel gradient at i.
+	 */
+	template<typename Kernel, typename Func>
+	void ForEachBoundaryGradient(const FluidParticleSystem& f, const BoundaryParticleSystem& boundary, const SPHParams& k,
+		std::size_t i, Func&& func) noexcept
+	{
+		boundary.ForEachInRadius(i, f.PositionX[i], f.PositionY[i], f.PositionZ[i], k, [&](std::uint32_t b,
+			float dx, float dy, float dz, float sqrDistance)
+		{
+			const float distance = std::sqrt(sqrDistance);
+			const float scale = Kernel::Slope(k, distance, sqrDistance) / distance;
+			func(k.RestDensity * boundary.Volume[b], dx * scale, dy * scale, dz * scale);
+		});
+	}
+
+	/**
+	 * @brief Rate of change of the density of particle i caused by the current velocities, positive when compressing.
+	 * @note The boundary does not move, only the velocity of i counts toward it.
+	 */
+	template<typename Kernel>
+	float DensityChangeRate(const FluidParticleSystem& f, const NeighborList& neighbors, const BoundaryParticleSystem& boundary,
+		const SPHParams& k, std::size_t i) noexcept
+	{
+		float rate = 0.f;
+		ForEachGradient<Kernel>(f, neighbors, k, i, [&](std::uint32_t j, float gradX, float gradY, float gradZ)
+		{
+			rate += f.Mass[j] * ((f.VelocityX[i] - f.VelocityX[j]) * gradX +
+				(f.VelocityY[i] - f.VelocityY[j]) * gradY +
+				(f.VelocityZ[i] - f.VelocityZ[j]) * gradZ);
+		});
+		ForEachBoundaryGradient<Kernel>(f, boundary, k, i, [&](float mass, float gradX, float gradY, float gradZ)
+		{
+			rate += mass * (f.VelocityX[i] * gradX + f.VelocityY[i] * gradY + f.VelocityZ[i] * gradZ);
+		});
+		return rate;
+	}
+
+	/**
+	 * @brief Apply the pressure acceleration of the stiffnesses to the velocity of particle i.
+	 */
+	template<typename Kernel>
+	void ApplyStiffness(FluidParticleSystem& f, const NeighborList& neighbors, const BoundaryParticleSystem& boundary,
+		const SPHParams& k, const float* stiffness, std::size_t i, float deltaTime) noexcept
+	{
+		float deltaX = 0.f, deltaY = 0.f, deltaZ = 0.f;
+		ForEachGradient<Kernel>(f, neighbors, k, i, [&](std::uint32_t j, float gradX, float gradY, float gradZ)
+		{
+			const float scale = f.Mass[j] * (stiffness[i] + stiffness[j]);
+			deltaX += scale * gradX;
+			deltaY += scale * gradY;
+			deltaZ += scale * gradZ;
+		});
+		// The boundary particles have no stiffness of their own, they push back with the one of i
+		ForEachBoundaryGradient<Kernel>(f, boundary, k, i, [&](float mass, float gradX, float gradY, float gradZ)
+		{
+			const float scale = mass * stiffness[i];
+			deltaX += scale * gradX;
+			deltaY += scale * gradY;
+			deltaZ += scale * gradZ;
+		});
+
+		f.VelocityX[i] -= deltaTime * deltaX;
+		f.VelocityY[i] -= deltaTime * deltaY;
+		f.VelocityZ[i] -= deltaTime * deltaZ;
+	}
+}
+
+void DFSPHSolver::Attach(FluidParticleSystem& fluids) noexcept
+{
+	fluids.Attach(_densityStiffness);
+	fluids.Attach(_divergenceStiffness);
+}
+
+void DFSPHSolver::ComputeDensities(FluidParticleSystem& fluids, const NeighborList& neighbors, const BoundaryParticleSystem& boundary,
+	const SPHParams& params, JobSystem& jobs) noexcept
+{
+#ifdef TRACY_ENABLE
+	ZoneScoped;
+#endif
+	_factors.resize(fluids.Size());
+
+	DispatchSmoothingKernel(params.Kernel, [&](auto kernel)
+	{
+		using Kernel = decltype(kernel);
+
+		jobs.ParallelFor(0, fluids.Size(), GRAIN_SIZE, [&](const std::size_t i)
+		{
+			float density = fluids.Mass[i] * params.SelfDensity;
+			for (const std::uint32_t* it = neighbors.begin(i); it != neighbors.end(i); ++it)
+			{
+				const std::uint32_t j = *it;
+				const float dx = fluids.PositionX[i] - fluids.PositionX[j];
+				const float dy = fluids.PositionY[i] - fluids.PositionY[j];
+				const float dz = fluids.PositionZ[i] - fluids.PositionZ[j];
+				const float sqrDistance = dx * dx + dy * dy + dz * dz;
+				if (sqrDistance >= params.SqrRadius) continue;
+
+				density += fluids.Mass[j] * Kernel::Value(params, std::sqrt(sqrDistance), sqrDistance);
+			}
+
+			// alpha_i = 1 / (|sum m_j grad W_ij|^2 + sum |m_j grad W_ij|^2)
+			float sumX = 0.f, sumY = 0.f, sumZ = 0.f, sumSqr = 0.f;
+			ForEachGradient<Kernel>(fluids, neighbors, params, i, [&](std::uint32_t j, float gradX, float gradY, float gradZ)
+			{
+				const float mass = fluids.Mass[j];
+				sumX += mass * gradX;
+				sumY += mass * gradY;
+				sumZ += mass * gradZ;
+				sumSqr += mass * mass * (gradX * gradX + gradY * gradY + gradZ * gradZ);
+			});
+			// The boundary adds to the density and to the gradient of i, its own particles never move
+			ForEachBoundaryGradient<Kernel>(fluids, boundary, params, i, [&](float mass, float gradX, float gradY, float gradZ)
+			{
+				sumX += mass * gradX;
+				sumY += mass * gradY;
+				sumZ += mass * gradZ;
+			});
+			boundary.ForEachInRadius(i, fluids.PositionX[i], fluids.PositionY[i], fluids.PositionZ[i], params, [&](std::uint32_t b,
+				float, float, float, float sqrDistance)
+			{
+				density += params.RestDensity * boundary.Volume[b] * Kernel::Value(params, std::sqrt(sqrDistance), sqrDistance);
+			});
+			const float denominator = sumX * sumX + sumY * sumY + sumZ * sumZ + sumSqr;
+
+			fluids.Density[i] = density;
+			fluids.Pressure[i] = 0.f;
+			_factors[i] = denominator > 1e-9f ? 1.f / denominator : 0.f;
+		});
+	});
+}
+
+void DFSPHSolver::SolveDivergence(FluidParticleSystem& fluids, const NeighborList& neighbors, const BoundaryParticleSystem& boundary,
+	const SPHParams& params, JobSystem& jobs, float deltaTime) noexcept
+{
+#ifdef TRACY_ENABLE
+	ZoneScoped;
+#endif
+	const std::size_t count = fluids.Size();
+	_stats.DivergenceIterations = 0;
+	_stats.DivergenceError = 0.f;
+	if (count == 0 || deltaTime <= 0.f || params.RestDensity <= 0.f)
+	{
+		return;
+	}
+
+	_sources.resize(count);
+	_chunkErrors.assign((count + GRAIN_SIZE - 1) / GRAIN_SIZE, {});
+
+	// The stiffness is stored multiplied by the step so it can be reused with a different one
+	float* stored = _divergenceStiffness.data();
+
+	DispatchSmoothingKernel(params.Kernel, [&](auto kernel)
+	{
+		using Kernel = decltype(kernel);
+
+		if (WarmStart)
+		{
+			jobs.ParallelFor(0, count, GRAIN_SIZE, [&](const std::size_t i)
+			{
+				// Half of the last stiffness, the iterations add the rest so the stored value cannot grow without bound.
+				// Only the particles still compressing get it, pushing apart an expanding one would add energy
+				const bool compressing = DensityChangeRate<Kernel>(fluids, neighbors, boundary, params, i) > 0.f;
+				stored[i] = compressing ? stored[i] * 0.5f : 0.f;
+				_sources[i] = stored[i] / deltaTime;
+			});
+			jobs.ParallelFor(0, count, GRAIN_SIZE, [&](const std::size_t i)
+			{
+				ApplyStiffness<Kernel>(fluids, neighbors, boundary, params, _sources.data(), i, deltaTime);
+			});
+		}
+		else
+		{
+			std::fill(_divergenceStiffness.begin(), _divergenceStiffness.end(), 0.f);
+		}
+
+		for (std::size_t iteration = 0; iteration < MaxDivergenceIterations; iteration++)
+		{
+			jobs.ParallelForChunks(0, count, GRAIN_SIZE, [&](const std::size_t first, const std::size_t last)
+			{
+				double error = 0.0;
+				for (std::size_t i = first; i < last; i++)
+				{
+					// Only compression is corrected, a fluid is free to expand
+					const float rate = std::max(DensityChangeRate<Kernel>(fluids, neighbors, boundary, params, i), 0.f);
+					_sources[i] = JacobiWeight * rate * _factors[i] / deltaTime;
+					error += rate;
+				}
+				_chunkErrors[first / GRAIN_SIZE].Sum += error;
+			});
+
+			_stats.DivergenceError = static_cast<float>(collectError() / count) * deltaTime / params.RestDensity;
+			if (_stats.DivergenceError <= MaxDivergenceError && (iteration >= MinIterations || _stats.DivergenceError == 0.f))
+			{
+				break;
+			}
+
+			jobs.ParallelFor(0, count, GRAIN_SIZE, [&](const std::size_t i)
+			{
+				ApplyStiffness<Kernel>(fluids, neighbors, boundary, params, _sources.data(), i, deltaTime);
+				stored[i] += _sources[i] * deltaTime;
+			});
+			_stats.DivergenceIterations++;
+		}
+	});
+}
+
+void DFSPHSolver::SolveDensity(FluidParticleSystem& fluids, const NeighborList& neighbors, const BoundaryParticleSystem& boundary,
+	const SPHParams& params, JobSystem& jobs, float deltaTime) noexcept
+{
+#ifdef TRACY_ENABLE
+	ZoneScoped;
+#endif
+	const std::size_t count = fluids.Size();
+	_stats.DensityIterations = 0;
+	_stats.DensityError = 0.f;
+	if (count == 0 || deltaTime <= 0.f || params.RestDensity <= 0.f)
+	{
+		return;
+	}
+
+	_sources.resize(count);
+	_chunkErrors.assign((count + GRAIN_SIZE - 1) / GRAIN_SIZE, {});
+
+	const float sqrDeltaTime = deltaTime * deltaTime;
+
+	// The density each particle should have at the end of the step: the rest density, or the current one lowered by
+	// MaxDensityCorrection when it is further above, so an overlap is pushed apart over a few steps and not in one kick
+	_targets.resize(count);
+	float* targets = _targets.data();
+	const float maxCorrection = MaxDensityCorrection * params.RestDensity;
+	jobs.ParallelFor(0, count, GRAIN_SIZE, [&](const std::size_t i)
+	{
+		targets[i] = std::max(params.RestDensity, fluids.Density[i] - maxCorrection);
+	});
+
+	// The stiffness is stored multiplied by the squared step so it can be reused with a different one
+	float* stored = _densityStiffness.data();
+
+	DispatchSmoothingKernel(params.Kernel, [&](auto kernel)
+	{
+		using Kernel = decltype(kernel);
+
+		if (WarmStart)
+		{
+			jobs.ParallelFor(0, count, GRAIN_SIZE, [&](const std::size_t i)
+			{
+				const float predicted = fluids.Density[i] + deltaTime * DensityChangeRate<Kernel>(fluids, neighbors, boundary, params, i);
+				stored[i] = predicted > targets[i] ? stored[i] * 0.5f : 0.f;
+				_sources[i] = stored[i] / sqrDeltaTime;
+			});
+			jobs.ParallelFor(0, count, GRAIN_SIZE, [&](const std::size_t i)
+			{
+				ApplyStiffness<Kernel>(fluids, neighbors, boundary, params, _sources.data(), i, deltaTime);
+			});
+		}
+		else
+		{
+			std::fill(_densityStiffness.begin(), _densityStiffness.end(), 0.f);
+		}
+
+		for (std::size_t iteration = 0; iteration < MaxDensityIterations; iteration++)
+		{
+			jobs.ParallelForChunks(0, count, GRAIN_SIZE, [&](const std::size_t first, const std::size_t last)
+			{
+				double error = 0.0;
+				for (std::size_t i = first; i < last; i++)
+				{
+					// Density at the end of the step if the velocities do not change anymore
+					const float predicted = fluids.Density[i] + deltaTime * DensityChangeRate<Kernel>(fluids, neighbors, boundary, params, i);
+					const float compression = std::max(predicted - targets[i], 0.f);
+					_sources[i] = JacobiWeight * compression * _factors[i] / sqrDeltaTime;
+					error += compression;
+				}
+				_chunkErrors[first / GRAIN_SIZE].Sum += error;
+			});
+
+			_stats.DensityError = static_cast<float>(collectError() / count) / params.RestDensity;
+			if (_stats.DensityError <= MaxDensityError && (iteration >= MinIterations || _stats.DensityError == 0.f))
+			{
+				break;
+			}
+
+			jobs.ParallelFor(0, count, GRAIN_SIZE, [&](const std::size_t i)
+			{
+				ApplyStiffness<Kernel>(fluids, neighbors, boundary, params, _sources.data(), i, deltaTime);
+				stored[i] += _sources[i] * sqrDeltaTime;
+			});
+			_stats.DensityIterations++;
+		}
+	});
+}
+
+double DFSPHSolver::collectError() noexcept
+{
+	double sum = 0.0;
+	for (auto& error : _chunkErrors)
+	{
+		sum += error.Sum;
+		error.Sum = 0.0;
+	}
+	return sum;
+}
@@ -0,0 +1,295 @@
+#include "FluidParticleSystem.h"
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+
+#ifdef TRACY_ENABLE
+#include <Tracy.hpp>
+#include <TracyC.h>
+#endif
+
+namespace
+{
+	/**
+	 * @brief Insert two zero bits between each of the 21 low bits of value.
+	 */
+	std::uint64_t SpreadBits(std::uint64_t value) noexcept
+	{
+		value &= 0x1FFFFF;
+		value = (value | value << 32) & 0x1F00000000FFFF;
+		value = (value | value << 16) & 0x1F0000FF0000FF;
+		value = (value | value << 8) & 0x100F00F00F00F00F;
+		value = (value | value << 4) & 0x10C30C30C30C30C3;
+		value = (value | value << 2) & 0x1249249249249249;
+		return value;
+	}
+
+	std::uint64_t MortonCode(std::uint32_t x, std::uint32_t y, std::uint32_t z) noexcept
+	{
+		return SpreadBits(x) | SpreadBits(y) << 1 | SpreadBits(z) << 2;
+	}
+
+	template<typename Column>
+	void Permute(Column& column, Column& scratch, const std::vector<std::pair<std::uint64_t, std::uint32_t>>& order) noexcept
+	{
+		scratch.resize(column.size());
+		for (std::size_t i = 0; i < column.size(); i++)
+		{
+			scratch[i] = column[order[i].second];
+		}
+		column.swap(scratch);
+	}
+
+	template<typename Column>
+	void SwapRemove(Column& column, std::size_t index) noexcept
+	{
+		column[index] = column.back();
+		column.pop_back();
+	}
+}
+
+std::uint32_t FluidParticleSystem::Add(std::size_t bodyIndex) noexcept
+{
+	if (bodyIndex >= _particleOfBody.size())
+	{
+		_particleOfBody.resize(bodyIndex + 1, INVALID_INDEX);
+	}
+
+	const auto particle = static_cast<std::uint32_t>(Size());
+	Resize(Size() + 1);
+
+	BodyIndices[particle] = static_cast<std::uint32_t>(bodyIndex);
+	_particleOfBody[bodyIndex] = particle;
+
+	return particle;
+}
+
+void FluidParticleSystem::Remove(std::size_t bodyIndex) noexcept
+{
+	const std::uint32_t particle = ParticleOf(bodyIndex);
+	if (particle == INVALID_INDEX)
+	{
+		return;
+	}
+
+	for (CustomlyAllocatedVector<float>* column : _columns)
+	{
+		SwapRemove(*column, particle);
+	}
+	for (std::vector<float>* column : _attachedFloats)
+	{
+		SwapRemove(*column, particle);
+	}
+	for (std::vector<std::uint32_t>* column : _attachedIndices)
+	{
+		SwapRemove(*column, particle);
+	}
+	SwapRemove(BodyIndices, particle);
+
+	_particleOfBody[bodyIndex] = INVALID_INDEX;
+	if (particle < Size())
+	{
+		_particleOfBody[BodyIndices[particle]] = particle;
+	}
+}
+
+void FluidParticleSystem::Clear() noexcept
+{
+	Resize(0);
+	_particleOfBody.clear();
+}
+
+void FluidParticleSystem::Attach(std::vector<float>& column) noexcept
+{
+	if (std::find(_attachedFloats.begin(), _attachedFloats.end(), &column) == _attachedFloats.end())
+	{
+		_attachedFloats.push_back(&column);
+	}
+	column.resize(Size(), 0.f);
+}
+
+void FluidParticleSystem::Attach(std::vector<std::uint32_t>& column) noexcept
+{
+	if (std::find(_attachedIndices.begin(), _attachedIndices.end(), &column) == _attachedIndices.end())
+	{
+		_attachedIndices.push_back(&column);
+	}
+	column.resize(Size(), 0);
+}
+
+void FluidParticleSystem::Load(std::uint32_t particle, RigidBodySystem& bodies, std::uint32_t slot) noexcept
+{
+	SetPosition(particle, bodies.GetPosition(slot));
+	SetVelocity(particle, bodies.GetVelocity(slot));
+
+	AddExternalForce(particle, bodies.GetForce(slot));
+	bodies.ResetForce(slot);
+
+	SetMass(particle, bodies.Mass[slot]);
+}
+
+void FluidParticleSystem::Store(std::uint32_t particle, RigidBodySystem& bodies, std::uint32_t slot) const noexcept
+{
+	bodies.SetPosition(slot, GetPosition(particle));
+	bodies.SetVelocity(slot, GetVelocity(particle));
+}
+
+void FluidParticleSystem::ResetForces(std::size_t first, std::size_t last) noexcept
+{
+	std::copy(ExternalForceX.begin() + first, ExternalForceX.begin() + last, ForceX.begin() + first);
+	std::copy(ExternalForceY.begin() + first, ExternalForceY.begin() + last, ForceY.begin() + first);
+	std::copy(ExternalForceZ.begin() + first, ExternalForceZ.begin() + last, ForceZ.begin() + first);
+}
+
+void FluidParticleSystem::ClearExternalForces() noexcept
+{
+	std::fill(ExternalForceX.begin(), ExternalForceX.end(), 0.f);
+	std::fill(ExternalForceY.begin(), ExternalForceY.end(), 0.f);
+	std::fill(ExternalForceZ.begin(), ExternalForceZ.end(), 0.f);
+}
+
+void FluidParticleSystem::Integrate(const IntegratorTable& integrator, float kickTime, float deltaTime, float gravity,
+	std::size_t first, std::size_t last) noexcept
+{
+	integrator.KickDrift(Columns(), kickTime, deltaTime, gravity, first, last);
+	ResetForces(first, last);
+}
+
+void FluidParticleSystem::IntegrateVelocities(const IntegratorTable& integrator, float deltaTime, float gravity,
+	std::size_t first, std::size_t last) noexcept
+{
+	integrator.Kick(Columns(), deltaTime, gravity, first, last);
+	ResetForces(first, last);
+}
+
+void FluidParticleSystem::IntegratePositions(const IntegratorTable& integrator, float deltaTime, std::size_t first, std::size_t last) noexcept
+{
+	integrator.Drift(Columns(), deltaTime, first, last);
+}
+
+IntegratorColumns FluidParticleSystem::Columns() noexcept
+{
+	return {
+		PositionX.data(), PositionY.data(), PositionZ.data(),
+		VelocityX.data(), VelocityY.data(), VelocityZ.data(),
+		ForceX.data(), ForceY.data(), ForceZ.data(), InvMass.data() };
+}
+
+FluidParticleSystem::MotionBounds FluidParticleSystem::ComputeMotionBounds(float gravity) const noexcept
+{
+#ifdef TRACY_ENABLE
+	ZoneScoped;
+#endif
+	float maxSqrSpeed = 0.f;
+	float maxSqrAcceleration = 0.f;
+	float maxDensity = 0.f;
+
+	for (std::size_t i = 0; i < Size(); i++)
+	{
+		const float sqrSpeed = VelocityX[i] * VelocityX[i] + VelocityY[i] * VelocityY[i] + VelocityZ[i] * VelocityZ[i];
+		maxSqrSpeed = std::max(maxSqrSpeed, sqrSpeed);
+
+		const float invMass = InvMass[i];
+		const float accelerationX = ForceX[i] * invMass;
+		const float accelerationY = (ForceY[i] - gravity) * invMass;
+		const float accelerationZ = ForceZ[i] * invMass;
+		const float sqrAcceleration = accelerationX * accelerationX + accelerationY * accelerationY + accelerationZ * accelerationZ;
+		maxSqrAcceleration = std::max(maxSqrAcceleration, sqrAcceleration);
+
+		maxDensity = std::max(maxDensity, Density[i]);
+	}
+
+	return { std::sqrt(maxSqrSpeed), std::sqrt(maxSqrAcceleration), maxDensity };
+}
+
+void FluidParticleSystem::SortByMortonOrder(float cellSize) noexcept
+{
+#ifdef TRACY_ENABLE
+	ZoneScoped;
+#endif
+	const std::size_t count = Size();
+	if (count < 2)
+	{
+		return;
+	}
+
+	const float invCellSize = 1.f / cellSize;
+
+	auto isFinite = [this](std::size_t i) noexcept
+	{
+		return std::isfinite(PositionX[i]) && std::isfinite(PositionY[i]) && std::isfinite(PositionZ[i]);
+	};
+
+	// Lowest corner of the finite positions, a NaN or infinite coordinate would poison the whole frame of cells
+	float minX = std::numeric_limits<float>::max();
+	float minY = std::numeric_limits<float>::max();
+	float minZ = std::numeric_limits<float>::max();
+	for (std::size_t i = 0; i < count; i++)
+	{
+		if (!isFinite(i)) continue;
+
+		minX = std::min(minX, PositionX[i]);
+		minY = std::min(minY, PositionY[i]);
+		minZ = std::min(minZ, PositionZ[i]);
+	}
+
+	// Cell coordinates relative to the lowest corner so they are positive, clamped to the 21 bits of the code
+	// before the conversion, which is undefined for values an uint32_t cannot hold
+	auto cellOf = [invCellSize](float position, float min) noexcept
+	{
+		constexpr float MAX_CELL = static_cast<float>(0x1FFFFF);
+		const float cell = std::floor((position - min) * invCellSize);
+		return static_cast<std::uint32_t>(std::clamp(cell, 0.f, MAX_CELL));
+	};
+
+	// Every valid code fits in 63 bits, particles with a non-finite position are sent after all of them
+	constexpr std::uint64_t INVALID_KEY = std::numeric_limits<std::uint64_t>::max();
+
+	_sortKeys.resize(count);
+	for (std::size_t i = 0; i < count; i++)
+	{
+		const std::uint64_t key = isFinite(i) ?
+			MortonCode(cellOf(PositionX[i], minX), cellOf(PositionY[i], minY), cellOf(PositionZ[i], minZ)) : INVALID_KEY;
+		_sortKeys[i] = { key, static_cast<std::uint32_t>(i) };
+	}
+
+	// Ties keep the particle index so the order is deterministic
+	std::sort(_sortKeys.begin(), _sortKeys.end());
+
+	for (CustomlyAllocatedVector<float>* column : _columns)
+	{
+		Permute(*column, _floatScratch, _sortKeys);
+	}
+	for (std::vector<float>* column : _attachedFloats)
+	{
+		Permute(*column, _attachedFloatScratch, _sortKeys);
+	}
+	for (std::vector<std::uint32_t>* column : _attachedIndices)
+	{
+		Permute(*column, _attachedIndexScratch, _sortKeys);
+	}
+	Permute(BodyIndices, _indexScratch, _sortKeys);
+
+	for (std::size_t i = 0; i < count; i++)
+	{
+		_particleOfBody[BodyIndices[i]] = static_cast<std::uint32_t>(i);
+	}
+}
+
+void FluidParticleSystem::Resize(std::size_t size) noexcept
+{
+	for (CustomlyAllocatedVector<float>* column : _columns)
+	{
+		column->resize(size, 0.f);
+	}
+	for (std::vector<float>* column : _attachedFloats)
+	{
+		column->resize(size, 0.f);
+	}
+	for (std::vector<std::uint32_t>* column : _attachedIndices)
+	{
+		column->resize(size, 0);
+	}
+	BodyIndices.resize(size, 0);
+}
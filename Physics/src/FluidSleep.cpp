@@ -0,0 +1,230 @@
+#include "FluidSleep.h"
+#include "UniformGrid.h"
+
+#include <algorithm>
+#include <cmath>
+
+#ifdef TRACY_ENABLE
+#include <Tracy.hpp>
+#include <TracyC.h>
+#endif
+
+std::uint64_t FluidSleepTracker::CellKey(int x, int y, int z) noexcept
+{
+	// 21 bits per coordinate, offset so negative cells stay distinct
+	constexpr std::uint64_t MASK = 0x1FFFFF;
+	constexpr int OFFSET = 1 << 20;
+	return (static_cast<std::uint64_t>(x + OFFSET) & MASK) |
+		((static_cast<std::uint64_t>(y + OFFSET) & MASK) << 21) |
+		((static_cast<std::uint64_t>(z + OFFSET) & MASK) << 42);
+}
+
+void FluidSleepTracker::wake(int x, int y, int z) noexcept
+{
+	const auto it = _cells.find(CellKey(x, y, z));
+	if (it != _cells.end() && it->second.Asleep)
+	{
+		_woken.push_back(&it->second);
+	}
+}
+
+void FluidSleepTracker::Attach(FluidParticleSystem& fluids) noexcept
+{
+	fluids.Attach(_asleep);
+}
+
+void FluidSleepTracker::Update(FluidParticleSystem& fluids, float cellSize, const std::vector<CuboidF>& wakeBounds) noexcept
+{
+#ifdef TRACY_ENABLE
+	ZoneScoped;
+#endif
+	const std::size_t count = fluids.Size();
+	const float invCellSize = 1.f / cellSize;
+	auto cellCoord = [invCellSize](float position) noexcept
+	{
+		return UniformGrid::CellCoord(position, invCellSize);
+	};
+
+	_frame++;
+	_particleCells.resize(count);
+
+	for (std::size_t i = 0; i < count; i++)
+	{
+		const int x = cellCoord(fluids.PositionX[i]);
+		const int y = cellCoord(fluids.PositionY[i]);
+		const int z = cellCoord(fluids.PositionZ[i]);
+
+		Cell& cell = _cells[CellKey(x, y, z)];
+		if (cell.Frame != _frame)
+		{
+			cell.X = x, cell.Y = y, cell.Z = z;
+			cell.Frame = _frame;
+			cell.Count = 0;
+			cell.MaxSqrSpeed = 0.f;
+			cell.DensitySum = 0.0;
+			cell.Forced = false;
+		}
+
+		cell.Count++;
+		cell.MaxSqrSpeed = std::max(cell.MaxSqrSpeed, fluids.VelocityX[i] * fluids.VelocityX[i] +
+			fluids.VelocityY[i] * fluids.VelocityY[i] + fluids.VelocityZ[i] * fluids.VelocityZ[i]);
+		cell.DensitySum += fluids.Density[i];
+		cell.Forced |= fluids.ExternalForceX[i] != 0.f || fluids.ExternalForceY[i] != 0.f || fluids.ExternalForceZ[i] != 0.f;
+
+		_particleCells[i] = &cell;
+	}
+
+	// Cells left by all their particles are forgotten, the pointers above only reference cells of this frame
+	for (auto it = _cells.begin(); it != _cells.end();)
+	{
+		it = it->second.Frame != _frame ? _cells.erase(it) : std::next(it);
+	}
+
+	const float sqrSleepSpeed = SleepSpeed * SleepSpeed;
+
+	for (auto& [key, cell] : _cells)
+	{
+		const float density = static_cast<float>(cell.DensitySum / cell.Count);
+		const bool calm = !cell.Forced && cell.MaxSqrSpeed <= sqrSleepSpeed && cell.Count == cell.PreviousCount &&
+			std::abs(density - cell.PreviousDensity) <= SleepDensityChange * cell.PreviousDensity;
+
+		cell.PreviousCount = cell.Count;
+		cell.PreviousDensity = density;
+
+		if (calm)
+		{
+			cell.CalmFrames++;
+		}
+		else
+		{
+			cell.CalmFrames = 0;
+			cell.Asleep = false;
+		}
+	}
+
+	// Disturbed cells wake their sleeping neighbors, the wake spreads one cell per frame while the disturbance lasts
+	_woken.clear();
+	for (const auto& [key, cell] : _cells)
+	{
+		if (cell.CalmFrames != 0)
+		{
+			continue;
+		}
+
+		for (int dx = -1; dx <= 1; dx++)
+		{
+			for (int dy = -1; dy <= 1; dy++)
+			{
+				for (int dz = -1; dz <= 1; dz++)
+				{
+					wake(cell.X + dx, cell.Y + dy, cell.Z + dz);
+				}
+			}
+		}
+	}
+
+	for (const auto& bounds : wakeBounds)
+	{
+		// One cell of margin so the fluid around a body is awake before the body reaches it
+		const int minX = cellCoord(XMVectorGetX(bounds.MinBound())) - 1, maxX = cellCoord(XMVectorGetX(bounds.MaxBound())) + 1;
+		const int minY = cellCoord(XMVectorGetY(bounds.MinBound())) - 1, maxY = cellCoord(XMVectorGetY(bounds.MaxBound())) + 1;
+		const int minZ = cellCoord(XMVectorGetZ(bounds.MinBound())) - 1, maxZ = cellCoord(XMVectorGetZ(bounds.MaxBound())) + 1;
+
+		// The coordinates are clamped to +-2^30, the cell count of a huge box overflows any integer
+		const double boxCells = (static_cast<double>(maxX) - minX + 1) * (static_cast<double>(maxY) - minY + 1) *
+			(static_cast<double>(maxZ) - minZ + 1);
+		if (boxCells > static_cast<double>(_cells.size()))
+		{
+			for (auto& [key, cell] : _cells)
+			{
+				if (cell.Asleep && cell.X >= minX && cell.X <= maxX && cell.Y >= minY && cell.Y <= maxY && cell.Z >= minZ && cell.Z <= maxZ)
+				{
+					_woken.push_back(&cell);
+				}
+			}
+			continue;
+		}
+
+		for (int x = minX; x <= maxX; x++)
+		{
+			for (int y = minY; y <= maxY; y++)
+			{
+				for (int z = minZ; z <= maxZ; z++)
+				{
+					wake(x, y, z);
+				}
+			}
+		}
+	}
+
+	for (Cell* cell : _woken)
+	{
+		cell->Asleep = false;
+		cell->CalmFrames = 0;
+	}
+
+	for (auto& [key, cell] : _cells)
+	{
+		cell.Asleep = cell.Asleep || cell.CalmFrames >= SleepFrames;
+	}
+
+	_sleepingParticles = 0;
+	_changed = false;
+	for (std::size_t i = 0; i < count; i++)
+	{
+		const bool asleep = _particleCells[i]->Asleep;
+		_changed |= asleep != (_asleep[i] != 0);
+		if (asleep && _asleep[i] == 0)
+		{
+			// A particle falling asleep is stopped so it stays in place once it wakes up again
+			fluids.VelocityX[i] = 0.f;
+			fluids.VelocityY[i] = 0.f;
+			fluids.VelocityZ[i] = 0.f;
+		}
+		_asleep[i] = asleep ? 1 : 0;
+		_sleepingParticles += asleep ? 1 : 0;
+	}
+}
+
+void FluidSleepTracker::WakeAll() noexcept
+{
+	_changed = _sleepingParticles != 0;
+	if (_changed)
+	{
+		std::fill(_asleep.begin(), _asleep.end(), 0);
+	}
+	_cells.clear();
+	_awakeChunks.clear();
+	_sleepingParticles = 0;
+}
+
+void FluidSleepTracker::BuildAwakeChunks(std::size_t grainSize) noexcept
+{
+#ifdef TRACY_ENABLE
+	ZoneScoped;
+#endif
+	_awakeChunks.clear();
+	if (_sleepingParticles == 0)
+	{
+		return;
+	}
+
+	const auto count = static_cast<std::uint32_t>(_asleep.size());
+	std::uint32_t i = 0;
+	while (i < count)
+	{
+		if (_asleep[i] != 0)
+		{
+			i++;
+			continue;
+		}
+
+		// Morton ordered particles of a cell are mostly consecutive, so the ranges are long
+		const std::uint32_t first = i;
+		while (i < count && _asleep[i] == 0 && i - first < grainSize)
+		{
+			i++;
+		}
+		_awakeChunks.emplace_back(first, i);
+	}
+}
@@ -0,0 +1,64 @@
+#include "Integrator.h"
+#include "SPHKernels.h"
+
+namespace
+{
+	void KickScalar(const IntegratorColumns& c, float kickTime, float gravity, std::size_t begin, std::size_t end)
+	{
+		for (std::size_t i = begin; i < end; i++)
+		{
+			c.VelocityX[i] += c.ForceX[i] * c.InvMass[i] * kickTime;
+			c.VelocityY[i] += (c.ForceY[i] - gravity) * c.InvMass[i] * kickTime;
+			c.VelocityZ[i] += c.ForceZ[i] * c.InvMass[i] * kickTime;
+		}
+	}
+
+	void DriftScalar(const IntegratorColumns& c, float deltaTime, std::size_t begin, std::size_t end)
+	{
+		for (std::size_t i = begin; i < end; i++)
+		{
+			c.PositionX[i] += c.VelocityX[i] * deltaTime;
+			c.PositionY[i] += c.VelocityY[i] * deltaTime;
+			c.PositionZ[i] += c.VelocityZ[i] * deltaTime;
+		}
+	}
+
+	void KickDriftScalar(const IntegratorColumns& c, float kickTime, float deltaTime, float gravity, std::size_t begin, std::size_t end)
+	{
+		for (std::size_t i = begin; i < end; i++)
+		{
+			c.VelocityX[i] += c.ForceX[i] * c.InvMass[i] * kickTime;
+			c.VelocityY[i] += (c.ForceY[i] - gravity) * c.InvMass[i] * kickTime;
+			c.VelocityZ[i] += c.ForceZ[i] * c.InvMass[i] * kickTime;
+
+			c.PositionX[i] += c.VelocityX[i] * deltaTime;
+			c.PositionY[i] += c.VelocityY[i] * deltaTime;
+			c.PositionZ[i] += c.VelocityZ[i] * deltaTime;
+		}
+	}
+
+	constexpr IntegratorTable SCALAR_TABLE{ "Scalar", &KickDriftScalar, &KickScalar, &DriftScalar };
+}
+
+const IntegratorTable& Integrators::Scalar() noexcept
+{
+	return SCALAR_TABLE;
+}
+
+const IntegratorTable& Integrators::Select() noexcept
+{
+	static const IntegratorTable& selected = SPHKernels::HasAVX2() && AVX2() != nullptr ? *AVX2() : Scalar();
+	return selected;
+}
+
+float Integrators::KickTime(IntegratorScheme scheme, float deltaTime, float previousDeltaTime) noexcept
+{
+	switch (scheme)
+	{
+	case IntegratorScheme::Leapfrog:
+		return (previousDeltaTime + deltaTime) * 0.5f;
+	case IntegratorScheme::SemiImplicitEuler:
+	default:
+		return deltaTime;
+	}
+}
@@ -0,0 +1,128 @@
+#include "Integrator.h"
+
+// Compiled with AVX2 + FMA enabled (see CMakeLists.txt), only called after Integrators::Select checked the CPU.
+// MSVC does not define __FMA__, /arch:AVX2 implies it
+#if defined(__AVX2__) && (defined(__FMA__) || defined(_MSC_VER))
+
+#include <immintrin.h>
+
+namespace
+{
+	constexpr std::size_t LANES = 8;
+
+	/**
+	 * @brief The three components of a column triple, loaded and stored together.
+	 */
+	struct Vector3
+	{
+		__m256 X, Y, Z;
+	};
+
+	Vector3 Load(const float* x, const float* y, const float* z, std::size_t i) noexcept
+	{
+		return { _mm256_loadu_ps(x + i), _mm256_loadu_ps(y + i), _mm256_loadu_ps(z + i) };
+	}
+
+	void Store(float* x, float* y, float* z, std::size_t i, const Vector3& v) noexcept
+	{
+		_mm256_storeu_ps(x + i, v.X);
+		_mm256_storeu_ps(y + i, v.Y);
+		_mm256_storeu_ps(z + i, v.Z);
+	}
+
+	/**
+	 * @brief Acceleration of the step, gravity folded into the vertical force.
+	 */
+	Vector3 Acceleration(const IntegratorColumns& c, std::size_t i, __m256 gravity) noexcept
+	{
+		const __m256 invMass = _mm256_loadu_ps(c.InvMass + i);
+		return {
+			_mm256_mul_ps(_mm256_loadu_ps(c.ForceX + i), invMass),
+			_mm256_mul_ps(_mm256_sub_ps(_mm256_loadu_ps(c.ForceY + i), gravity), invMass),
+			_mm256_mul_ps(_mm256_loadu_ps(c.ForceZ + i), invMass) };
+	}
+
+	void KickAVX2(const IntegratorColumns& c, float kickTime, float gravity, std::size_t begin, std::size_t end)
+	{
+		const __m256 kick = _mm256_set1_ps(kickTime);
+		const __m256 g = _mm256_set1_ps(gravity);
+
+		std::size_t i = begin;
+		for (; i + LANES <= end; i += LANES)
+		{
+			const Vector3 a = Acceleration(c, i, g);
+			Vector3 v = Load(c.VelocityX, c.VelocityY, c.VelocityZ, i);
+
+			v.X = _mm256_fmadd_ps(a.X, kick, v.X);
+			v.Y = _mm256_fmadd_ps(a.Y, kick, v.Y);
+			v.Z = _mm256_fmadd_ps(a.Z, kick, v.Z);
+
+			Store(c.VelocityX, c.VelocityY, c.VelocityZ, i, v);
+		}
+
+		Integrators::Scalar().Kick(c, kickTime, gravity, i, end);
+	}
+
+	void DriftAVX2(const IntegratorColumns& c, float deltaTime, std::size_t begin, std::size_t end)
+	{
+		const __m256 dt = _mm256_set1_ps(deltaTime);
+
+		std::size_t i = begin;
+		for (; i + LANES <= end; i += LANES)
+		{
+			const Vector3 v = Load(c.VelocityX, c.VelocityY, c.VelocityZ, i);
+			Vector3 x = Load(c.PositionX, c.PositionY, c.PositionZ, i);
+
+			x.X = _mm256_fmadd_ps(v.X, dt, x.X);
+			x.Y = _mm256_fmadd_ps(v.Y, dt, x.Y);
+			x.Z = _mm256_fmadd_ps(v.Z, dt, x.Z);
+
+			Store(c.PositionX, c.PositionY, c.PositionZ, i, x);
+		}
+
+		Integrators::Scalar().Drift(c, deltaTime, i, end);
+	}
+
+	void KickDriftAVX2(const IntegratorColumns& c, float kickTime, float deltaTime, float gravity, std::size_t begin, std::size_t end)
+	{
+		const __m256 kick = _mm256_set1_ps(kickTime);
+		const __m256 dt = _mm256_set1_ps(deltaTime);
+		const __m256 g = _mm256_set1_ps(gravity);
+
+		std::size_t i = begin;
+		for (; i + LANES <= end; i += LANES)
+		{
+			const Vector3 a = Acceleration(c, i, g);
+			Vector3 v = Load(c.VelocityX, c.VelocityY, c.VelocityZ, i);
+			Vector3 x = Load(c.PositionX, c.PositionY, c.PositionZ, i);
+
+			v.X = _mm256_fmadd_ps(a.X, kick, v.X);
+			v.Y = _mm256_fmadd_ps(a.Y, kick, v.Y);
+			v.Z = _mm256_fmadd_ps(a.Z, kick, v.Z);
+			x.X = _mm256_fmadd_ps(v.X, dt, x.X);
+			x.Y = _mm256_fmadd_ps(v.Y, dt, x.Y);
+			x.Z = _mm256_fmadd_ps(v.Z, dt, x.Z);
+
+			Store(c.VelocityX, c.VelocityY, c.VelocityZ, i, v);
+			Store(c.PositionX, c.PositionY, c.PositionZ, i, x);
+		}
+
+		Integrators::Scalar().KickDrift(c, kickTime, deltaTime, gravity, i, end);
+	}
+
+	constexpr IntegratorTable AVX2_TABLE{ "AVX2", &KickDriftAVX2, &KickAVX2, &DriftAVX2 };
+}
+
+const IntegratorTable* Integrators::AVX2() noexcept
+{
+	return &AVX2_TABLE;
+}
+
+#else
+
+const IntegratorTable* Integrators::AVX2() noexcept
+{
+	return nullptr;
+}
+
+#endif
@@ -0,0 +1,160 @@
+#include "NeighborList.h"
+
+#ifdef TRACY_ENABLE
+#include <Tracy.hpp>
+#include <TracyC.h>
+#endif
+
+void NeighborList::Build(const UniformGrid& grid, const float* x, const float* y, const float* z, std::size_t count, float radius,
+	JobSystem& jobs, bool half, const std::uint32_t* skip) noexcept
+{
+#ifdef TRACY_ENABLE
+	ZoneScoped;
+#endif
+	const float sqrRadius = radius * radius;
+
+	_builder.Build(count, jobs, Offsets, Indices, [&](const std::size_t i, std::vector<std::uint32_t>& list)
+	{
+		if (skip != nullptr && skip[i] != 0)
+		{
+			return;
+		}
+
+		if (half)
+		{
+			const int cellX = grid.CellCoord(x[i]);
+			const int cellY = grid.CellCoord(y[i]);
+			const int cellZ = grid.CellCoord(z[i]);
+
+			grid.ForEachHalfShellCandidate(x[i], y[i], z[i], [&](const std::uint32_t j, int offsetX, int offsetY, int offsetZ)
+			{
+				// Pairs of the same cell are kept from the lower index only
+				if (offsetX == 0 && offsetY == 0 && offsetZ == 0 && j <= i) return;
+
+				// Reject the particles of other cells that share the slot of the stencil cell
+				if (grid.CellCoord(x[j]) != cellX + offsetX || grid.CellCoord(y[j]) != cellY + offsetY ||
+					grid.CellCoord(z[j]) != cellZ + offsetZ) return;
+
+				const float dx = x[i] - x[j];
+				const float dy = y[i] - y[j];
+				const float dz = z[i] - z[j];
+				if (dx * dx + dy * dy + dz * dz < sqrRadius)
+				{
+					list.push_back(j);
+				}
+			});
+			return;
+		}
+
+		grid.ForEachCandidate(x[i], y[i], z[i], [&](const std::uint32_t j)
+		{
+			if (j == i) return;
+
+			const float dx = x[i] - x[j];
+			const float dy = y[i] - y[j];
+			const float dz = z[i] - z[j];
+			if (dx * dx + dy * dy + dz * dz < sqrRadius)
+			{
+				list.push_back(j);
+			}
+		});
+	});
+
+	if (half)
+	{
+		buildReverse(count, jobs);
+	}
+	else
+	{
+		ReverseOffsets.clear();
+		ReverseEntries.clear();
+	}
+
+	_buildX.assign(x, x + count);
+	_buildY.assign(y, y + count);
+	_buildZ.assign(z, z + count);
+	_buildRadius = radius;
+	_half = half;
+}
+
+bool NeighborList::NeedsRebuild(const float* x, const float* y, const float* z, std::size_t count, float radius, float skin) const noexcept
+{
+#ifdef TRACY_ENABLE
+	ZoneScoped;
+#endif
+	if (skin <= 0.f || count != Size() || radius != _buildRadius)
+	{
+		return true;
+	}
+
+	const float maxSqrDisplacement = skin * skin * 0.25f;
+
+	for (std::size_t i = 0; i < count; i++)
+	{
+		const float dx = x[i] - _buildX[i];
+		const float dy = y[i] - _buildY[i];
+		const float dz = z[i] - _buildZ[i];
+		if (dx * dx + dy * dy + dz * dz > maxSqrDisplacement)
+		{
+			return true;
+		}
+	}
+	return false;
+}
+
+void NeighborList::buildReverse(std::size_t count, JobSystem& jobs) noexcept
+{
+#ifdef TRACY_ENABLE
+	ZoneScoped;
+#endif
+	constexpr std::size_t GRAIN_SIZE = 4096; /**< Entries processed by one job. */
+
+	// Stable, so the entries naming a particle stay in increasing order
+	const std::size_t entries = Indices.size();
+	_reverseSort.Sort(Indices.data(), entries, count == 0 ? 0 : static_cast<std::uint32_t>(count - 1), jobs);
+	ReverseEntries.swap(_reverseSort.Order);
+
+	ReverseOffsets.resize(count + 1);
+	const std::uint32_t* sorted = _reverseSort.SortedKeys.data();
+
+	// ReverseOffsets[j] is the first sorted entry naming j or a later particle, so entry r writes the offsets of
+	// the particles after the previous sorted neighbor up to its own: every offset is written once, including
+	// those of the particles no entry names
+	jobs.ParallelFor(0, entries + 1, GRAIN_SIZE, [&](const std::size_t r)
+	{
+		const std::size_t first = r == 0 ? 0 : sorted[r - 1] + 1;
+		const std::size_t last = r == entries ? count : sorted[r];
+		for (std::size_t j = first; j <= last; j++)
+		{
+			ReverseOffsets[j] = static_cast<std::uint32_t>(r);
+		}
+	});
+}
+
+float NeighborList::AverageLength(const std::uint32_t* skip) const noexcept
+{
+	if (skip == nullptr)
+	{
+		return AverageLength();
+	}
+
+	std::size_t built = 0;
+	for (std::size_t i = 0; i < Size(); i++)
+	{
+		built += skip[i] == 0;
+	}
+	return built == 0 ? 0.f : static_cast<float>(Indices.size()) / static_cast<float>(built);
+}
+
+void NeighborList::Clear() noexcept
+{
+	Offsets.clear();
+	Indices.clear();
+	ReverseOffsets.clear();
+	ReverseEntries.clear();
+	_buildX.clear();
+	_buildY.clear();
+	_buildZ.clear();
+	_buildRadius = 0.f;
+	_half = false;
+}
@@ -0,0 +1,368 @@
+#include "PBFSolver.h"
+#include "SPHKernelPolicies.h"
+
+#include <algorithm>
+#include <cmath>
+
+#ifdef TRACY_ENABLE
+#include <Tracy.hpp>
+#include <TracyC.h>
+#endif
+
+namespace
+{
+	constexpr std::size_t GRAIN_SIZE = 128; /**< Particles processed by one job of the solver passes. */
+
+	/**
+	 * @brief Call func(j, distance, sqrDistance, dirX, dirY, dirZ) for each in-radius neighbor j of particle i,
+	 * dir is the unit vector from j to i.
+	 */
+	template<typename Func>
+	void ForEachInRadius(const FluidParticleSystem& f, const NeighborList& neighbors, const SPHParams& k, std::size_t i, Func&& func) noexcept
+	{
+		for (const std::uint32_t* it = neighbors.begin(i); it != neighbors.end(i); ++it)
+		{
+			const std::uint32_t j = *it;
+			const float dx = f.PositionX[i] - f.PositionX[j];
+			const float dy = f.PositionY[i] - f.PositionY[j];
+			const float dz = f.PositionZ[i] - f.PositionZ[j];
+			const float sqrDistance = dx * dx + dy * dy + dz * dz;
+			if (sqrDistance >= k.SqrRadius || sqrDistance == 0.f) continue;
+
+			const float distance = std::sqrt(sqrDistance);
+			const float invDistance = 1.f / distance;
+			func(j, distance, sqrDistance, dx * invDistance, dy * invDistance, dz * invDistance);
+		}
+	}
+
+	/**
+	 * @brief Call func(mass, distance, sqrDistance, dirX, dirY, dirZ) for each in-radius boundary particle b of particle i
+	 * with its mass psi_b = rho_0 V_b, dir is the unit vector from b to i.
+	 */
+	template<typename Func>
+	void ForEachBoundaryInRadius(const FluidParticleSystem& f, const BoundaryParticleSystem& boundary, const SPHParams& k,
+		std::size_t i, Func&& func) noexcept
+	{
+		boundary.ForEachInRadius(i, f.PositionX[i], f.PositionY[i], f.PositionZ[i], k, [&](std::uint32_t b,
+			float dx, float dy, float dz, float sqrDistance)
+		{
+			const float distance = std::sqrt(sqrDistance);
+			const float invDistance = 1.f / distance;
+			func(k.RestDensity * boundary.Volume[b], distance, sqrDistance, dx * invDistance, dy * invDistance, dz * invDistance);
+		});
+	}
+
+	/**
+	 * @brief A particle of a cubic lattice at rest.
+	 */
+	struct RestLattice
+	{
+		float Spacing = 0.f; /**< Spacing at which the particles have the rest density. */
+		float GradientSum = 0.f; /**< Sum of the squared constraint gradients (m / rho_0)^2 |dW|^2 over the neighbors. */
+	};
+
+	/**
+	 * @brief Call func(distance, sqrDistance) for each in-radius node of a cubic lattice of the given spacing
+	 * around the origin, the origin excluded.
+	 */
+	template<typename Func>
+	void ForEachLatticeNeighbor(const SPHParams& k, float spacing, Func&& func) noexcept
+	{
+		const int extent = static_cast<int>(k.SmoothingRadius / spacing);
+		for (int x = -extent; x <= extent; x++)
+		{
+			for (int y = -extent; y <= extent; y++)
+			{
+				for (int z = -extent; z <= extent; z++)
+				{
+					const float sqrDistance = static_cast<float>(x * x + y * y + z * z) * spacing * spacing;
+					if (sqrDistance >= k.SqrRadius || sqrDistance == 0.f) continue;
+					func(std::sqrt(sqrDistance), sqrDistance);
+				}
+			}
+		}
+	}
+
+	/**
+	 * @brief Find by bisection the lattice on which particles of the given mass have the rest density.
+	 * @note The spacing is searched between a quarter and the whole smoothing radius, a few dozen kernel sums.
+	 */
+	template<typename Kernel>
+	RestLattice MeasureRestLattice(const SPHParams& k, float mass) noexcept
+	{
+		float low = 0.25f * k.SmoothingRadius, high = k.SmoothingRadius;
+		for (int iteration = 0; iteration < 24; iteration++)
+		{
+			const float spacing = 0.5f * (low + high);
+			float density = mass * k.SelfDensity;
+			ForEachLatticeNeighbor(k, spacing, [&](float distance, float sqrDistance)
+			{
+				density += mass * Kernel::Value(k, distance, sqrDistance);
+			});
+			// The density decreases with the spacing
+			(density > k.RestDensity ? low : high) = spacing;
+		}
+
+		RestLattice lattice;
+		lattice.Spacing = 0.5f * (low + high);
+		const float scale = mass / k.RestDensity;
+		ForEachLatticeNeighbor(k, lattice.Spacing, [&](float distance, float sqrDistance)
+		{
+			const float slope = scale * Kernel::Slope(k, distance, sqrDistance);
+			lattice.GradientSum += slope * slope;
+		});
+		return lattice;
+	}
+}
+
+void PBFSolver::Attach(FluidParticleSystem& fluids) noexcept
+{
+	fluids.Attach(_startX);
+	fluids.Attach(_startY);
+	fluids.Attach(_startZ);
+}
+
+void PBFSolver::PredictPositions(FluidParticleSystem& fluids, const IntegratorTable& integrator, JobSystem& jobs, float deltaTime,
+	float gravity) noexcept
+{
+#ifdef TRACY_ENABLE
+	ZoneScoped;
+#endif
+	jobs.ParallelForChunks(0, fluids.Size(), GRAIN_SIZE, [&](const std::size_t first, const std::size_t last)
+	{
+		std::copy(fluids.PositionX.begin() + first, fluids.PositionX.begin() + last, _startX.begin() + first);
+		std::copy(fluids.PositionY.begin() + first, fluids.PositionY.begin() + last, _startY.begin() + first);
+		std::copy(fluids.PositionZ.begin() + first, fluids.PositionZ.begin() + last, _startZ.begin() + first);
+
+		fluids.Integrate(integrator, deltaTime, deltaTime, gravity, first, last);
+	});
+}
+
+void PBFSolver::UpdateVelocities(FluidParticleSystem& fluids, JobSystem& jobs, float deltaTime) noexcept
+{
+#ifdef TRACY_ENABLE
+	ZoneScoped;
+#endif
+	const float invDeltaTime = 1.f / deltaTime;
+
+	jobs.ParallelForChunks(0, fluids.Size(), GRAIN_SIZE, [&](const std::size_t first, const std::size_t last)
+	{
+		for (std::size_t i = first; i < last; i++)
+		{
+			fluids.VelocityX[i] = (fluids.PositionX[i] - _startX[i]) * invDeltaTime;
+			fluids.VelocityY[i] = (fluids.PositionY[i] - _startY[i]) * invDeltaTime;
+			fluids.VelocityZ[i] = (fluids.PositionZ[i] - _startZ[i]) * invDeltaTime;
+		}
+	});
+}
+
+void PBFSolver::SolveDensity(FluidParticleSystem& fluids, const NeighborList& neighbors, const BoundaryParticleSystem& boundary,
+	const SPHParams& params, JobSystem& jobs) noexcept
+{
+#ifdef TRACY_ENABLE
+	ZoneScoped;
+#endif
+	const std::size_t count = fluids.Size();
+	_stats.Iterations = 0;
+	_stats.DensityError = 0.f;
+	if (count == 0 || params.RestDensity <= 0.f)
+	{
+		return;
+	}
+
+	_lambdas.resize(count);
+	_deltaX.resize(count);
+	_deltaY.resize(count);
+	_deltaZ.resize(count);
+	_chunkErrors.assign((count + GRAIN_SIZE - 1) / GRAIN_SIZE, {});
+
+	const float invRestDensity = 1.f / params.RestDensity;
+
+	DispatchSmoothingKernel(params.Kernel, [&](auto kernel)
+	{
+		using Kernel = decltype(kernel);
+
+		// Artificial pressure: -k (W(r) / W(dq))^4 pushes apart particles closer than dq, which keeps the
+		// unilateral constraint from clumping them at the free surface
+		const float tensileDistance = TensileDistance * params.SmoothingRadius;
+		const float tensileReference = Kernel::Value(params, tensileDistance, tensileDistance * tensileDistance);
+		const float invTensileReference = tensileReference > 0.f ? 1.f / tensileReference : 0.f;
+
+		// The relaxation and the largest correction are relative to a particle at rest, so they hold whatever the
+		// particle mass, rest density and smoothing radius. The lattice only depends on them and the mean mass, it is
+		// measured again when the particles or the settings change
+		if (!_restLatticeValid || _restLatticeDensity != params.RestDensity || _restLatticeRadius != params.SmoothingRadius
+			|| _restLatticeKernel != params.Kernel)
+		{
+			float mass = 0.f;
+			for (std::size_t i = 0; i < count; i++)
+			{
+				mass += fluids.Mass[i];
+			}
+			const RestLattice lattice = MeasureRestLattice<Kernel>(params, mass / static_cast<float>(count));
+			_restSpacing = lattice.Spacing;
+			_restGradientSum = lattice.GradientSum;
+			_restLatticeDensity = params.RestDensity;
+			_restLatticeRadius = params.SmoothingRadius;
+			_restLatticeKernel = params.Kernel;
+			_restLatticeValid = true;
+		}
+		const float relaxation = Relaxation * _restGradientSum;
+		const float maxCorrection = MaxCorrection * _restSpacing;
+		const float sqrMaxCorrection = maxCorrection * maxCorrection;
+
+		for (std::size_t iteration = 0; iteration < Iterations; iteration++)
+		{
+			jobs.ParallelForChunks(0, count, GRAIN_SIZE, [&](const std::size_t first, const std::size_t last)
+			{
+				double error = 0.0;
+				for (std::size_t i = first; i < last; i++)
+				{
+					float density = fluids.Mass[i] * params.SelfDensity;
+					float sumX = 0.f, sumY = 0.f, sumZ = 0.f, sumSqr = 0.f;
+
+					ForEachInRadius(fluids, neighbors, params, i, [&](std::uint32_t j, float distance, float sqrDistance,
+						float dirX, float dirY, float dirZ)
+					{
+						const float mass = fluids.Mass[j];
+						density += mass * Kernel::Value(params, distance, sqrDistance);
+
+						const float slope = mass * Kernel::Slope(params, distance, sqrDistance);
+						sumX += slope * dirX;
+						sumY += slope * dirY;
+						sumZ += slope * dirZ;
+						sumSqr += slope * slope;
+					});
+					// The boundary adds to the density and to the gradient of i, its own particles never move
+					ForEachBoundaryInRadius(fluids, boundary, params, i, [&](float mass, float distance, float sqrDistance,
+						float dirX, float dirY, float dirZ)
+					{
+						density += mass * Kernel::Value(params, distance, sqrDistance);
+
+						const float slope = mass * Kernel::Slope(params, distance, sqrDistance);
+						sumX += slope * dirX;
+						sumY += slope * dirY;
+						sumZ += slope * dirZ;
+					});
+
+					// Only compression is corrected, a fluid is free to expand
+					const float constraint = std::max(density * invRestDensity - 1.f, 0.f);
+					const float denominator = (sumX * sumX + sumY * sumY + sumZ * sumZ + sumSqr) * invRestDensity * invRestDensity;
+
+					fluids.Density[i] = density;
+					_lambdas[i] = -constraint / (denominator + relaxation);
+					error += constraint;
+				}
+				_chunkErrors[first / GRAIN_SIZE].Sum += error;
+			});
+
+			_stats.DensityError = static_cast<float>(collectError() / count);
+
+			jobs.ParallelFor(0, count, GRAIN_SIZE, [&](const std::size_t i)
+			{
+				float deltaX = 0.f, deltaY = 0.f, deltaZ = 0.f;
+
+				ForEachInRadius(fluids, neighbors, params, i, [&](std::uint32_t j, float distance, float sqrDistance,
+					float dirX, float dirY, float dirZ)
+				{
+					const float ratio = Kernel::Value(params, distance, sqrDistance) * invTensileReference;
+					const float sqrRatio = ratio * ratio;
+					const float correction = -TensileStrength * sqrRatio * sqrRatio;
+
+					const float scale = fluids.Mass[j] * (_lambdas[i] + _lambdas[j] + correction) * Kernel::Slope(params, distance, sqrDistance);
+					deltaX += scale * dirX;
+					deltaY += scale * dirY;
+					deltaZ += scale * dirZ;
+				});
+				// The boundary particles have no multiplier of their own, they push back with the one of i
+				ForEachBoundaryInRadius(fluids, boundary, params, i, [&](float mass, float distance, float sqrDistance,
+					float dirX, float dirY, float dirZ)
+				{
+					const float scale = mass * _lambdas[i] * Kernel::Slope(params, distance, sqrDistance);
+					deltaX += scale * dirX;
+					deltaY += scale * dirY;
+					deltaZ += scale * dirZ;
+				});
+
+				deltaX *= invRestDensity;
+				deltaY *= invRestDensity;
+				deltaZ *= invRestDensity;
+
+				// A deep overlap is resolved over several iterations, a single large jump would overshoot into the next one
+				const float sqrLength = deltaX * deltaX + deltaY * deltaY + deltaZ * deltaZ;
+				const float scale = sqrLength > sqrMaxCorrection ? maxCorrection / std::sqrt(sqrLength) : 1.f;
+				_deltaX[i] = deltaX * scale;
+				_deltaY[i] = deltaY * scale;
+				_deltaZ[i] = deltaZ * scale;
+			});
+
+			// Jacobi: every correction is computed from the same positions before any is applied
+			jobs.ParallelFor(0, count, GRAIN_SIZE, [&](const std::size_t i)
+			{
+				fluids.PositionX[i] += _deltaX[i];
+				fluids.PositionY[i] += _deltaY[i];
+				fluids.PositionZ[i] += _deltaZ[i];
+			});
+			_stats.Iterations++;
+		}
+	});
+}
+
+void PBFSolver::ApplyViscosity(FluidParticleSystem& fluids, const NeighborList& neighbors, const SPHParams& params, JobSystem& jobs) noexcept
+{
+#ifdef TRACY_ENABLE
+	ZoneScoped;
+#endif
+	const std::size_t count = fluids.Size();
+	if (count == 0 || XSPHViscosity <= 0.f)
+	{
+		return;
+	}
+
+	_deltaX.resize(count);
+	_deltaY.resize(count);
+	_deltaZ.resize(count);
+
+	DispatchSmoothingKernel(params.Kernel, [&](auto kernel)
+	{
+		using Kernel = decltype(kernel);
+
+		jobs.ParallelFor(0, count, GRAIN_SIZE, [&](const std::size_t i)
+		{
+			float deltaX = 0.f, deltaY = 0.f, deltaZ = 0.f;
+
+			ForEachInRadius(fluids, neighbors, params, i, [&](std::uint32_t j, float distance, float sqrDistance,
+				float, float, float)
+			{
+				if (fluids.Density[j] <= 0.f) return;
+
+				const float weight = fluids.Mass[j] / fluids.Density[j] * Kernel::Value(params, distance, sqrDistance);
+				deltaX += (fluids.VelocityX[j] - fluids.VelocityX[i]) * weight;
+				deltaY += (fluids.VelocityY[j] - fluids.VelocityY[i]) * weight;
+				deltaZ += (fluids.VelocityZ[j] - fluids.VelocityZ[i]) * weight;
+			});
+
+			_deltaX[i] = XSPHViscosity * deltaX;
+			_deltaY[i] = XSPHViscosity * deltaY;
+			_deltaZ[i] = XSPHViscosity * deltaZ;
+		});
+
+		jobs.ParallelFor(0, count, GRAIN_SIZE, [&](const std::size_t i)
+		{
+			fluids.VelocityX[i] += _deltaX[i];
+			fluids.VelocityY[i] += _deltaY[i];
+			fluids.VelocityZ[i] += _deltaZ[i];
+		});
+	});
+}
+
+double PBFSolver::collectError() noexcept
+{
+	double sum = 0.0;
+	for (auto& error : _chunkErrors)
+	{
+		sum += error.Sum;
+		error.Sum = 0.0;
+	}
+	return sum;
+}
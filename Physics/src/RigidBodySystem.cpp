@@ -0,0 +1,145 @@
+#include "RigidBodySystem.h"
+
+#include <algorithm>
+
+#ifdef TRACY_ENABLE
+#include <Tracy.hpp>
+#include <TracyC.h>
+#endif
+
+void RigidBodySystem::Resize(std::size_t slotCount) noexcept
+{
+	const std::size_t previous = Size();
+	if (slotCount <= previous)
+	{
+		return;
+	}
+
+	PositionX.resize(slotCount);
+	PositionY.resize(slotCount);
+	PositionZ.resize(slotCount);
+	VelocityX.resize(slotCount);
+	VelocityY.resize(slotCount);
+	VelocityZ.resize(slotCount);
+	ForceX.resize(slotCount);
+	ForceY.resize(slotCount);
+	ForceZ.resize(slotCount);
+	Mass.resize(slotCount);
+	InvMass.resize(slotCount);
+	_dynamic.resize(slotCount, 0);
+	_isSynchronous.resize(slotCount, 0);
+
+	for (std::size_t slot = previous; slot < slotCount; slot++)
+	{
+		Reset(static_cast<std::uint32_t>(slot));
+	}
+}
+
+void RigidBodySystem::Clear() noexcept
+{
+	PositionX.clear();
+	PositionY.clear();
+	PositionZ.clear();
+	VelocityX.clear();
+	VelocityY.clear();
+	VelocityZ.clear();
+	ForceX.clear();
+	ForceY.clear();
+	ForceZ.clear();
+	Mass.clear();
+	InvMass.clear();
+	_dynamic.clear();
+	_dynamicChunks.clear();
+	_chunksDirty = false;
+	_synchronous.clear();
+	_isSynchronous.clear();
+}
+
+void RigidBodySystem::Reset(std::uint32_t slot) noexcept
+{
+	SetPosition(slot, XMVectorZero());
+	SetVelocity(slot, XMVectorZero());
+	ResetForce(slot);
+	SetMass(slot, -1.f);
+}
+
+void RigidBodySystem::SetDynamic(std::uint32_t slot, bool dynamic) noexcept
+{
+	const std::uint32_t flag = dynamic ? 1 : 0;
+	if (_dynamic[slot] != flag)
+	{
+		_dynamic[slot] = flag;
+		_chunksDirty = true;
+	}
+
+	// The velocity of a body that was not integrated is not staggered
+	if (dynamic)
+	{
+		markSynchronous(slot);
+	}
+}
+
+void RigidBodySystem::BuildDynamicChunks(std::size_t grainSize) noexcept
+{
+	if (!_chunksDirty)
+	{
+		return;
+	}
+
+#ifdef TRACY_ENABLE
+	ZoneScoped;
+#endif
+	_chunksDirty = false;
+	_dynamicChunks.clear();
+
+	const auto count = static_cast<std::uint32_t>(_dynamic.size());
+	std::uint32_t i = 0;
+	while (i < count)
+	{
+		if (!integrated(i))
+		{
+			i++;
+			continue;
+		}
+
+		// Bodies created together get consecutive slots, so the ranges are long
+		const std::uint32_t first = i;
+		while (i < count && integrated(i) && i - first < grainSize)
+		{
+			i++;
+		}
+		_dynamicChunks.emplace_back(first, i);
+	}
+}
+
+IntegratorColumns RigidBodySystem::columns() noexcept
+{
+	return {
+		PositionX.data(), PositionY.data(), PositionZ.data(),
+		VelocityX.data(), VelocityY.data(), VelocityZ.data(),
+		ForceX.data(), ForceY.data(), ForceZ.data(), InvMass.data() };
+}
+
+void RigidBodySystem::StartStaggeredKicks(const IntegratorTable& integrator, float extraKickTime, float gravity) noexcept
+{
+	const IntegratorColumns rows = columns();
+	for (const std::uint32_t slot : _synchronous)
+	{
+		if (extraKickTime != 0.f && integrated(slot))
+		{
+			integrator.Kick(rows, extraKickTime, gravity, slot, slot + 1);
+		}
+		_isSynchronous[slot] = 0;
+	}
+	_synchronous.clear();
+}
+
+void RigidBodySystem::Integrate(const IntegratorTable& integrator, float kickTime, float deltaTime, float gravity,
+	std::size_t first, std::size_t last) noexcept
+{
+	integrator.KickDrift(columns(), kickTime, deltaTime, gravity, first, last);
+
+	std::fill(ForceX.data() + first, ForceX.data() + last, 0.f);
+	std::fill(ForceY.data() + first, ForceY.data() + last, 0.f);
+	std::fill(ForceZ.data() + first, ForceZ.data() + last, 0.f);
+}
@@ -0,0 +1,407 @@
+#include "SPHKernels.h"
+#include "SPHKernelPolicies.h"
+
+#include <cmath>
+
+#if defined(_M_X64) || defined(_M_IX86) || defined(__x86_64__) || defined(__i386__)
+#define SPH_KERNELS_X86
+#ifdef _MSC_VER
+#include <intrin.h>
+#else
+#include <cpuid.h>
+#endif
+#endif
+
+namespace
+{
+	constexpr float PI_F = 3.14159265358979323846f;
+
+	template<typename Kernel>
+	void DensityScalar(const SPHParticleColumns& c, const SPHParams& k, std::size_t begin, std::size_t end)
+	{
+		for (std::size_t i = begin; i < end; i++)
+		{
+			// The neighbor list excludes the particle itself, its own contribution is the kernel at distance 0
+			float density = k.SelfDensity;
+			float nearDensity = k.SelfNearDensity;
+
+			for (std::uint32_t n = c.NeighborOffsets[i]; n < c.NeighborOffsets[i + 1]; n++)
+			{
+				const std::uint32_t j = c.NeighborIndices[n];
+				const float dx = c.PositionX[i] - c.PositionX[j];
+				const float dy = c.PositionY[i] - c.PositionY[j];
+				const float dz = c.PositionZ[i] - c.PositionZ[j];
+				const float sqrDistance = dx * dx + dy * dy + dz * dz;
+				if (sqrDistance >= k.SqrRadius) continue;
+
+				const float distance = std::sqrt(sqrDistance);
+				const float q = k.SmoothingRadius - distance;
+				density += Kernel::Value(k, distance, sqrDistance);
+				nearDensity += q * q * q * k.NearKernelScale;
+			}
+
+			c.Density[i] = density;
+			c.NearDensity[i] = nearDensity;
+			c.Pressure[i] = (density - k.TargetDensity) * k.PressureMultiplier;
+		}
+	}
+
+	template<typename Kernel>
+	void ForcesScalar(const SPHParticleColumns& c, const SPHParams& k, std::size_t begin, std::size_t end)
+	{
+		for (std::size_t i = begin; i < end; i++)
+		{
+			float pressureX = 0, pressureY = 0, pressureZ = 0;
+			float viscosityX = 0, viscosityY = 0, viscosityZ = 0;
+
+			for (std::uint32_t n = c.NeighborOffsets[i]; n < c.NeighborOffsets[i + 1]; n++)
+			{
+				const std::uint32_t j = c.NeighborIndices[n];
+				float dx = c.PositionX[i] - c.PositionX[j];
+				float dy = c.PositionY[i] - c.PositionY[j];
+				float dz = c.PositionZ[i] - c.PositionZ[j];
+				const float sqrDistance = dx * dx + dy * dy + dz * dz;
+				if (sqrDistance >= k.SqrRadius) continue;
+
+				const float distance = std::sqrt(sqrDistance);
+
+				const float influence = Kernel::Value(k, distance, sqrDistance);
+				viscosityX += (c.VelocityX[j] - c.VelocityX[i]) * influence;
+				viscosityY += (c.VelocityY[j] - c.VelocityY[i]) * influence;
+				viscosityZ += (c.VelocityZ[j] - c.VelocityZ[i]) * influence;
+
+				if (distance == 0)
+				{
+					dx = 0, dy = 1, dz = 0;
+				}
+				else
+				{
+					const float invDistance = 1.f / distance;
+					dx *= invDistance, dy *= invDistance, dz *= invDistance;
+				}
+
+				const float slope = Kernel::Slope(k, distance, sqrDistance);
+				const float sharedPressure = (c.Pressure[i] + c.Pressure[j]) * 0.5f;
+				const float scale = sharedPressure * slope * c.Mass[j] / c.Density[j];
+
+				pressureX += dx * scale;
+				pressureY += dy * scale;
+				pressureZ += dz * scale;
+			}
+
+			const float invDensity = 1.f / c.Density[i];
+			const float viscosityScale = c.Mass[i] * k.ViscosityStrength;
+			c.ForceX[i] += pressureX * invDensity + viscosityX * viscosityScale;
+			c.ForceY[i] += pressureY * invDensity + viscosityY * viscosityScale;
+			c.ForceZ[i] += pressureZ * invDensity + viscosityZ * viscosityScale;
+		}
+	}
+
+	template<typename Kernel>
+	void DensityPairsScalar(const SPHParticleColumns& c, const SPHParams& k,
+		const SPHPairAccumulator& accumulator, std::size_t begin, std::size_t end)
+	{
+		for (std::size_t i = begin; i < end; i++)
+		{
+			float density = 0.f;
+			float nearDensity = 0.f;
+
+			for (std::uint32_t n = c.NeighborOffsets[i]; n < c.NeighborOffsets[i + 1]; n++)
+			{
+				const std::uint32_t j = c.NeighborIndices[n];
+				const float dx = c.PositionX[i] - c.PositionX[j];
+				const float dy = c.PositionY[i] - c.PositionY[j];
+				const float dz = c.PositionZ[i] - c.PositionZ[j];
+				const float sqrDistance = dx * dx + dy * dy + dz * dz;
+				if (sqrDistance >= k.SqrRadius)
+				{
+					accumulator.Density[n] = 0.f;
+					accumulator.NearDensity[n] = 0.f;
+					continue;
+				}
+
+				const float distance = std::sqrt(sqrDistance);
+				const float q = k.SmoothingRadius - distance;
+				const float influence = Kernel::Value(k, distance, sqrDistance);
+				const float nearInfluence = q * q * q * k.NearKernelScale;
+				density += influence;
+				nearDensity += nearInfluence;
+				accumulator.Density[n] = influence;
+				accumulator.NearDensity[n] = nearInfluence;
+			}
+
+			c.Density[i] = density;
+			c.NearDensity[i] = nearDensity;
+		}
+	}
+
+	template<typename Kernel>
+	void ForcePairsScalar(const SPHParticleColumns& c, const SPHParams& k,
+		const SPHPairAccumulator& accumulator, std::size_t begin, std::size_t end)
+	{
+		for (std::size_t i = begin; i < end; i++)
+		{
+			float forceX = 0, forceY = 0, forceZ = 0;
+			const float invDensityI = 1.f / c.Density[i];
+			const float viscosityScaleI = c.Mass[i] * k.ViscosityStrength;
+
+			for (std::uint32_t n = c.NeighborOffsets[i]; n < c.NeighborOffsets[i + 1]; n++)
+			{
+				const std::uint32_t j = c.NeighborIndices[n];
+				float dx = c.PositionX[i] - c.PositionX[j];
+				float dy = c.PositionY[i] - c.PositionY[j];
+				float dz = c.PositionZ[i] - c.PositionZ[j];
+				const float sqrDistance = dx * dx + dy * dy + dz * dz;
+				if (sqrDistance >= k.SqrRadius)
+				{
+					accumulator.ForceX[n] = 0.f;
+					accumulator.ForceY[n] = 0.f;
+					accumulator.ForceZ[n] = 0.f;
+					continue;
+				}
+
+				const float distance = std::sqrt(sqrDistance);
+
+				// Viscosity: F_i = (v_j - v_i) * W * m_i * strength and F_j = (v_i - v_j) * W * m_j * strength
+				const float influence = Kernel::Value(k, distance, sqrDistance);
+				const float relativeX = (c.VelocityX[j] - c.VelocityX[i]) * influence;
+				const float relativeY = (c.VelocityY[j] - c.VelocityY[i]) * influence;
+				const float relativeZ = (c.VelocityZ[j] - c.VelocityZ[i]) * influence;
+				const float viscosityScaleJ = c.Mass[j] * k.ViscosityStrength;
+
+				if (distance == 0)
+				{
+					dx = 0, dy = 1, dz = 0;
+				}
+				else
+				{
+					const float invDistance = 1.f / distance;
+					dx *= invDistance, dy *= invDistance, dz *= invDistance;
+				}
+
+				// Pressure, same terms as the one-sided pass: F_i = dir * s * m_j and F_j = -dir * s * m_i
+				const float slope = Kernel::Slope(k, distance, sqrDistance);
+				const float sharedPressure = (c.Pressure[i] + c.Pressure[j]) * 0.5f;
+				const float scale = sharedPressure * slope * invDensityI / c.Density[j];
+				const float scaleI = scale * c.Mass[j];
+				const float scaleJ = scale * c.Mass[i];
+
+				forceX += dx * scaleI + relativeX * viscosityScaleI;
+				forceY += dy * scaleI + relativeY * viscosityScaleI;
+				forceZ += dz * scaleI + relativeZ * viscosityScaleI;
+				accumulator.ForceX[n] = -(dx * scaleJ + relativeX * viscosityScaleJ);
+				accumulator.ForceY[n] = -(dy * scaleJ + relativeY * viscosityScaleJ);
+				accumulator.ForceZ[n] = -(dz * scaleJ + relativeZ * viscosityScaleJ);
+			}
+
+			c.ForceX[i] += forceX;
+			c.ForceY[i] += forceY;
+			c.ForceZ[i] += forceZ;
+		}
+	}
+
+	// Indexed by SPHSmoothingKernel
+	constexpr SPHKernelTable SCALAR_TABLES[] = {
+		{ "Scalar", &DensityScalar<SpikyKernel>, &ForcesScalar<SpikyKernel> },
+		{ "Scalar", &DensityScalar<Poly6Kernel>, &ForcesScalar<Poly6Kernel> },
+		{ "Scalar", &DensityScalar<WendlandKernel>, &ForcesScalar<WendlandKernel> },
+	};
+
+	constexpr SPHPairKernelTable PAIR_TABLES[] = {
+		{ &DensityPairsScalar<SpikyKernel>, &ForcePairsScalar<SpikyKernel> },
+		{ &DensityPairsScalar<Poly6Kernel>, &ForcePairsScalar<Poly6Kernel> },
+		{ &DensityPairsScalar<WendlandKernel>, &ForcePairsScalar<WendlandKernel> },
+	};
+
+#ifdef SPH_KERNELS_X86
+	struct CpuFeatures
+	{
+		bool Avx2 = false;
+		bool Avx512 = false;
+	};
+
+	void CpuId(int leaf, int subLeaf, unsigned int regs[4]) noexcept
+	{
+#ifdef _MSC_VER
+		int info[4];
+		__cpuidex(info, leaf, subLeaf);
+		for (int i = 0; i < 4; i++) regs[i] = static_cast<unsigned int>(info[i]);
+#else
+		__cpuid_count(leaf, subLeaf, regs[0], regs[1], regs[2], regs[3]);
+#endif
+	}
+
+	unsigned long long ReadXcr0() noexcept
+	{
+#ifdef _MSC_VER
+		return _xgetbv(0);
+#else
+		unsigned int eax, edx;
+		__asm__ volatile("xgetbv" : "=a"(eax), "=d"(edx) : "c"(0));
+		return (static_cast<unsigned long long>(edx) << 32) | eax;
+#endif
+	}
+
+	CpuFeatures DetectCpuFeatures() noexcept
+	{
+		CpuFeatures features;
+		unsigned int regs[4];
+
+		CpuId(0, 0, regs);
+		if (regs[0] < 7)
+		{
+			return features;
+		}
+
+		CpuId(1, 0, regs);
+		const bool osxsave = (regs[2] & (1u << 27)) != 0;
+		const bool avx = (regs[2] & (1u << 28)) != 0;
+		const bool fma = (regs[2] & (1u << 12)) != 0;
+		if (!osxsave || !avx)
+		{
+			return features;
+		}
+
+		// The OS must save the YMM (and ZMM) registers on context switches
+		const unsigned long long xcr0 = ReadXcr0();
+		const bool ymmEnabled = (xcr0 & 0x6) == 0x6;
+		const bool zmmEnabled = (xcr0 & 0xE6) == 0xE6;
+
+		CpuId(7, 0, regs);
+		const bool avx2 = (regs[1] & (1u << 5)) != 0;
+		const bool avx512f = (regs[1] & (1u << 16)) != 0;
+
+		features.Avx2 = ymmEnabled && avx2 && fma;
+		features.Avx512 = zmmEnabled && avx512f && features.Avx2;
+		return features;
+	}
+#endif
+}
+
+SPHParams SPHKernels::MakeParams(float smoothingRadius, float targetDensity, float pressureMultiplier,
+	float viscosityStrength, SPHSmoothingKernel kernel) noexcept
+{
+	SPHParams params;
+	const float h = smoothingRadius;
+	const float sqrH = h * h;
+	const float cubeH = sqrH * h;
+
+	params.SmoothingRadius = h;
+	params.TargetDensity = targetDensity;
+	params.PressureMultiplier = pressureMultiplier;
+	params.ViscosityStrength = viscosityStrength;
+	params.Kernel = kernel;
+
+	params.SqrRadius = sqrH;
+	params.InvRadius = 1.f / h;
+
+	switch (kernel)
+	{
+	case SPHSmoothingKernel::Spiky:
+		params.KernelScale = 6.f / (PI_F * sqrH * sqrH);
+		params.DerivativeScale = 12.f / (PI_F * sqrH * sqrH);
+		params.SelfDensity = sqrH * params.KernelScale;
+		break;
+	case SPHSmoothingKernel::Poly6:
+		params.KernelScale = 315.f / (64.f * PI_F * cubeH * cubeH * cubeH);
+		params.DerivativeScale = 6.f * params.KernelScale;
+		params.SelfDensity = cubeH * cubeH * params.KernelScale;
+		break;
+	case SPHSmoothingKernel::Wendland:
+		params.KernelScale = 21.f / (2.f * PI_F * cubeH);
+		params.DerivativeScale = 20.f * params.KernelScale / h;
+		params.SelfDensity = params.KernelScale;
+		break;
+	}
+
+	params.NearKernelScale = 10.f / (PI_F * sqrH * cubeH);
+	params.SelfNearDensity = cubeH * params.NearKernelScale;
+	return params;
+}
+
+void SPHKernels::FinishDensityPairs(const SPHParticleColumns& c, const SPHParams& k,
+	const SPHPairAccumulator& accumulator, std::size_t begin, std::size_t end) noexcept
+{
+	for (std::size_t i = begin; i < end; i++)
+	{
+		float density = k.SelfDensity + c.Density[i];
+		float nearDensity = k.SelfNearDensity + c.NearDensity[i];
+		for (std::uint32_t r = c.ReverseOffsets[i]; r < c.ReverseOffsets[i + 1]; r++)
+		{
+			const std::uint32_t n = c.ReverseEntries[r];
+			density += accumulator.Density[n];
+			nearDensity += accumulator.NearDensity[n];
+		}
+
+		c.Density[i] = density;
+		c.NearDensity[i] = nearDensity;
+		c.Pressure[i] = (density - k.TargetDensity) * k.PressureMultiplier;
+	}
+}
+
+void SPHKernels::FinishForcePairs(const SPHParticleColumns& c, const SPHPairAccumulator& accumulator,
+	std::size_t begin, std::size_t end) noexcept
+{
+	for (std::size_t i = begin; i < end; i++)
+	{
+		float forceX = 0.f, forceY = 0.f, forceZ = 0.f;
+		for (std::uint32_t r = c.ReverseOffsets[i]; r < c.ReverseOffsets[i + 1]; r++)
+		{
+			const std::uint32_t n = c.ReverseEntries[r];
+			forceX += accumulator.ForceX[n];
+			forceY += accumulator.ForceY[n];
+			forceZ += accumulator.ForceZ[n];
+		}
+
+		c.ForceX[i] += forceX;
+		c.ForceY[i] += forceY;
+		c.ForceZ[i] += forceZ;
+	}
+}
+
+const SPHKernelTable& SPHKernels::Scalar(SPHSmoothingKernel kernel) noexcept
+{
+	return SCALAR_TABLES[static_cast<std::size_t>(kernel)];
+}
+
+const SPHPairKernelTable& SPHKernels::Pairs(SPHSmoothingKernel kernel) noexcept
+{
+	return PAIR_TABLES[static_cast<std::size_t>(kernel)];
+}
+
+bool SPHKernels::HasAVX2() noexcept
+{
+#ifdef SPH_KERNELS_X86
+	static const bool avx2 = DetectCpuFeatures().Avx2;
+	return avx2;
+#else
+	return false;
+#endif
+}
+
+const SPHKernelTable& SPHKernels::Select(SPHSmoothingKernel kernel) noexcept
+{
+	if (kernel != SPHSmoothingKernel::Spiky)
+	{
+		return Scalar(kernel);
+	}
+
+#ifdef SPH_KERNELS_X86
+	static const SPHKernelTable& selected = []() -> const SPHKernelTable&
+	{
+		const CpuFeatures features = DetectCpuFeatures();
+		if (features.Avx512 && AVX512() != nullptr)
+		{
+			return *AVX512();
+		}
+		if (features.Avx2 && AVX2() != nullptr)
+		{
+			return *AVX2();
+		}
+		return Scalar(SPHSmoothingKernel::Spiky);
+	}();
+	return selected;
+#else
+	return Scalar(SPHSmoothingKernel::Spiky);
+#endif
+}
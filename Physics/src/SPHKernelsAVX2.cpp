@@ -0,0 +1,213 @@
+#include "SPHKernels.h"
+
+// Compiled with AVX2 + FMA enabled (see CMakeLists.txt), only called after SPHKernels::Select checked the CPU.
+// MSVC does not define __FMA__, /arch:AVX2 implies it
+#if defined(__AVX2__) && (defined(__FMA__) || defined(_MSC_VER))
+
+#include <immintrin.h>
+
+namespace
+{
+	constexpr int LANES = 8;
+
+	float HorizontalSum(__m256 v) noexcept
+	{
+		const __m128 sum4 = _mm_add_ps(_mm256_castps256_ps128(v), _mm256_extractf128_ps(v, 1));
+		const __m128 sum2 = _mm_add_ps(sum4, _mm_movehl_ps(sum4, sum4));
+		const __m128 sum1 = _mm_add_ss(sum2, _mm_shuffle_ps(sum2, sum2, 0x1));
+		return _mm_cvtss_f32(sum1);
+	}
+
+	__m256 Gather(const float* column, __m256i indices) noexcept
+	{
+		return _mm256_i32gather_ps(column, indices, 4);
+	}
+
+	void DensityAVX2(const SPHParticleColumns& c, const SPHParams& k, std::size_t begin, std::size_t end)
+	{
+		const __m256 radius = _mm256_set1_ps(k.SmoothingRadius);
+		const __m256 sqrRadius = _mm256_set1_ps(k.SqrRadius);
+		const __m256 kernelScale = _mm256_set1_ps(k.KernelScale);
+		const __m256 nearKernelScale = _mm256_set1_ps(k.NearKernelScale);
+
+		for (std::size_t i = begin; i < end; i++)
+		{
+			const __m256 xi = _mm256_set1_ps(c.PositionX[i]);
+			const __m256 yi = _mm256_set1_ps(c.PositionY[i]);
+			const __m256 zi = _mm256_set1_ps(c.PositionZ[i]);
+			__m256 sum = _mm256_setzero_ps();
+			__m256 nearSum = _mm256_setzero_ps();
+
+			const std::uint32_t last = c.NeighborOffsets[i + 1];
+			std::uint32_t n = c.NeighborOffsets[i];
+
+			for (; n + LANES <= last; n += LANES)
+			{
+				const __m256i j = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(c.NeighborIndices + n));
+				const __m256 dx = _mm256_sub_ps(xi, Gather(c.PositionX, j));
+				const __m256 dy = _mm256_sub_ps(yi, Gather(c.PositionY, j));
+				const __m256 dz = _mm256_sub_ps(zi, Gather(c.PositionZ, j));
+				const __m256 sqrDistance = _mm256_fmadd_ps(dx, dx, _mm256_fmadd_ps(dy, dy, _mm256_mul_ps(dz, dz)));
+
+				const __m256 inRadius = _mm256_cmp_ps(sqrDistance, sqrRadius, _CMP_LT_OQ);
+				if (_mm256_movemask_ps(inRadius) == 0) continue;
+
+				const __m256 q = _mm256_and_ps(_mm256_sub_ps(radius, _mm256_sqrt_ps(sqrDistance)), inRadius);
+				const __m256 sqrQ = _mm256_mul_ps(q, q);
+				sum = _mm256_fmadd_ps(sqrQ, kernelScale, sum);
+				nearSum = _mm256_fmadd_ps(_mm256_mul_ps(sqrQ, q), nearKernelScale, nearSum);
+			}
+
+			// The neighbor list excludes the particle itself, its own contribution is the kernel at distance 0
+			float density = k.SelfDensity + HorizontalSum(sum);
+			float nearDensity = k.SelfNearDensity + HorizontalSum(nearSum);
+
+			for (; n < last; n++)
+			{
+				const std::uint32_t j = c.NeighborIndices[n];
+				const float dx = c.PositionX[i] - c.PositionX[j];
+				const float dy = c.PositionY[i] - c.PositionY[j];
+				const float dz = c.PositionZ[i] - c.PositionZ[j];
+				const float sqrDistance = dx * dx + dy * dy + dz * dz;
+				if (sqrDistance >= k.SqrRadius) continue;
+
+				const float q = k.SmoothingRadius - _mm_cvtss_f32(_mm_sqrt_ss(_mm_set_ss(sqrDistance)));
+				density += q * q * k.KernelScale;
+				nearDensity += q * q * q * k.NearKernelScale;
+			}
+
+			c.Density[i] = density;
+			c.NearDensity[i] = nearDensity;
+			c.Pressure[i] = (density - k.TargetDensity) * k.PressureMultiplier;
+		}
+	}
+
+	void ForcesAVX2(const SPHParticleColumns& c, const SPHParams& k, std::size_t begin, std::size_t end)
+	{
+		const __m256 zero = _mm256_setzero_ps();
+		const __m256 one = _mm256_set1_ps(1.f);
+		const __m256 half = _mm256_set1_ps(0.5f);
+		const __m256 radius = _mm256_set1_ps(k.SmoothingRadius);
+		const __m256 sqrRadius = _mm256_set1_ps(k.SqrRadius);
+		const __m256 kernelScale = _mm256_set1_ps(k.KernelScale);
+		const __m256 negDerivativeScale = _mm256_set1_ps(-k.DerivativeScale);
+
+		for (std::size_t i = begin; i < end; i++)
+		{
+			const __m256 xi = _mm256_set1_ps(c.PositionX[i]);
+			const __m256 yi = _mm256_set1_ps(c.PositionY[i]);
+			const __m256 zi = _mm256_set1_ps(c.PositionZ[i]);
+			const __m256 vxi = _mm256_set1_ps(c.VelocityX[i]);
+			const __m256 vyi = _mm256_set1_ps(c.VelocityY[i]);
+			const __m256 vzi = _mm256_set1_ps(c.VelocityZ[i]);
+			const __m256 pressureI = _mm256_set1_ps(c.Pressure[i]);
+			__m256 pressureX = zero, pressureY = zero, pressureZ = zero;
+			__m256 viscosityX = zero, viscosityY = zero, viscosityZ = zero;
+
+			const std::uint32_t last = c.NeighborOffsets[i + 1];
+			std::uint32_t n = c.NeighborOffsets[i];
+
+			for (; n + LANES <= last; n += LANES)
+			{
+				const __m256i j = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(c.NeighborIndices + n));
+				const __m256 dx = _mm256_sub_ps(xi, Gather(c.PositionX, j));
+				const __m256 dy = _mm256_sub_ps(yi, Gather(c.PositionY, j));
+				const __m256 dz = _mm256_sub_ps(zi, Gather(c.PositionZ, j));
+				const __m256 sqrDistance = _mm256_fmadd_ps(dx, dx, _mm256_fmadd_ps(dy, dy, _mm256_mul_ps(dz, dz)));
+
+				const __m256 inRadius = _mm256_cmp_ps(sqrDistance, sqrRadius, _CMP_LT_OQ);
+				if (_mm256_movemask_ps(inRadius) == 0) continue;
+
+				const __m256 distance = _mm256_sqrt_ps(sqrDistance);
+				const __m256 q = _mm256_and_ps(_mm256_sub_ps(radius, distance), inRadius);
+
+				// Viscosity, q is zeroed outside of the radius so the influence is too
+				const __m256 influence = _mm256_mul_ps(_mm256_mul_ps(q, q), kernelScale);
+				viscosityX = _mm256_fmadd_ps(_mm256_sub_ps(Gather(c.VelocityX, j), vxi), influence, viscosityX);
+				viscosityY = _mm256_fmadd_ps(_mm256_sub_ps(Gather(c.VelocityY, j), vyi), influence, viscosityY);
+				viscosityZ = _mm256_fmadd_ps(_mm256_sub_ps(Gather(c.VelocityZ, j), vzi), influence, viscosityZ);
+
+				// Pressure, coincident particles are pushed apart along +Y
+				const __m256 nonZero = _mm256_cmp_ps(distance, zero, _CMP_GT_OQ);
+				const __m256 invDistance = _mm256_div_ps(one, distance);
+				const __m256 dirX = _mm256_and_ps(_mm256_mul_ps(dx, invDistance), nonZero);
+				const __m256 dirY = _mm256_blendv_ps(one, _mm256_mul_ps(dy, invDistance), nonZero);
+				const __m256 dirZ = _mm256_and_ps(_mm256_mul_ps(dz, invDistance), nonZero);
+
+				const __m256 slope = _mm256_mul_ps(q, negDerivativeScale);
+				const __m256 sharedPressure = _mm256_mul_ps(_mm256_add_ps(pressureI, Gather(c.Pressure, j)), half);
+				const __m256 massOverDensity = _mm256_div_ps(Gather(c.Mass, j), Gather(c.Density, j));
+				const __m256 scale = _mm256_mul_ps(_mm256_mul_ps(sharedPressure, slope), massOverDensity);
+
+				pressureX = _mm256_fmadd_ps(dirX, scale, pressureX);
+				pressureY = _mm256_fmadd_ps(dirY, scale, pressureY);
+				pressureZ = _mm256_fmadd_ps(dirZ, scale, pressureZ);
+			}
+
+			float forcePressureX = HorizontalSum(pressureX);
+			float forcePressureY = HorizontalSum(pressureY);
+			float forcePressureZ = HorizontalSum(pressureZ);
+			float forceViscosityX = HorizontalSum(viscosityX);
+			float forceViscosityY = HorizontalSum(viscosityY);
+			float forceViscosityZ = HorizontalSum(viscosityZ);
+
+			for (; n < last; n++)
+			{
+				const std::uint32_t j = c.NeighborIndices[n];
+				float dx = c.PositionX[i] - c.PositionX[j];
+				float dy = c.PositionY[i] - c.PositionY[j];
+				float dz = c.PositionZ[i] - c.PositionZ[j];
+				const float sqrDistance = dx * dx + dy * dy + dz * dz;
+				if (sqrDistance >= k.SqrRadius) continue;
+
+				const float distance = _mm_cvtss_f32(_mm_sqrt_ss(_mm_set_ss(sqrDistance)));
+				const float q = k.SmoothingRadius - distance;
+
+				const float influence = q * q * k.KernelScale;
+				forceViscosityX += (c.VelocityX[j] - c.VelocityX[i]) * influence;
+				forceViscosityY += (c.VelocityY[j] - c.VelocityY[i]) * influence;
+				forceViscosityZ += (c.VelocityZ[j] - c.VelocityZ[i]) * influence;
+
+				if (distance == 0)
+				{
+					dx = 0, dy = 1, dz = 0;
+				}
+				else
+				{
+					const float invDistance = 1.f / distance;
+					dx *= invDistance, dy *= invDistance, dz *= invDistance;
+				}
+
+				const float slope = -q * k.DerivativeScale;
+				const float sharedPressure = (c.Pressure[i] + c.Pressure[j]) * 0.5f;
+				const float scale = sharedPressure * slope * c.Mass[j] / c.Density[j];
+
+				forcePressureX += dx * scale;
+				forcePressureY += dy * scale;
+				forcePressureZ += dz * scale;
+			}
+
+			const float invDensity = 1.f / c.Density[i];
+			const float viscosityScale = c.Mass[i] * k.ViscosityStrength;
+			c.ForceX[i] += forcePressureX * invDensity + forceViscosityX * viscosityScale;
+			c.ForceY[i] += forcePressureY * invDensity + forceViscosityY * viscosityScale;
+			c.ForceZ[i] += forcePressureZ * invDensity + forceViscosityZ * viscosityScale;
+		}
+	}
+
+	constexpr SPHKernelTable AVX2_TABLE{ "AVX2", &DensityAVX2, &ForcesAVX2 };
+}
+
+const SPHKernelTable* SPHKernels::AVX2() noexcept
+{
+	return &AVX2_TABLE;
+}
+
+#else
+
+const SPHKernelTable* SPHKernels::AVX2() noexcept
+{
+	return nullptr;
+}
+
+#endif
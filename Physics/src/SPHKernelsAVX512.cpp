@@ -0,0 +1,155 @@
+#include "SPHKernels.h"
+
+// Compiled with AVX-512F enabled (see CMakeLists.txt), only called after SPHKernels::Select checked the CPU.
+#if defined(__AVX512F__)
+
+#include <immintrin.h>
+
+namespace
+{
+	constexpr std::uint32_t LANES = 16;
+
+	/**
+	 * @brief Mask of the lanes of the batch starting at n that hold a neighbor, the last batch is partial.
+	 */
+	__mmask16 BatchMask(std::uint32_t n, std::uint32_t last) noexcept
+	{
+		const std::uint32_t count = last - n;
+		return count >= LANES ? static_cast<__mmask16>(0xFFFF) : static_cast<__mmask16>((1u << count) - 1);
+	}
+
+	__m512 Gather(const float* column, __m512i indices, __mmask16 mask) noexcept
+	{
+		return _mm512_mask_i32gather_ps(_mm512_setzero_ps(), mask, indices, column, 4);
+	}
+
+	void DensityAVX512(const SPHParticleColumns& c, const SPHParams& k, std::size_t begin, std::size_t end)
+	{
+		const __m512 radius = _mm512_set1_ps(k.SmoothingRadius);
+		const __m512 sqrRadius = _mm512_set1_ps(k.SqrRadius);
+		const __m512 kernelScale = _mm512_set1_ps(k.KernelScale);
+		const __m512 nearKernelScale = _mm512_set1_ps(k.NearKernelScale);
+
+		for (std::size_t i = begin; i < end; i++)
+		{
+			const __m512 xi = _mm512_set1_ps(c.PositionX[i]);
+			const __m512 yi = _mm512_set1_ps(c.PositionY[i]);
+			const __m512 zi = _mm512_set1_ps(c.PositionZ[i]);
+			__m512 sum = _mm512_setzero_ps();
+			__m512 nearSum = _mm512_setzero_ps();
+
+			const std::uint32_t last = c.NeighborOffsets[i + 1];
+
+			for (std::uint32_t n = c.NeighborOffsets[i]; n < last; n += LANES)
+			{
+				const __mmask16 valid = BatchMask(n, last);
+				const __m512i j = _mm512_maskz_loadu_epi32(valid, c.NeighborIndices + n);
+				const __m512 dx = _mm512_sub_ps(xi, Gather(c.PositionX, j, valid));
+				const __m512 dy = _mm512_sub_ps(yi, Gather(c.PositionY, j, valid));
+				const __m512 dz = _mm512_sub_ps(zi, Gather(c.PositionZ, j, valid));
+				const __m512 sqrDistance = _mm512_fmadd_ps(dx, dx, _mm512_fmadd_ps(dy, dy, _mm512_mul_ps(dz, dz)));
+
+				const __mmask16 inRadius = _mm512_mask_cmp_ps_mask(valid, sqrDistance, sqrRadius, _CMP_LT_OQ);
+				if (inRadius == 0) continue;
+
+				const __m512 q = _mm512_sub_ps(radius, _mm512_sqrt_ps(sqrDistance));
+				const __m512 sqrQ = _mm512_mul_ps(q, q);
+				sum = _mm512_mask3_fmadd_ps(sqrQ, kernelScale, sum, inRadius);
+				nearSum = _mm512_mask3_fmadd_ps(_mm512_mul_ps(sqrQ, q), nearKernelScale, nearSum, inRadius);
+			}
+
+			// The neighbor list excludes the particle itself, its own contribution is the kernel at distance 0
+			const float density = k.SelfDensity + _mm512_reduce_add_ps(sum);
+
+			c.Density[i] = density;
+			c.NearDensity[i] = k.SelfNearDensity + _mm512_reduce_add_ps(nearSum);
+			c.Pressure[i] = (density - k.TargetDensity) * k.PressureMultiplier;
+		}
+	}
+
+	void ForcesAVX512(const SPHParticleColumns& c, const SPHParams& k, std::size_t begin, std::size_t end)
+	{
+		const __m512 zero = _mm512_setzero_ps();
+		const __m512 one = _mm512_set1_ps(1.f);
+		const __m512 half = _mm512_set1_ps(0.5f);
+		const __m512 radius = _mm512_set1_ps(k.SmoothingRadius);
+		const __m512 sqrRadius = _mm512_set1_ps(k.SqrRadius);
+		const __m512 kernelScale = _mm512_set1_ps(k.KernelScale);
+		const __m512 negDerivativeScale = _mm512_set1_ps(-k.DerivativeScale);
+
+		for (std::size_t i = begin; i < end; i++)
+		{
+			const __m512 xi = _mm512_set1_ps(c.PositionX[i]);
+			const __m512 yi = _mm512_set1_ps(c.PositionY[i]);
+			const __m512 zi = _mm512_set1_ps(c.PositionZ[i]);
+			const __m512 vxi = _mm512_set1_ps(c.VelocityX[i]);
+			const __m512 vyi = _mm512_set1_ps(c.VelocityY[i]);
+			const __m512 vzi = _mm512_set1_ps(c.VelocityZ[i]);
+			const __m512 pressureI = _mm512_set1_ps(c.Pressure[i]);
+			__m512 pressureX = zero, pressureY = zero, pressureZ = zero;
+			__m512 viscosityX = zero, viscosityY = zero, viscosityZ = zero;
+
+			const std::uint32_t last = c.NeighborOffsets[i + 1];
+
+			for (std::uint32_t n = c.NeighborOffsets[i]; n < last; n += LANES)
+			{
+				const __mmask16 valid = BatchMask(n, last);
+				const __m512i j = _mm512_maskz_loadu_epi32(valid, c.NeighborIndices + n);
+				const __m512 dx = _mm512_sub_ps(xi, Gather(c.PositionX, j, valid));
+				const __m512 dy = _mm512_sub_ps(yi, Gather(c.PositionY, j, valid));
+				const __m512 dz = _mm512_sub_ps(zi, Gather(c.PositionZ, j, valid));
+				const __m512 sqrDistance = _mm512_fmadd_ps(dx, dx, _mm512_fmadd_ps(dy, dy, _mm512_mul_ps(dz, dz)));
+
+				const __mmask16 inRadius = _mm512_mask_cmp_ps_mask(valid, sqrDistance, sqrRadius, _CMP_LT_OQ);
+				if (inRadius == 0) continue;
+
+				const __m512 distance = _mm512_sqrt_ps(sqrDistance);
+				const __m512 q = _mm512_sub_ps(radius, distance);
+
+				// Viscosity
+				const __m512 influence = _mm512_mul_ps(_mm512_mul_ps(q, q), kernelScale);
+				viscosityX = _mm512_mask3_fmadd_ps(_mm512_sub_ps(Gather(c.VelocityX, j, inRadius), vxi), influence, viscosityX, inRadius);
+				viscosityY = _mm512_mask3_fmadd_ps(_mm512_sub_ps(Gather(c.VelocityY, j, inRadius), vyi), influence, viscosityY, inRadius);
+				viscosityZ = _mm512_mask3_fmadd_ps(_mm512_sub_ps(Gather(c.VelocityZ, j, inRadius), vzi), influence, viscosityZ, inRadius);
+
+				// Pressure, coincident particles are pushed apart along +Y
+				const __mmask16 nonZero = _mm512_cmp_ps_mask(distance, zero, _CMP_GT_OQ);
+				const __m512 invDistance = _mm512_div_ps(one, distance);
+				const __m512 dirX = _mm512_maskz_mul_ps(nonZero, dx, invDistance);
+				const __m512 dirY = _mm512_mask_mul_ps(one, nonZero, dy, invDistance);
+				const __m512 dirZ = _mm512_maskz_mul_ps(nonZero, dz, invDistance);
+
+				const __m512 slope = _mm512_mul_ps(q, negDerivativeScale);
+				const __m512 sharedPressure = _mm512_mul_ps(_mm512_add_ps(pressureI, Gather(c.Pressure, j, inRadius)), half);
+				const __m512 massOverDensity = _mm512_maskz_div_ps(inRadius, Gather(c.Mass, j, inRadius), Gather(c.Density, j, inRadius));
+				const __m512 scale = _mm512_mul_ps(_mm512_mul_ps(sharedPressure, slope), massOverDensity);
+
+				pressureX = _mm512_mask3_fmadd_ps(dirX, scale, pressureX, inRadius);
+				pressureY = _mm512_mask3_fmadd_ps(dirY, scale, pressureY, inRadius);
+				pressureZ = _mm512_mask3_fmadd_ps(dirZ, scale, pressureZ, inRadius);
+			}
+
+			const float invDensity = 1.f / c.Density[i];
+			const float viscosityScale = c.Mass[i] * k.ViscosityStrength;
+			c.ForceX[i] += _mm512_reduce_add_ps(pressureX) * invDensity + _mm512_reduce_add_ps(viscosityX) * viscosityScale;
+			c.ForceY[i] += _mm512_reduce_add_ps(pressureY) * invDensity + _mm512_reduce_add_ps(viscosityY) * viscosityScale;
+			c.ForceZ[i] += _mm512_reduce_add_ps(pressureZ) * invDensity + _mm512_reduce_add_ps(viscosityZ) * viscosityScale;
+		}
+	}
+
+	constexpr SPHKernelTable AVX512_TABLE{ "AVX-512", &DensityAVX512, &ForcesAVX512 };
+}
+
+const SPHKernelTable* SPHKernels::AVX512() noexcept
+{
+	return &AVX512_TABLE;
+}
+
+#else
+
+const SPHKernelTable* SPHKernels::AVX512() noexcept
+{
+	return nullptr;
+}
+
+#endif
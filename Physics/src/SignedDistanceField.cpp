@@ -0,0 +1,292 @@
+#include "SignedDistanceField.h"
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+
+#ifdef TRACY_ENABLE
+#include <Tracy.hpp>
+#include <TracyC.h>
+#endif
+
+namespace
+{
+	/**
+	 * @brief Exact signed distance to a solid box, negative inside.
+	 */
+	float SolidBoxDistance(const float* min, const float* max, float x, float y, float z) noexcept
+	{
+		const float p[3] = { x, y, z };
+		float outside = 0.f;
+		float inside = -std::numeric_limits<float>::max();
+		for (int a = 0; a < 3; a++)
+		{
+			const float center = (min[a] + max[a]) * 0.5f;
+			const float q = std::abs(p[a] - center) - (max[a] - min[a]) * 0.5f;
+			outside += std::max(q, 0.f) * std::max(q, 0.f);
+			inside = std::max(inside, q);
+		}
+		return std::sqrt(outside) + std::min(inside, 0.f);
+	}
+
+	int FloorDiv(int value, int divisor) noexcept
+	{
+		return value >= 0 ? value / divisor : -((-value + divisor - 1) / divisor);
+	}
+}
+
+std::uint64_t SignedDistanceField::BrickKey(int x, int y, int z) noexcept
+{
+	// 21 bits per coordinate, offset so negative bricks stay distinct
+	constexpr std::uint64_t MASK = 0x1FFFFF;
+	constexpr int OFFSET = 1 << 20;
+	return (static_cast<std::uint64_t>(x + OFFSET) & MASK) |
+		((static_cast<std::uint64_t>(y + OFFSET) & MASK) << 21) |
+		((static_cast<std::uint64_t>(z + OFFSET) & MASK) << 42);
+}
+
+void SignedDistanceField::AddCuboid(const CuboidF& box, bool container, bool analytic) noexcept
+{
+	const Box shape{
+		{ XMVectorGetX(box.MinBound()), XMVectorGetY(box.MinBound()), XMVectorGetZ(box.MinBound()) },
+		{ XMVectorGetX(box.MaxBound()), XMVectorGetY(box.MaxBound()), XMVectorGetZ(box.MaxBound()) },
+		container };
+
+	if (container && analytic)
+	{
+		_analyticContainers.push_back(shape);
+		return;
+	}
+
+	_boxes.push_back(shape);
+	_dirty = true;
+}
+
+void SignedDistanceField::AddSphere(const SphereF& sphere) noexcept
+{
+	_balls.push_back({ { XMVectorGetX(sphere.Center()), XMVectorGetY(sphere.Center()), XMVectorGetZ(sphere.Center()) }, sphere.Radius() });
+	_dirty = true;
+}
+
+void SignedDistanceField::Clear() noexcept
+{
+	_boxes.clear();
+	_balls.clear();
+	_analyticContainers.clear();
+	_brickOfKey.clear();
+	_distances.clear();
+	_bakedCellSize = 0.f;
+	_dirty = false;
+}
+
+float SignedDistanceField::shapeDistance(float x, float y, float z) const noexcept
+{
+	float distance = std::numeric_limits<float>::max();
+	for (const Box& box : _boxes)
+	{
+		const float boxDistance = SolidBoxDistance(box.Min, box.Max, x, y, z);
+		distance = std::min(distance, box.Container ? -boxDistance : boxDistance);
+	}
+	for (const Ball& ball : _balls)
+	{
+		const float dx = x - ball.Center[0], dy = y - ball.Center[1], dz = z - ball.Center[2];
+		distance = std::min(distance, std::sqrt(dx * dx + dy * dy + dz * dz) - ball.Radius);
+	}
+	return distance;
+}
+
+void SignedDistanceField::Bake() noexcept
+{
+#ifdef TRACY_ENABLE
+	ZoneScoped;
+#endif
+	if (!_dirty && _bakedCellSize == CellSize)
+	{
+		return;
+	}
+
+	_brickOfKey.clear();
+	_distances.clear();
+	_bakedCellSize = CellSize;
+	_dirty = false;
+
+	// A surface crossing a brick is always closer than a cell diagonal to one of its nodes
+	const float band = std::max(Band, CellSize * 2.f);
+	const float brickSize = CellSize * BRICK_CELLS;
+	constexpr std::size_t BRICK_SIZE = BRICK_NODES * BRICK_NODES * BRICK_NODES;
+
+	auto bakeBounds = [&](const float* min, const float* max)
+	{
+		int first[3], last[3];
+		for (int a = 0; a < 3; a++)
+		{
+			first[a] = static_cast<int>(std::floor((min[a] - band) / brickSize));
+			last[a] = static_cast<int>(std::floor((max[a] + band) / brickSize));
+		}
+
+		for (int bx = first[0]; bx <= last[0]; bx++)
+		{
+			for (int by = first[1]; by <= last[1]; by++)
+			{
+				for (int bz = first[2]; bz <= last[2]; bz++)
+				{
+					const std::uint64_t key = BrickKey(bx, by, bz);
+					if (_brickOfKey.count(key) != 0)
+					{
+						continue;
+					}
+
+					const std::size_t start = _distances.size();
+					_distances.resize(start + BRICK_SIZE);
+
+					float nearest = std::numeric_limits<float>::max();
+					std::size_t node = start;
+					for (int i = 0; i < BRICK_NODES; i++)
+					{
+						for (int j = 0; j < BRICK_NODES; j++)
+						{
+							for (int k = 0; k < BRICK_NODES; k++)
+							{
+								const float distance = shapeDistance((bx * BRICK_CELLS + i) * CellSize,
+									(by * BRICK_CELLS + j) * CellSize, (bz * BRICK_CELLS + k) * CellSize);
+								_distances[node++] = distance;
+								nearest = std::min(nearest, std::abs(distance));
+							}
+						}
+					}
+
+					// Bricks away from every surface read as free space, they are not kept
+					if (nearest >= band)
+					{
+						_distances.resize(start);
+						continue;
+					}
+					_brickOfKey.emplace(key, static_cast<std::uint32_t>(start / BRICK_SIZE));
+				}
+			}
+		}
+	};
+
+	for (const Box& box : _boxes)
+	{
+		bakeBounds(box.Min, box.Max);
+	}
+	for (const Ball& ball : _balls)
+	{
+		const float min[3] = { ball.Center[0] - ball.Radius, ball.Center[1] - ball.Radius, ball.Center[2] - ball.Radius };
+		const float max[3] = { ball.Center[0] + ball.Radius, ball.Center[1] + ball.Radius, ball.Center[2] + ball.Radius };
+		bakeBounds(min, max);
+	}
+}
+
+float SignedDistanceField::Sample(float x, float y, float z, float& gradientX, float& gradientY, float& gradientZ) const noexcept
+{
+	float distance = Band;
+	gradientX = gradientY = gradientZ = 0.f;
+
+	if (!_brickOfKey.empty())
+	{
+		const float invCellSize = 1.f / _bakedCellSize;
+		const float gx = x * invCellSize, gy = y * invCellSize, gz = z * invCellSize;
+		const int ix = static_cast<int>(std::floor(gx)), iy = static_cast<int>(std::floor(gy)), iz = static_cast<int>(std::floor(gz));
+		const int bx = FloorDiv(ix, BRICK_CELLS), by = FloorDiv(iy, BRICK_CELLS), bz = FloorDiv(iz, BRICK_CELLS);
+
+		const auto it = _brickOfKey.find(BrickKey(bx, by, bz));
+		if (it != _brickOfKey.end())
+		{
+			// The brick stores the far corner nodes too, the 8 corners of the cell are always in it
+			const int i = ix - bx * BRICK_CELLS, j = iy - by * BRICK_CELLS, k = iz - bz * BRICK_CELLS;
+			const float* nodes = _distances.data() + static_cast<std::size_t>(it->second) * BRICK_NODES * BRICK_NODES * BRICK_NODES;
+			auto at = [nodes](int a, int b, int c) noexcept { return nodes[(a * BRICK_NODES + b) * BRICK_NODES + c]; };
+
+			const float fx = gx - ix, fy = gy - iy, fz = gz - iz;
+			const float c000 = at(i, j, k), c001 = at(i, j, k + 1), c010 = at(i, j + 1, k), c011 = at(i, j + 1, k + 1);
+			const float c100 = at(i + 1, j, k), c101 = at(i + 1, j, k + 1), c110 = at(i + 1, j + 1, k), c111 = at(i + 1, j + 1, k + 1);
+
+			// Trilinear value and its exact partial derivatives
+			const float c00 = c000 + (c001 - c000) * fz, c01 = c010 + (c011 - c010) * fz;
+			const float c10 = c100 + (c101 - c100) * fz, c11 = c110 + (c111 - c110) * fz;
+			const float c0 = c00 + (c01 - c00) * fy, c1 = c10 + (c11 - c10) * fy;
+			distance = c0 + (c1 - c0) * fx;
+
+			gradientX = (c1 - c0) * invCellSize;
+			gradientY = ((c01 - c00) + ((c11 - c10) - (c01 - c00)) * fx) * invCellSize;
+			const float dz00 = c001 - c000, dz01 = c011 - c010, dz10 = c101 - c100, dz11 = c111 - c110;
+			const float dz0 = dz00 + (dz01 - dz00) * fy, dz1 = dz10 + (dz11 - dz10) * fy;
+			gradientZ = (dz0 + (dz1 - dz0) * fx) * invCellSize;
+		}
+	}
+
+	const float p[3] = { x, y, z };
+	for (const Box& box : _analyticContainers)
+	{
+		// The closest face of the box, negative once the point left it
+		for (int a = 0; a < 3; a++)
+		{
+			const float toMin = p[a] - box.Min[a];
+			const float toMax = box.Max[a] - p[a];
+			const float faceDistance = std::min(toMin, toMax);
+			if (faceDistance < distance)
+			{
+				distance = faceDistance;
+				gradientX = gradientY = gradientZ = 0.f;
+				const float direction = toMin < toMax ? 1.f : -1.f;
+				(a == 0 ? gradientX : a == 1 ? gradientY : gradientZ) = direction;
+			}
+		}
+	}
+
+	return distance;
+}
+
+void SignedDistanceField::Resolve(FluidParticleSystem& fluids, JobSystem& jobs, std::size_t grainSize) const noexcept
+{
+#ifdef TRACY_ENABLE
+	ZoneScoped;
+#endif
+	if (Empty())
+	{
+		return;
+	}
+
+	jobs.ParallelForChunks(0, fluids.Size(), grainSize, [&](const std::size_t first, const std::size_t last)
+	{
+		for (std::size_t i = first; i < last; i++)
+		{
+			float normalX, normalY, normalZ;
+			const float distance = Sample(fluids.PositionX[i], fluids.PositionY[i], fluids.PositionZ[i], normalX, normalY, normalZ);
+			if (distance >= ParticleRadius)
+			{
+				continue;
+			}
+
+			const float length = std::sqrt(normalX * normalX + normalY * normalY + normalZ * normalZ);
+			if (length == 0.f)
+			{
+				continue;
+			}
+			normalX /= length, normalY /= length, normalZ /= length;
+
+			const float push = ParticleRadius - distance;
+			fluids.PositionX[i] += normalX * push;
+			fluids.PositionY[i] += normalY * push;
+			fluids.PositionZ[i] += normalZ * push;
+
+			const float normalSpeed = fluids.VelocityX[i] * normalX + fluids.VelocityY[i] * normalY + fluids.VelocityZ[i] * normalZ;
+			if (normalSpeed >= 0.f)
+			{
+				continue;
+			}
+
+			// Reflect the normal velocity by the restitution and damp the tangential one by the friction
+			const float tangentX = fluids.VelocityX[i] - normalSpeed * normalX;
+			const float tangentY = fluids.VelocityY[i] - normalSpeed * normalY;
+			const float tangentZ = fluids.VelocityZ[i] - normalSpeed * normalZ;
+			const float keep = 1.f - Friction;
+			const float reflected = -normalSpeed * Restitution;
+			fluids.VelocityX[i] = tangentX * keep + normalX * reflected;
+			fluids.VelocityY[i] = tangentY * keep + normalY * reflected;
+			fluids.VelocityZ[i] = tangentZ * keep + normalZ * reflected;
+		}
+	});
+}
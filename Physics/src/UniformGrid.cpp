@@ -0,0 +1,68 @@
+#include "UniformGrid.h"
+
+#ifdef TRACY_ENABLE
+#include <Tracy.hpp>
+#include <TracyC.h>
+#endif
+
+void UniformGrid::Build(const float* x, const float* y, const float* z, std::size_t count, float cellSize, JobSystem& jobs) noexcept
+{
+#ifdef TRACY_ENABLE
+	ZoneScoped;
+#endif
+	constexpr std::size_t GRAIN_SIZE = 4096; /**< Particles or slots processed by one job, the passes are bandwidth bound. */
+
+	_cellSize = cellSize;
+	_invCellSize = 1.f / cellSize;
+
+	// Twice as many slots as particles, rounded to a power of two, keeps the slots short
+	std::size_t tableSize = 1;
+	while (tableSize < count * 2)
+	{
+		tableSize <<= 1;
+	}
+	_tableMask = static_cast<std::uint32_t>(tableSize - 1);
+
+	CellStart.resize(tableSize);
+	CellEnd.resize(tableSize);
+	ParticleSlots.resize(count);
+
+	jobs.ParallelFor(0, count, GRAIN_SIZE, [&](const std::size_t i)
+	{
+		ParticleSlots[i] = Slot(CellCoord(x[i]), CellCoord(y[i]), CellCoord(z[i]));
+	});
+
+	// Stable, so the particles of a slot stay in increasing order
+	_sort.Sort(ParticleSlots.data(), count, _tableMask, jobs);
+	SortedIndices.swap(_sort.Order);
+
+	// Empty slots get an empty range, the others are delimited where the sorted slot changes
+	jobs.ParallelFor(0, tableSize, GRAIN_SIZE, [&](const std::size_t slot)
+	{
+		CellStart[slot] = 0;
+		CellEnd[slot] = 0;
+	});
+
+	const std::uint32_t* sortedSlots = _sort.SortedKeys.data();
+	jobs.ParallelFor(0, count, GRAIN_SIZE, [&](const std::size_t s)
+	{
+		const std::uint32_t slot = sortedSlots[s];
+		if (s == 0 || sortedSlots[s - 1] != slot)
+		{
+			CellStart[slot] = static_cast<std::uint32_t>(s);
+		}
+		if (s + 1 == count || sortedSlots[s + 1] != slot)
+		{
+			CellEnd[slot] = static_cast<std::uint32_t>(s + 1);
+		}
+	});
+}
+
+void UniformGrid::Clear() noexcept
+{
+	CellStart.clear();
+	CellEnd.clear();
+	SortedIndices.clear();
+	ParticleSlots.clear();
+	_tableMask = 0;
+}
@@ -0,0 +1,110 @@
+#include "ViscositySolver.h"
+#include "SPHKernelPolicies.h"
+
+#include <cmath>
+
+#ifdef TRACY_ENABLE
+#include <Tracy.hpp>
+#include <TracyC.h>
+#endif
+
+namespace
+{
+	constexpr std::size_t GRAIN_SIZE = 128; /**< Particles processed by one job of the solver passes. */
+
+	/**
+	 * @brief Call func(j, weight) with the kernel value of each in-radius neighbor j of particle i.
+	 */
+	template<typename Kernel, typename Func>
+	void ForEachWeight(const FluidParticleSystem& f, const NeighborList& neighbors, const SPHParams& k, std::size_t i, Func&& func) noexcept
+	{
+		for (const std::uint32_t* it = neighbors.begin(i); it != neighbors.end(i); ++it)
+		{
+			const std::uint32_t j = *it;
+			const float dx = f.PositionX[i] - f.PositionX[j];
+			const float dy = f.PositionY[i] - f.PositionY[j];
+			const float dz = f.PositionZ[i] - f.PositionZ[j];
+			const float sqrDistance = dx * dx + dy * dy + dz * dz;
+			if (sqrDistance >= k.SqrRadius) continue;
+
+			func(j, Kernel::Value(k, std::sqrt(sqrDistance), sqrDistance));
+		}
+	}
+
+	/**
+	 * @brief A x = diagonal * x - coupling * sum_j W_ij x_j, the three velocity components share the matrix.
+	 */
+	template<typename Kernel>
+	struct ViscosityOperator
+	{
+		const FluidParticleSystem& Fluids;
+		const NeighborList& Neighbors;
+		const SPHParams& Params;
+		const float* Diagonals;
+		float Coupling;
+
+		void Multiply(SolverColumns<3> x, SolverColumns<3> result, std::size_t first, std::size_t last) const noexcept
+		{
+			for (std::size_t i = first; i < last; i++)
+			{
+				float sumX = 0.f, sumY = 0.f, sumZ = 0.f;
+				ForEachWeight<Kernel>(Fluids, Neighbors, Params, i, [&](std::uint32_t j, float weight)
+				{
+					sumX += weight * x[0][j];
+					sumY += weight * x[1][j];
+					sumZ += weight * x[2][j];
+				});
+				result[0][i] = Diagonals[i] * x[0][i] - Coupling * sumX;
+				result[1][i] = Diagonals[i] * x[1][i] - Coupling * sumY;
+				result[2][i] = Diagonals[i] * x[2][i] - Coupling * sumZ;
+			}
+		}
+
+		float Diagonal(std::size_t i) const noexcept { return Diagonals[i]; }
+	};
+}
+
+void ViscositySolver::Solve(FluidParticleSystem& fluids, const NeighborList& neighbors, const SPHParams& params, JobSystem& jobs, float deltaTime) noexcept
+{
+#ifdef TRACY_ENABLE
+	ZoneScoped;
+#endif
+	const std::size_t count = fluids.Size();
+	if (count == 0 || deltaTime <= 0.f || params.ViscosityStrength <= 0.f)
+	{
+		_solver.ResetTelemetry();
+		return;
+	}
+
+	_diagonal.resize(count);
+	_rhs.Resize(count);
+	_solver.Settings = Settings;
+
+	const SolverColumns<3> velocity{ { fluids.VelocityX.data(), fluids.VelocityY.data(), fluids.VelocityZ.data() } };
+	const SolverColumns<3> rhs = _rhs.Columns();
+	const float coupling = deltaTime * params.ViscosityStrength;
+
+	DispatchSmoothingKernel(params.Kernel, [&](auto kernel)
+	{
+		using Kernel = decltype(kernel);
+
+		// The current velocities are both the right hand side and the initial guess
+		jobs.ParallelFor(0, count, GRAIN_SIZE, [&](const std::size_t i)
+		{
+			float weightSum = 0.f;
+			ForEachWeight<Kernel>(fluids, neighbors, params, i, [&](std::uint32_t, float weight)
+			{
+				weightSum += weight;
+			});
+			_diagonal[i] = 1.f + coupling * weightSum;
+
+			for (std::size_t d = 0; d < 3; d++)
+			{
+				rhs[d][i] = velocity[d][i];
+			}
+		});
+
+		const ViscosityOperator<Kernel> op{ fluids, neighbors, params, _diagonal.data(), coupling };
+		_solver.ConjugateGradient(jobs, op, velocity, rhs, count);
+	});
+}
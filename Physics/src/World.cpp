@@ -1,23 +1,54 @@
 #include "World.h"
+#include "SPHKernelPolicies.h"
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
 
 #ifdef TRACY_ENABLE
 #include <Tracy.hpp>
 #include <TracyC.h>
 #endif 
 
+static constexpr std::size_t SPH_GRAIN_SIZE = 128; /**< Particles processed by one job of the SPH passes. */
+static constexpr std::size_t BODY_GRAIN_SIZE = 1024; /**< Bodies integrated by one job, the pass is bandwidth bound so the chunks are large. */
+static constexpr std::size_t PAIR_ACCUMULATOR_COLUMNS = 5; /**< Density, near density and the three force components. */
+
+template<typename Func>
+void World::forEachActiveChunk(Func&& func) noexcept
+{
+	if (usesBlockTimeSteps())
+	{
+		_blockSteps.ForEachActiveChunk(_jobSystem, func);
+		return;
+	}
+	_sleep.ForEachAwakeChunk(_jobSystem, _fluids.Size(), SPH_GRAIN_SIZE, func);
+}
+
+template<typename Func>
+void World::forEachFluidChunk(Func&& func) noexcept
+{
+	_jobSystem.ParallelForChunks(0, _fluids.Size(), SPH_GRAIN_SIZE, func);
+}
+
+World::World() noexcept
+{
+	// The per-particle state of the solvers follows the particles through removals and reorders
+	_dfsph.Attach(_fluids);
+	_pbf.Attach(_fluids);
+	_sleep.Attach(_fluids);
+	_blockSteps.Attach(_fluids);
+}
+
 void World::SetUp(int initSize) noexcept
 {
 #ifdef TRACY_ENABLE
 	ZoneScoped;
 #endif
-	_bodies.resize(initSize);
-	BodyGenIndices.resize(initSize, 0);
-
-	_particlesData.reserve(initSize);
-
-	_colliders.resize(initSize);
-	ColliderGenIndices.resize(initSize, 0);
+	_bodies.Reserve(initSize);
+	_colliders.Reserve(initSize);
 
+	_jobSystem.Start(_workerCount);
 }
 
 void World::TearDown() noexcept
@@ -25,16 +56,29 @@ void World::TearDown() noexcept
 #ifdef TRACY_ENABLE
 	ZoneScoped;
 #endif
-	_bodies.clear();
-	BodyGenIndices.clear();
-
-	_colliders.clear();
-	ColliderGenIndices.clear();
+	_bodies.Clear();
+	_colliders.Clear();
+	for (auto& bodies : _bodiesOfType)
+	{
+		bodies.Clear();
+	}
 
 	_colRefPairs.clear();
 
-	_particlesData.clear();
-	grid.clear();
+	_rigidBodies.Clear();
+	_boundedColliders.clear();
+	_colliderBounds.clear();
+
+	_fluids.Clear();
+	_boundary.Clear();
+	_staticGeometry.Clear();
+	_grid.Clear();
+	_neighbors.Clear();
+	_neighborsDirty = true;
+	_stepsSinceReorder = 0;
+	_stats = SimulationStats{};
+
+	_jobSystem.Stop();
 }
 
 void World::Update(const float deltaTime) noexcept
@@ -43,32 +87,7 @@ void World::Update(const float deltaTime) noexcept
 	ZoneScoped;
 #endif
 	UpdateBodies(deltaTime);
-	updateGrid();
-
-	computeNeighborsDensity();
-	computeNeighborsPressure();
-	computeNeighborsViscosity();
-
-	//for (auto& particle : _particlesData)
-	//{
-	//	auto vec = ProcessDensity(particle.first);
-	//	particle.second.Density = XMVectorGetX(vec);
-	//	particle.second.NearDensity = XMVectorGetY(vec);
-	//}
-
-	//for (auto& particle : _particlesData)
-	//{
-	//	//float safeDensity = (particle.second.Density > 1e-6) ? particle.second.Density : 1e-6;
-	//	//GetBody(particle.first).ApplyForce(ProcessPressureForce(particle.first));
-	//	//GetBody(particle.first).ApplyForce(ProcessPressureForce(particle.first) / particle.second.Density);
-	//	XMVECTOR pressureForce = ProcessPressureForce(particle.first);
-	//	GetBody(particle.first).ApplyForce(pressureForce / particle.second.Density);
-	//}
-
-	//for (auto& particle : _particlesData)
-	//{
-	//	GetBody(particle.first).ApplyForce(ProcessViscosityForce(particle.first));
-	//}
+	UpdateFluids(deltaTime);
 
 	//UpdateGlobalCollisions(); // Update global collisions the old way, used for testing purposes
 
@@ -82,110 +101,183 @@ void World::Update(const float deltaTime) noexcept
 
 }
 
+void World::SetWorkerCount(std::size_t workerCount) noexcept
+{
+	_workerCount = workerCount;
+	_jobSystem.Start(_workerCount);
+}
+
 [[nodiscard]] BodyRef World::CreateBody(BodyType type) noexcept
 {
-	const auto it = std::find_if(_bodies.begin(), _bodies.end(), [](const Body& body) {
-		return !body.IsEnabled(); // Get first disabled body
-	});
+	const BodyRef bodyRef = _bodies.Create();
+	_rigidBodies.Resize(_bodies.Slots().size());
+	bindBody(bodyRef.Index(), type);
+	listBody(bodyRef.Index(), type);
+	return bodyRef;
+}
 
-	if (it != _bodies.end())
-	{
-		const std::size_t index = std::distance(_bodies.begin(), it);
-		const auto bodyRef = BodyRef{ index, BodyGenIndices[index] };
-		auto& body = GetBody(bodyRef);
-		body.Enable();
-		body.Type = type;
-		if (type == BodyType::FLUID)
-		{
-			_particlesData.insert({ bodyRef, ParticleData{} });
-		}
+std::vector<BodyRef> World::CreateBodies(std::size_t count, BodyType type) noexcept
+{
+#ifdef TRACY_ENABLE
+	ZoneScoped;
+#endif
+	std::vector<BodyRef> bodyRefs(count);
+	_bodies.Create(count, bodyRefs.data());
+	_rigidBodies.Resize(_bodies.Slots().size());
 
-		return bodyRef;
+	for (const BodyRef bodyRef : bodyRefs)
+	{
+		bindBody(bodyRef.Index(), type);
+		listBody(bodyRef.Index(), type);
 	}
+	return bodyRefs;
+}
 
-	const std::size_t previousSize = _bodies.size();
-
-	_bodies.resize(previousSize * 2, Body());
-	BodyGenIndices.resize(previousSize * 2, 0);
-
-	const BodyRef bodyRef = { previousSize, BodyGenIndices[previousSize] };
-	auto& body = GetBody(bodyRef);
-	body.Enable();
-	body.Type = type;
-	if (type == BodyType::FLUID)
+void World::DestroyBody(const BodyRef bodyRef)
+{
+	if (!_bodies.Contains(bodyRef))
 	{
-		_particlesData.insert({ bodyRef, ParticleData{} });
+		throw std::runtime_error("No body found !");
 	}
-	return bodyRef;
 
+	unlistBody(bodyRef.Index());
+	_rigidBodies.Reset(bodyRef.Index());
+	_bodies.Destroy(bodyRef);
 }
 
-void World::DestroyBody(const BodyRef bodyRef)
+[[nodiscard]] Body& World::GetBody(const BodyRef bodyRef)
 {
-	if (BodyGenIndices[bodyRef.Index] != bodyRef.GenIndex)
+	if (!_bodies.Contains(bodyRef))
 	{
 		throw std::runtime_error("No body found !");
 	}
 
-	_bodies[bodyRef.Index].Disable();
+	return _bodies[bodyRef.Index()];
 }
 
-[[nodiscard]] Body& World::GetBody(const BodyRef bodyRef)
+std::vector<std::uint32_t> World::ResolveBodies(const std::vector<BodyRef>& bodyRefs) const
 {
-	if (BodyGenIndices[bodyRef.Index] != bodyRef.GenIndex)
+	std::vector<std::uint32_t> indices(bodyRefs.size());
+	if (!_bodies.Resolve(bodyRefs.data(), bodyRefs.size(), indices.data()))
 	{
 		throw std::runtime_error("No body found !");
 	}
+	return indices;
+}
 
-	return _bodies[bodyRef.Index];
+void World::SetBodyType(const BodyRef bodyRef, BodyType type)
+{
+	auto& body = GetBody(bodyRef);
+	unlistBody(bodyRef.Index());
+	body._type = type;
+	listBody(bodyRef.Index(), type);
 }
 
-ColliderRef World::CreateCollider(const BodyRef bodyRef) noexcept
+void World::bindBody(std::uint32_t index, BodyType type) noexcept
 {
-	const auto it = std::find_if(_colliders.begin(), _colliders.end(), [](const Collider& collider) {
-		return !collider.IsAttached; // Get first disabled collider
-	});
+	// The slot map resets a reused slot, the body is bound to its row again
+	auto& body = _bodies[index];
+	body._system = &_rigidBodies;
+	body._fluids = &_fluids;
+	body._slot = index;
+	body._type = type;
+
+	// The row holds the initial state, a FLUID body loads it into its particle when it is listed
+	_rigidBodies.Reset(index);
+	_rigidBodies.SetMass(index, 1.f);
+}
 
-	if (it != _colliders.end())
+void World::listBody(std::uint32_t index, BodyType type) noexcept
+{
+	_bodiesOfType[static_cast<std::size_t>(type)].Add(index);
+	_rigidBodies.SetDynamic(index, type == BodyType::DYNAMIC);
+	if (type == BodyType::FLUID)
 	{
-		const std::size_t index = std::distance(_colliders.begin(), it);
-		const auto colRef = ColliderRef{ index, ColliderGenIndices[index] };
-		auto& col = GetCollider(colRef);
-		col.IsAttached = true;
-		col.BodyRef = bodyRef;
-
-		return colRef;
+		_fluids.Load(_fluids.Add(index), _rigidBodies, index);
+		_neighborsDirty = true;
+		_measuredRestDensity = 0.f;
+		_pbf.InvalidateRestLattice();
 	}
+}
 
-	const std::size_t previousSize = _colliders.size();
+void World::unlistBody(std::uint32_t index) noexcept
+{
+	for (std::size_t type = 0; type < _bodiesOfType.size(); type++)
+	{
+		if (!_bodiesOfType[type].Contains(index))
+		{
+			continue;
+		}
 
-	_colliders.resize(previousSize * 2, Collider());
-	ColliderGenIndices.resize(previousSize * 2, 0);
+		_bodiesOfType[type].Remove(index);
+		_rigidBodies.SetDynamic(index, false);
+		if (static_cast<BodyType>(type) == BodyType::FLUID)
+		{
+			// The body gets the state of its particle back when it stops being a fluid
+			_fluids.Store(_fluids.ParticleOf(index), _rigidBodies, index);
+			_fluids.Remove(index);
+			_neighborsDirty = true;
+			_measuredRestDensity = 0.f;
+			_pbf.InvalidateRestLattice();
+		}
+		return;
+	}
+}
 
-	const ColliderRef colRef = { previousSize, ColliderGenIndices[previousSize] };
-	auto& col = GetCollider(colRef);
+ColliderRef World::CreateCollider(const BodyRef bodyRef) noexcept
+{
+	const ColliderRef colRef = _colliders.Create();
+	auto& col = _colliders[colRef.Index()];
 	col.IsAttached = true;
 	col.BodyRef = bodyRef;
 	return colRef;
 }
 
+std::vector<ColliderRef> World::CreateColliders(const std::vector<BodyRef>& bodyRefs) noexcept
+{
+#ifdef TRACY_ENABLE
+	ZoneScoped;
+#endif
+	std::vector<ColliderRef> colRefs(bodyRefs.size());
+	_colliders.Create(bodyRefs.size(), colRefs.data());
+
+	for (std::size_t i = 0; i < colRefs.size(); i++)
+	{
+		auto& col = _colliders[colRefs[i].Index()];
+		col.IsAttached = true;
+		col.BodyRef = bodyRefs[i];
+	}
+	return colRefs;
+}
+
 Collider& World::GetCollider(const ColliderRef colRef)
 {
-	if (ColliderGenIndices[colRef.Index] != colRef.GenIndex)
+	if (!_colliders.Contains(colRef))
 	{
 		throw std::runtime_error("No collider found !");
 	}
 
-	return _colliders[colRef.Index];
+	return _colliders[colRef.Index()];
 }
 
 void World::DestroyCollider(const ColliderRef colRef)
 {
-	if (ColliderGenIndices[colRef.Index] != colRef.GenIndex)
+	if (!_colliders.Contains(colRef))
+	{
+		throw std::runtime_error("No collider found !");
+	}
+	_colliders[colRef.Index()].IsAttached = false;
+	_colliders.Destroy(colRef);
+}
+
+std::vector<std::uint32_t> World::ResolveColliders(const std::vector<ColliderRef>& colRefs) const
+{
+	std::vector<std::uint32_t> indices(colRefs.size());
+	if (!_colliders.Resolve(colRefs.data(), colRefs.size(), indices.data()))
 	{
 		throw std::runtime_error("No collider found !");
 	}
-	_colliders[colRef.Index].IsAttached = false;
+	return indices;
 }
 
 void World::UpdateBodies(const float deltaTime) noexcept
@@ -193,24 +285,20 @@ void World::UpdateBodies(const float deltaTime) noexcept
 #ifdef TRACY_ENABLE
 	ZoneScoped;
 #endif
-	for (auto& body : _bodies)
+	// Static bodies never move and the fluid bodies are integrated by the SPH update, only the DYNAMIC rows are streamed
+	_rigidBodies.BuildDynamicChunks(BODY_GRAIN_SIZE);
+
+	const float kickTime = Integrators::KickTime(Integrator, deltaTime, _previousBodyStep);
+	_previousBodyStep = Integrator == IntegratorScheme::Leapfrog ? deltaTime : 0.f;
+
+	// The stagger is kept per body, a velocity set since the last step gets the half step start kick
+	const float startKickTime = Integrator == IntegratorScheme::Leapfrog ? deltaTime * 0.5f : kickTime;
+	_rigidBodies.StartStaggeredKicks(*_integrator, startKickTime - kickTime, Gravity);
+
+	_rigidBodies.ForEachDynamicChunk(_jobSystem, [&](const std::size_t first, const std::size_t last)
 	{
-		if (!body.IsEnabled())
-		{
-			continue;
-		}
-		if (body.Type == BodyType::STATIC)
-		{
-			continue;
-		}
-		body.ApplyForce({ 0, -Gravity,0 });
-		auto acceleration = XMVectorScale(body.GetForce(), 1 / body.Mass);
-		//printf("Acceleration: %f %f %f\n", XMVectorGetX(acceleration), XMVectorGetY(acceleration), XMVectorGetZ(acceleration));
-		body.Velocity = XMVectorAdd(body.Velocity, XMVectorScale(acceleration, deltaTime));
-		body.Position = XMVectorAdd(body.Position, XMVectorScale(body.Velocity, deltaTime));
-		body.PredictedPosition = XMVectorAdd(body.Position, XMVectorScale(body.Velocity, deltaTime));
-		body.ResetForce();
-	}
+		_rigidBodies.Integrate(*_integrator, kickTime, deltaTime, Gravity, first, last);
+	});
 }
 
 void World::SetUpQuadTree() noexcept {
@@ -220,20 +308,25 @@ void World::SetUpQuadTree() noexcept {
 
 #ifdef TRACY_ENABLE
 	ZoneNamedN(SetRoodNodeBoundary, "SetRootNodeBounds", true);
-	ZoneValue(_colliders.size());
+	ZoneValue(_colliders.Size());
 #endif
 
+	_boundedColliders.clear();
+	_colliderBounds.clear();
+
 	XMVECTOR maxBounds = XMVectorSet(std::numeric_limits<float>::min(), std::numeric_limits<float>::min(), std::numeric_limits<float>::min(), 0);
 	XMVECTOR minBounds = XMVectorSet(std::numeric_limits<float>::max(), std::numeric_limits<float>::max(), std::numeric_limits<float>::max(), 0);
 
-	for (auto& collider : _colliders) {
-		if (!collider.IsAttached) {
+	for (const std::uint32_t index : _colliders.Active()) {
+		// The body references are checked here once, the collision passes then use unchecked accesses
+		auto& collider = _colliders[index];
+		if (!collider.IsAttached || !_bodies.Contains(collider.BodyRef)) {
 			continue;
 		}
 
-		collider.BodyPosition = GetBody(collider.BodyRef).Position;
-
-		const auto bounds = collider.GetBounds();
+		const auto bounds = collider.GetBounds(_bodies[collider.BodyRef.Index()].GetPosition());
+		_boundedColliders.push_back(index);
+		_colliderBounds.push_back(bounds);
 
 		minBounds = XMVectorSetX(minBounds, std::min(XMVectorGetX(minBounds), XMVectorGetX(bounds.MinBound())));
 		minBounds = XMVectorSetY(minBounds, std::min(XMVectorGetY(minBounds), XMVectorGetY(bounds.MinBound())));
@@ -248,13 +341,8 @@ void World::SetUpQuadTree() noexcept {
 #ifdef TRACY_ENABLE
 	ZoneNamedN(Insert, "Insert in OctTree", true);
 #endif
-	for (std::size_t i = 0; i < _colliders.size(); ++i) {
-		if (!_colliders[i].IsAttached) {
-			continue;
-		}
-
-		OctTree.Insert(OctTree.Nodes[0], { _colliders[i].GetBounds(), { i, ColliderGenIndices[i] } });
-
+	for (std::size_t i = 0; i < _boundedColliders.size(); i++) {
+		OctTree.Insert(OctTree.Nodes[0], { _colliderBounds[i], _colliders.RefAt(_boundedColliders[i]) });
 	}
 }
 
@@ -271,15 +359,16 @@ void World::UpdateOctTreeCollisions(const BVHNode& node) noexcept
 		}
 		for (std::size_t i = 0; i < node.ColliderRefAabbs.size() - 1; ++i)
 		{
-			auto& col1 = GetCollider(node.ColliderRefAabbs[i].ColRef);
-			auto& body1 = GetBody(col1.BodyRef);
+			auto& col1 = _colliders[node.ColliderRefAabbs[i].ColRef.Index()];
+			auto& body1 = _bodies[col1.BodyRef.Index()];
 
 			for (std::size_t j = i + 1; j < node.ColliderRefAabbs.size(); ++j)
 			{
-				auto& col2 = GetCollider(node.ColliderRefAabbs[j].ColRef);
-				auto& body2 = GetBody(col2.BodyRef);
+				auto& col2 = _colliders[node.ColliderRefAabbs[j].ColRef.Index()];
+				auto& body2 = _bodies[col2.BodyRef.Index()];
 
-				if (body1.Type == BodyType::FLUID && body2.Type == BodyType::FLUID)
+				// The SPH update handles the fluid with itself, the particles only collide with the other bodies
+				if (body1.GetType() == BodyType::FLUID && body2.GetType() == BodyType::FLUID)
 				{
 					continue;
 				}
@@ -289,8 +378,8 @@ void World::UpdateOctTreeCollisions(const BVHNode& node) noexcept
 					if (Overlap(col1, col2))
 					{
 						Contact contact;
-						contact.CollidingBodies[0] = { &GetBody(col1.BodyRef), &col1 };
-						contact.CollidingBodies[1] = { &GetBody(col2.BodyRef), &col2 };
+						contact.CollidingBodies[0] = { &body1, &col1 };
+						contact.CollidingBodies[1] = { &body2, &col2 };
 						contact.Resolve();
 						if (_contactListener != nullptr)
 						{
@@ -356,25 +445,25 @@ void World::UpdateOctTreeCollisions(const BVHNode& node) noexcept
 	{
 	case ShapeType::Sphere:
 	{
-		SphereF sphere = std::get<SphereF>(colA.Shape) + GetBody(colA.BodyRef).Position;
+		SphereF sphere = std::get<SphereF>(colA.Shape) + _bodies[colA.BodyRef.Index()].GetPosition();
 		switch (ShapeB)
 		{
 		case ShapeType::Sphere:
-		return Intersect(sphere, std::get<SphereF>(colB.Shape) + GetBody(colB.BodyRef).Position);
+		return Intersect(sphere, std::get<SphereF>(colB.Shape) + _bodies[colB.BodyRef.Index()].GetPosition());
 		case ShapeType::Cuboid:
-		return Intersect(sphere, std::get<CuboidF>(colB.Shape) + GetBody(colB.BodyRef).Position);
+		return Intersect(sphere, std::get<CuboidF>(colB.Shape) + _bodies[colB.BodyRef.Index()].GetPosition());
 		}
 		break;
 	}
 	case ShapeType::Cuboid:
 	{
-		CuboidF rect = std::get<CuboidF>(colA.Shape) + GetBody(colA.BodyRef).Position;
+		CuboidF rect = std::get<CuboidF>(colA.Shape) + _bodies[colA.BodyRef.Index()].GetPosition();
 		switch (ShapeB)
 		{
 		case ShapeType::Sphere:
-		return Intersect(rect, std::get<SphereF>(colB.Shape) + GetBody(colB.BodyRef).Position);
+		return Intersect(rect, std::get<SphereF>(colB.Shape) + _bodies[colB.BodyRef.Index()].GetPosition());
 		case ShapeType::Cuboid:
-		return Intersect(rect, std::get<CuboidF>(colB.Shape) + GetBody(colB.BodyRef).Position);
+		return Intersect(rect, std::get<CuboidF>(colB.Shape) + _bodies[colB.BodyRef.Index()].GetPosition());
 		}
 		break;
 	}
@@ -388,26 +477,25 @@ void World::UpdateGlobalCollisions() noexcept
 	ZoneScoped;
 #endif
 
-	for (std::size_t i = 0; i < _colliders.size() - 1; ++i)
+	const auto& active = _colliders.Active();
+	for (std::size_t i = 0; i + 1 < active.size(); ++i)
 	{
-		ColliderRef colRef1{ i, ColliderGenIndices[i] };
-		auto& col1 = GetCollider(colRef1);
-		auto& body1 = GetBody(col1.BodyRef);
-
-		col1.BodyPosition = body1.Position;
+		const ColliderRef colRef1 = _colliders.RefAt(active[i]);
+		auto& col1 = _colliders[active[i]];
+		if (!col1.IsAttached || !_bodies.Contains(col1.BodyRef)) continue;
 
-		if (!col1.IsAttached) continue;
+		auto& body1 = _bodies[col1.BodyRef.Index()];
 
 		// Handle solid-body collisions
-		for (std::size_t j = i + 1; j < _colliders.size(); ++j)
+		for (std::size_t j = i + 1; j < active.size(); ++j)
 		{
-			ColliderRef colRef2{ j, ColliderGenIndices[j] };
-			auto& col2 = GetCollider(colRef2);
-			auto& body2 = GetBody(col2.BodyRef);
+			const ColliderRef colRef2 = _colliders.RefAt(active[j]);
+			auto& col2 = _colliders[active[j]];
+			if (!col2.IsAttached || !_bodies.Contains(col2.BodyRef)) continue;
 
-			if (!col2.IsAttached) continue;
+			auto& body2 = _bodies[col2.BodyRef.Index()];
 
-			if (body1.Type == BodyType::FLUID && body2.Type == BodyType::FLUID)
+			if (body1.GetType() == BodyType::FLUID && body2.GetType() == BodyType::FLUID)
 			{
 				continue;
 			}
@@ -453,176 +541,582 @@ void World::UpdateGlobalCollisions() noexcept
 	}
 }
 
-float World::SmoothingKernel(float radius, float distance)
+SPHPairAccumulator World::pairAccumulator() noexcept
+{
+	// Every entry is written by the pair sweep before it is read, the columns are never zeroed
+	const std::size_t entries = _neighbors.Indices.size();
+	_pairBuffer.resize(PAIR_ACCUMULATOR_COLUMNS * entries);
+
+	float* columns = _pairBuffer.data();
+	return { columns, columns + entries, columns + 2 * entries, columns + 3 * entries, columns + 4 * entries };
+}
+
+void World::computePairsDensity() noexcept
 {
-	if (distance >= radius)
+#ifdef TRACY_ENABLE
+	ZoneScoped;
+#endif
+	const SPHParticleColumns columns = fluidColumns();
+	const SPHPairAccumulator accumulator = pairAccumulator();
+
+	_jobSystem.ParallelForChunks(0, _fluids.Size(), SPH_GRAIN_SIZE, [&](const std::size_t first, const std::size_t last)
 	{
-		return 0;
-	}
+		_sphPairKernels->Density(columns, _sphParams, accumulator, first, last);
+	});
 
-	float volume = (PI * Pow(radius, 4)) / 6;
-	return (radius - distance) * (radius - distance) / volume;
+	_jobSystem.ParallelForChunks(0, _fluids.Size(), SPH_GRAIN_SIZE, [&](const std::size_t first, const std::size_t last)
+	{
+		SPHKernels::FinishDensityPairs(columns, _sphParams, accumulator, first, last);
+		_boundary.AddDensity(_fluids, _sphParams, first, last);
+	});
 }
 
-float World::SmoothingKernelDerivative(float radius, float distance)
+void World::computePairsForces() noexcept
 {
-	if (distance >= radius)
+#ifdef TRACY_ENABLE
+	ZoneScoped;
+#endif
+	const SPHParticleColumns columns = fluidColumns();
+	const SPHParams params = forceParams();
+	const SPHPairAccumulator accumulator = pairAccumulator();
+
+	_jobSystem.ParallelForChunks(0, _fluids.Size(), SPH_GRAIN_SIZE, [&](const std::size_t first, const std::size_t last)
 	{
-		return 0;
-	}
+		_sphPairKernels->Forces(columns, params, accumulator, first, last);
+	});
 
-	float scale = 12 / (Pow(radius, 4) * PI);
-	return (distance - radius) * scale;
+	_jobSystem.ParallelForChunks(0, _fluids.Size(), SPH_GRAIN_SIZE, [&](const std::size_t first, const std::size_t last)
+	{
+		SPHKernels::FinishForcePairs(columns, accumulator, first, last);
+		_boundary.AddForces(_fluids, params, first, last);
+	});
 }
 
-XMVECTOR World::ProcessDensity(BodyRef bodyref)
+float World::ConvertDensityToPressure(float density)
 {
-	auto pos = GetBody(bodyref).Position;
-	float density = 0;
-	float nearDensity = 0;
+	float densityError = density - SPH::TargetDensity;
+	float pressure = densityError * SPH::PressureMultiplier;
 
-	float pow2Radius = SPH::SmoothingRadius * SPH::SmoothingRadius;
+	return pressure;
+}
+float World::ConvertNearDensityToPressure(float nearDensity)
+{
+	return nearDensity * SPH::nearPressureMultiplier;
+}
 
-	//todo: just in radius, use octtree and change it s size with the max radius
-	for (auto& particle : _particlesData)
+float World::CalculateSharedPressure(float pressure1, float pressure2)
+{
+	return (ConvertDensityToPressure(pressure1) + ConvertDensityToPressure(pressure2)) * 0.5f;
+}
+float World::CalculateSharedNearPressure(float nearDensity1, float nearDensity2)
+{
+	return (ConvertNearDensityToPressure(nearDensity1) + ConvertNearDensityToPressure(nearDensity2)) * 0.5f;
+}
+
+void World::UpdateFluids(const float deltaTime) noexcept
+{
+#ifdef TRACY_ENABLE
+	ZoneScoped;
+#endif
+	if (_fluids.Size() == 0)
 	{
+		return;
+	}
+
+	forEachFluidChunk([&](const std::size_t first, const std::size_t last)
+	{
+		_fluids.ResetForces(first, last);
+	});
+
+	updateSPHParams();
+	_boundary.UpdateVolumes(_sphParams, _jobSystem);
+	_staticGeometry.Bake();
+	updateFluidSleep();
+
+	_stats.DensityIterations = 0;
+	_stats.DivergenceIterations = 0;
+	_stats.ConstraintIterations = 0;
+	_stats.ViscosityIterations = 0;
+	_stats.ParticleSteps = 0;
+
+	float remainingTime = deltaTime;
+	std::size_t substeps = 0;
+	float smallestStep = deltaTime;
+
+	if (usesBlockTimeSteps())
+	{
+		substeps = stepBlockTimeSteps(deltaTime);
+		_previousFluidStep = 0.f;
+		smallestStep = _blockSteps.SmallestStep();
+		_stats.ParticleSteps = _blockSteps.Evaluations();
+		remainingTime = 0.f;
+	}
+
+	while (remainingTime > 0.f)
+	{
+		_stepsSinceReorder++;
+
+		float step = remainingTime;
+
+		switch (Solver)
+		{
+		case FluidSolver::WCSPH:
+			selectActiveParticles();
+			updateNeighbors();
+			_stats.ParticleSteps += _fluids.Size() - _sleep.SleepingParticles();
+
+			if (usesSymmetricPairs())
+			{
+				computePairsDensity();
+				computePairsForces();
+			}
+			else
+			{
+				computeNeighborsDensity();
+				computeNeighborsForces();
+			}
 
-		//auto otherPos = GetBody(particle.first).Position;
-		//auto offsetToOther = XMVectorSubtract(otherPos, pos);
-		//float distanceToOther = XMVectorGetX(XMVector3Dot(offsetToOther, offsetToOther));
+			step = nextSubstep(remainingTime, substeps);
+			if (ImplicitViscosity)
+			{
+				integrateFluidVelocities(step);
+				solveViscosity(step);
+				integrateFluidPositions(step);
+				_previousFluidStep = 0.f;
+			}
+			else
+			{
+				const float kickTime = Integrators::KickTime(Integrator, step, _previousFluidStep);
+				forEachActiveChunk([&](const std::size_t first, const std::size_t last)
+				{
+					_fluids.Integrate(*_integrator, kickTime, step, Gravity, first, last);
+				});
+				_previousFluidStep = Integrator == IntegratorScheme::Leapfrog ? step : 0.f;
+			}
+			_staticGeometry.Resolve(_fluids, _jobSystem, SPH_GRAIN_SIZE);
+			break;
 
-		//// Skip if not within radius
-		//if (distanceToOther > pow2Radius) continue;
+		case FluidSolver::DFSPH:
+			updateNeighbors();
 
-		//float distance = sqrt(distanceToOther);
+			updateRestDensity();
 
-		//density += SPH::DensityKernel(SPH::SmoothingRadius, distance);
-		//nearDensity += SPH::NearDensityKernel(SPH::SmoothingRadius, distance);
+			// The pressure is zeroed by the solver so the force pass only adds viscosity
+			_dfsph.ComputeDensities(_fluids, _neighbors, _boundary, _sphParams, _jobSystem);
+			if (!ImplicitViscosity)
+			{
+				computeNeighborsForces();
+			}
 
-		//old code
-		auto& body = GetBody(particle.first);
-		float distance = XMVectorGetX(XMVector3Length(XMVectorSubtract(pos, body.Position)));
-		float influence = SmoothingKernel(SPH::SmoothingRadius, distance);
-		density += influence;
+			step = nextSubstep(remainingTime, substeps);
+			_dfsph.SolveDivergence(_fluids, _neighbors, _boundary, _sphParams, _jobSystem, step);
+			integrateFluidVelocities(step);
+			if (ImplicitViscosity)
+			{
+				solveViscosity(step);
+			}
+			_dfsph.SolveDensity(_fluids, _neighbors, _boundary, _sphParams, _jobSystem, step);
+			integrateFluidPositions(step);
+			_previousFluidStep = 0.f;
+			_staticGeometry.Resolve(_fluids, _jobSystem, SPH_GRAIN_SIZE);
+
+			_stats.DensityIterations += _dfsph.GetStats().DensityIterations;
+			_stats.DivergenceIterations += _dfsph.GetStats().DivergenceIterations;
+			break;
+
+		case FluidSolver::PBF:
+			// The forces are the external ones and the densities those of the last projection
+			step = nextSubstep(remainingTime, substeps);
+			_pbf.PredictPositions(_fluids, *_integrator, _jobSystem, step, Gravity);
+
+			// The neighbors are searched around the predicted positions
+			updateNeighbors();
+			updateRestDensity();
+			_pbf.SolveDensity(_fluids, _neighbors, _boundary, _sphParams, _jobSystem);
+			_pbf.UpdateVelocities(_fluids, _jobSystem, step);
+			_previousFluidStep = 0.f;
+			_staticGeometry.Resolve(_fluids, _jobSystem, SPH_GRAIN_SIZE);
+			_pbf.ApplyViscosity(_fluids, _neighbors, _sphParams, _jobSystem);
+
+			_stats.ConstraintIterations += _pbf.GetStats().Iterations;
+			break;
+		}
 
+		remainingTime = step >= remainingTime ? 0.f : remainingTime - step;
+		smallestStep = std::min(smallestStep, step);
+		substeps++;
 	}
-	return XMVectorSet(density, nearDensity, 0, 0);
-};
 
-float World::ConvertDensityToPressure(float density)
+	_stats.Substeps = substeps;
+	_stats.SmallestTimeStep = smallestStep;
+
+	_fluids.ClearExternalForces();
+}
+
+std::size_t World::stepBlockTimeSteps(float deltaTime) noexcept
 {
-	float densityError = density - SPH::TargetDensity;
-	float pressure = densityError * SPH::PressureMultiplier;
+#ifdef TRACY_ENABLE
+	ZoneScoped;
+#endif
+	// The finest level splits the frame into at most MaxSubsteps ticks, like the global adaptive time step
+	std::uint32_t maxLevel = 0;
+	while (maxLevel < 31 && (std::size_t{ 2 } << maxLevel) <= MaxSubsteps)
+	{
+		maxLevel++;
+	}
 
-	return pressure;
+	BlockTimeStepper::Limits limits;
+	limits.CourantFactor = CourantFactor;
+	limits.SmoothingRadius = _sphParams.SmoothingRadius;
+	limits.Gravity = Gravity;
+	limits.ViscosityStrength = _sphParams.ViscosityStrength;
+	limits.ViscosityStepFactor = ViscosityStepFactor;
+
+	_blockSteps.Begin(deltaTime, maxLevel);
+
+	std::size_t ticks = 0;
+	while (!_blockSteps.Done())
+	{
+		_stepsSinceReorder++;
+
+		selectActiveParticles();
+		updateNeighbors();
+
+		computeNeighborsDensity();
+		computeNeighborsForces();
+		_blockSteps.Kick(_fluids, _neighbors, _sleep, limits, _jobSystem);
+		_blockSteps.Drift(_fluids, _sleep, *_integrator, _jobSystem, SPH_GRAIN_SIZE);
+		_staticGeometry.Resolve(_fluids, _jobSystem, SPH_GRAIN_SIZE);
+
+		ticks++;
+	}
+
+	return ticks;
 }
-float World::ConvertNearDensityToPressure(float nearDensity)
+
+void World::selectActiveParticles() noexcept
 {
-	return nearDensity * SPH::nearPressureMultiplier;
+	if (usesBlockTimeSteps())
+	{
+		_blockSteps.SelectActive(_fluids, _sleep, SPH_GRAIN_SIZE);
+		return;
+	}
+	_sleep.BuildAwakeChunks(SPH_GRAIN_SIZE);
 }
 
-XMVECTOR World::ProcessPressureForce(BodyRef bodyref)
+float World::nextSubstep(float remainingTime, std::size_t substeps) const noexcept
 {
-	auto& thisParticle = GetBody(bodyref);//old code
+	if (!AdaptiveTimeStep)
+	{
+		return remainingTime;
+	}
 
-	//auto thisParticle = _particlesData.at(bodyref);
-	//float density = thisParticle.Density;
-	//float densityNear = thisParticle.NearDensity;
-	//float pressure = ConvertDensityToPressure(density);
-	//float nearPressure = ConvertNearDensityToPressure(densityNear);
-	XMVECTOR pressureForce = XMVectorZero();
+	// Never more than MaxSubsteps per frame, a violent scene is slowed down rather than stalling the frame
+	const std::size_t substepsLeft = MaxSubsteps > substeps + 1 ? MaxSubsteps - substeps : 1;
+	const float step = std::max(std::min(stableTimeStep(), remainingTime), remainingTime / static_cast<float>(substepsLeft));
+
+	// Split what is left evenly instead of ending the frame with a sliver of a step
+	const float stepsLeft = std::ceil(remainingTime / step);
+	return stepsLeft <= 1.f ? remainingTime : remainingTime / stepsLeft;
+}
 
-	//XMVECTOR pos = GetBody(bodyref).Position;
-	//float sqrRadius = SPH::SmoothingRadius * SPH::SmoothingRadius;
+float World::stableTimeStep() const noexcept
+{
+#ifdef TRACY_ENABLE
+	ZoneScoped;
+#endif
+	const auto bounds = _fluids.ComputeMotionBounds(Gravity);
+	const float radius = _sphParams.SmoothingRadius;
+	float step = std::numeric_limits<float>::max();
 
-	for (auto& particle : _particlesData)
+	// Advection: no particle crosses more than a fraction of the smoothing radius in one step
+	if (bounds.MaxSpeed > 0.f)
 	{
-		if (bodyref == particle.first) continue;
+		step = std::min(step, CourantFactor * radius / bounds.MaxSpeed);
+	}
 
-		//auto otherParticle = GetBody(particle.first);
-		//auto otherPos = otherParticle.Position;
-		//auto offsetToOther = otherPos - pos;
-		//float sqrDstToOther = XMVectorGetX(XMVector3Dot(offsetToOther, offsetToOther));
+	// Forces: the distance travelled under the largest acceleration stays below the same fraction
+	if (bounds.MaxAcceleration > 0.f)
+	{
+		step = std::min(step, CourantFactor * std::sqrt(radius / bounds.MaxAcceleration));
+	}
 
-		//if (sqrDstToOther > sqrRadius) continue;
+	// Explicit viscosity relaxes the velocity differences at a rate of ViscosityStrength times the kernel sum,
+	// bounded by the density, and overshoots when a step is longer than the inverse of that rate. PBF uses XSPH instead
+	// and the implicit solve is stable for any step
+	const bool explicitViscosity = Solver != FluidSolver::PBF && !ImplicitViscosity;
+	const float viscosityRate = explicitViscosity ? _sphParams.ViscosityStrength * bounds.MaxDensity : 0.f;
+	if (viscosityRate > 0.f)
+	{
+		step = std::min(step, ViscosityStepFactor / viscosityRate);
+	}
 
-		// Calculate pressure force
+	return step;
+}
 
-		//float distance = XMVectorGetX(XMVector3Length(offsetToOther));
-		//XMVECTOR direction = (distance > 1e-6) ? XMVectorDivide(offsetToOther, XMVectorReplicate(distance)) : XMVectorZero();
+void World::updateGrid(float cellSize) noexcept
+{
+#ifdef TRACY_ENABLE
+	ZoneScoped;
+#endif
+	_grid.Build(_fluids.PositionX.data(), _fluids.PositionY.data(), _fluids.PositionZ.data(), _fluids.Size(), cellSize, _jobSystem);
+}
 
-		//float otherDensity = particle.second.Density;
-		//float otherDensityNear = particle.second.NearDensity;
-		//float otherPressure = ConvertDensityToPressure(otherDensity);
-		//float otherNearPressure = ConvertNearDensityToPressure(otherDensityNear);
+void World::updateNeighbors() noexcept
+{
+#ifdef TRACY_ENABLE
+	ZoneScoped;
+#endif
+	const float skin = std::max(NeighborSkin, 0.f);
+	const float radius = SPH::SmoothingRadius + skin;
 
-		//float sharedPressure = CalculateSharedPressure(pressure, otherPressure);
-		//float sharedNearPressure = CalculateSharedNearPressure(nearPressure, otherNearPressure);
+	const bool half = usesSymmetricPairs();
 
+	if (!_neighborsDirty && !_boundary.Changed() && _neighbors.IsHalf() == half && !_neighbors.NeedsRebuild(_fluids.PositionX.data(), _fluids.PositionY.data(),
+		_fluids.PositionZ.data(), _fluids.Size(), radius, skin))
+	{
+		return;
+	}
 
-		//float safeOtherDensity = (otherDensity > 1e-6) ? otherDensity : 1e-6;
-		//float safeOtherDensityNear = (otherDensityNear > 1e-6) ? otherDensityNear : 1e-6;
+	// The particle indices change, so sorting is only worth it right before a rebuild
+	if (ParticleReorderInterval != 0 && _stepsSinceReorder >= ParticleReorderInterval)
+	{
+		_fluids.SortByMortonOrder(radius);
+		_stepsSinceReorder = 0;
+		_stats.ParticleReorders++;
 
-		//pressureForce += direction * SPH::DensityDerivative(SPH::SmoothingRadius, distance) * sharedPressure / safeOtherDensity;
-		//pressureForce += direction * SPH::NearDensityDerivative(SPH::SmoothingRadius, distance) * sharedNearPressure / safeOtherDensityNear;
+		// The particles moved in the storage, so their active ranges did too
+		selectActiveParticles();
+	}
 
+	const float* posX = _fluids.PositionX.data();
+	const float* posY = _fluids.PositionY.data();
+	const float* posZ = _fluids.PositionZ.data();
 
-		//old code
-		auto& otherParticle = GetBody(particle.first);
-		XMVECTOR offset = XMVectorSubtract(thisParticle.Position, otherParticle.Position);
-		float distance = XMVectorGetX(XMVector3Length(offset));
-		XMVECTOR direction = distance == 0 ? g_XMIdentityR1 : offset / distance;
-		float slope = SmoothingKernelDerivative(SPH::SmoothingRadius, distance);
-		float density = particle.second.Density;
-		float sharedPressure = CalculateSharedPressure(density, _particlesData.at(bodyref).Density);
-		pressureForce += sharedPressure * direction * slope * otherParticle.Mass / density;
+	updateGrid(radius);
+	// Sleeping particles are skipped by every pass, they only need to appear in the lists of the awake ones. Without
+	// a skin the list is rebuilt every step, so the particles the block time steps leave out of it are skipped too
+	const std::uint32_t* skip = _sleep.SleepingParticles() != 0 ? _sleep.Asleep().data() : nullptr;
+	if (usesBlockTimeSteps() && skin <= 0.f)
+	{
+		skip = _blockSteps.InactiveMask();
+	}
+	_neighbors.Build(_grid, posX, posY, posZ, _fluids.Size(), radius, _jobSystem, half, skip);
+	_boundary.FindNeighbors(posX, posY, posZ, _fluids.Size(), radius, _jobSystem, skip);
+	_neighborsDirty = false;
+
+	_stats.NeighborRebuilds++;
+	// Averaged over the particles that got a list, a tick updating none of them keeps the last value
+	const float averageNeighbors = _neighbors.AverageLength(skip);
+	if (averageNeighbors > 0.f || skip == nullptr)
+	{
+		_stats.AverageNeighbors = averageNeighbors;
+	}
+}
 
+void World::updateSPHParams() noexcept
+{
+	if (_sphParams.SmoothingRadius == SPH::SmoothingRadius && _sphParams.TargetDensity == SPH::TargetDensity &&
+		_sphParams.PressureMultiplier == SPH::PressureMultiplier && _sphParams.ViscosityStrength == SPH::ViscosityStrength &&
+		_sphParams.Kernel == FluidKernel)
+	{
+		return;
 	}
-	return pressureForce;
+
+	_sphParams = SPHKernels::MakeParams(SPH::SmoothingRadius, SPH::TargetDensity, SPH::PressureMultiplier,
+		SPH::ViscosityStrength, FluidKernel);
+	_measuredRestDensity = 0.f;
+	_pbf.InvalidateRestLattice();
+	_sphKernels = &SPHKernels::Select(FluidKernel);
+	_sphPairKernels = &SPHKernels::Pairs(FluidKernel);
 }
 
-float World::CalculateSharedPressure(float pressure1, float pressure2)
+void World::updateRestDensity() noexcept
 {
-	return (ConvertDensityToPressure(pressure1) + ConvertDensityToPressure(pressure2)) * 0.5f;
+	if (SPH::RestDensity > 0.f)
+	{
+		_sphParams.RestDensity = SPH::RestDensity;
+		return;
+	}
+
+	if (_measuredRestDensity <= 0.f && _fluids.Size() != 0)
+	{
+#ifdef TRACY_ENABLE
+		ZoneScoped;
+#endif
+		_restDensitySamples.resize(_fluids.Size());
+
+		DispatchSmoothingKernel(_sphParams.Kernel, [&](auto kernel)
+		{
+			using Kernel = decltype(kernel);
+
+			_jobSystem.ParallelFor(0, _fluids.Size(), SPH_GRAIN_SIZE, [&](const std::size_t i)
+			{
+				float density = _fluids.Mass[i] * _sphParams.SelfDensity;
+				for (const std::uint32_t* it = _neighbors.begin(i); it != _neighbors.end(i); ++it)
+				{
+					const std::uint32_t j = *it;
+					const float dx = _fluids.PositionX[i] - _fluids.PositionX[j];
+					const float dy = _fluids.PositionY[i] - _fluids.PositionY[j];
+					const float dz = _fluids.PositionZ[i] - _fluids.PositionZ[j];
+					const float sqrDistance = dx * dx + dy * dy + dz * dz;
+					if (sqrDistance >= _sphParams.SqrRadius) continue;
+
+					density += _fluids.Mass[j] * Kernel::Value(_sphParams, std::sqrt(sqrDistance), sqrDistance);
+				}
+				_restDensitySamples[i] = density;
+			});
+		});
+
+		const auto percentile = _restDensitySamples.begin() + _restDensitySamples.size() * 9 / 10;
+		std::nth_element(_restDensitySamples.begin(), percentile, _restDensitySamples.end());
+		_measuredRestDensity = *percentile;
+	}
+
+	_sphParams.RestDensity = _measuredRestDensity;
 }
-float World::CalculateSharedNearPressure(float nearDensity1, float nearDensity2)
+
+bool World::usesSymmetricPairs() const noexcept
 {
-	return (ConvertNearDensityToPressure(nearDensity1) + ConvertNearDensityToPressure(nearDensity2)) * 0.5f;
+	// The DFSPH, PBF and implicit viscosity solvers walk the full list, the sleeping cells and the particles between
+	// two steps of their level are skipped by the gather sweeps
+	return SymmetricPairs && Solver == FluidSolver::WCSPH && !ImplicitViscosity && !FluidSleeping && !usesBlockTimeSteps();
+}
+
+bool World::usesFluidSleeping() const noexcept
+{
+	return FluidSleeping && Solver == FluidSolver::WCSPH && !ImplicitViscosity;
 }
 
-//XMVECTOR World::ProcessViscosityForce(BodyRef bodyref)
-//{
-//	XMVECTOR viscosityForce = XMVectorZero();
-//	XMVECTOR position = GetBody(bodyref).Position;
-//	for (auto& particle : _particlesData)
-//	{
-//		float distance = XMVectorGetX(XMVector3Length(XMVectorSubtract(position, GetBody(particle.first).Position)));
-//		float influence = SmoothingKernel(SPH::SmoothingRadius, distance);
-//		viscosityForce += (GetBody(particle.first).Velocity - GetBody(bodyref).Velocity) * influence;
-//	}
-//	//printf("ViscosityForce: %f %f %f\n", XMVectorGetX(viscosityForce), XMVectorGetY(viscosityForce), XMVectorGetZ(viscosityForce));
-//	return viscosityForce * SPH::ViscosityStrength;
-//}
+bool World::usesBlockTimeSteps() const noexcept
+{
+	return BlockTimeSteps && AdaptiveTimeStep && Solver == FluidSolver::WCSPH && !ImplicitViscosity;
+}
 
-XMVECTOR World::ProcessViscosityForce(BodyRef bodyref)
+void World::updateFluidSleep() noexcept
 {
-	XMVECTOR viscosityForce = XMVectorZero();
-	XMVECTOR position = GetBody(bodyref).Position;
-	XMVECTOR velocity = GetBody(bodyref).Velocity;
+#ifdef TRACY_ENABLE
+	ZoneScoped;
+#endif
+	if (!usesFluidSleeping())
+	{
+		_sleep.WakeAll();
+		_stats.SleepingParticles = 0;
+		_neighborsDirty |= _sleep.Changed();
+		return;
+	}
 
-	for (auto& particle : _particlesData)
+	_wakeBounds.clear();
+	for (const std::uint32_t index : _colliders.Active())
 	{
-		if (particle.first == bodyref) continue; // optional, skip self
+		auto& collider = _colliders[index];
+		if (!collider.IsAttached || !_bodies.Contains(collider.BodyRef))
+		{
+			continue;
+		}
 
-		const Body& neighbor = GetBody(particle.first);
-		XMVECTOR r = position - neighbor.Position;
-		float distance = XMVectorGetX(XMVector3Length(r));
+		const auto& body = _bodies[collider.BodyRef.Index()];
+		if (body.GetType() != BodyType::DYNAMIC)
+		{
+			continue;
+		}
+
+		_wakeBounds.push_back(collider.GetBounds(body.GetPosition()));
+	}
 
-		if (distance > SPH::SmoothingRadius) continue;
+	_sleep.Update(_fluids, SPH::SmoothingRadius, _wakeBounds);
+	_stats.SleepingParticles = _sleep.SleepingParticles();
 
-		float influence = SmoothingKernel(SPH::SmoothingRadius, distance);
-		viscosityForce += (neighbor.Velocity - velocity) * influence * GetBody(bodyref).Mass; // missing mass factor
+	// Sleeping particles have no neighbor list of their own
+	_neighborsDirty |= _sleep.Changed();
+}
+
+SPHParams World::forceParams() const noexcept
+{
+	SPHParams params = _sphParams;
+	if (ImplicitViscosity)
+	{
+		params.ViscosityStrength = 0.f;
 	}
-	//printf("ViscosityForce: %f %f %f\n", XMVectorGetX(viscosityForce), XMVectorGetY(viscosityForce), XMVectorGetZ(viscosityForce));
-	return viscosityForce * SPH::ViscosityStrength;
+	return params;
+}
+
+void World::integrateFluidVelocities(float deltaTime) noexcept
+{
+#ifdef TRACY_ENABLE
+	ZoneScoped;
+#endif
+	forEachFluidChunk([&](const std::size_t first, const std::size_t last)
+	{
+		_fluids.IntegrateVelocities(*_integrator, deltaTime, Gravity, first, last);
+	});
+}
+
+void World::integrateFluidPositions(float deltaTime) noexcept
+{
+#ifdef TRACY_ENABLE
+	ZoneScoped;
+#endif
+	forEachFluidChunk([&](const std::size_t first, const std::size_t last)
+	{
+		_fluids.IntegratePositions(*_integrator, deltaTime, first, last);
+	});
+}
+
+void World::solveViscosity(float deltaTime) noexcept
+{
+	_viscosity.Solve(_fluids, _neighbors, _sphParams, _jobSystem, deltaTime);
+	_stats.ViscosityIterations += _viscosity.GetStats().Iterations;
+}
+
+SPHParticleColumns World::fluidColumns() noexcept
+{
+	SPHParticleColumns columns;
+	columns.PositionX = _fluids.PositionX.data();
+	columns.PositionY = _fluids.PositionY.data();
+	columns.PositionZ = _fluids.PositionZ.data();
+	columns.VelocityX = _fluids.VelocityX.data();
+	columns.VelocityY = _fluids.VelocityY.data();
+	columns.VelocityZ = _fluids.VelocityZ.data();
+	columns.Mass = _fluids.Mass.data();
+	columns.Density = _fluids.Density.data();
+	columns.NearDensity = _fluids.NearDensity.data();
+	columns.Pressure = _fluids.Pressure.data();
+	columns.ForceX = _fluids.ForceX.data();
+	columns.ForceY = _fluids.ForceY.data();
+	columns.ForceZ = _fluids.ForceZ.data();
+	columns.NeighborOffsets = _neighbors.Offsets.data();
+	columns.NeighborIndices = _neighbors.Indices.data();
+	columns.ReverseOffsets = _neighbors.ReverseOffsets.data();
+	columns.ReverseEntries = _neighbors.ReverseEntries.data();
+	return columns;
+}
+
+void World::computeNeighborsDensity() noexcept
+{
+#ifdef TRACY_ENABLE
+	ZoneScoped;
+#endif
+	const SPHParticleColumns columns = fluidColumns();
+
+	forEachActiveChunk([&](const std::size_t first, const std::size_t last)
+	{
+		_sphKernels->Density(columns, _sphParams, first, last);
+		_boundary.AddDensity(_fluids, _sphParams, first, last);
+	});
+}
+
+void World::computeNeighborsForces() noexcept
+{
+#ifdef TRACY_ENABLE
+	ZoneScoped;
+#endif
+	const SPHParticleColumns columns = fluidColumns();
+	const SPHParams params = forceParams();
+
+	forEachActiveChunk([&](const std::size_t first, const std::size_t last)
+	{
+		_sphKernels->Forces(columns, params, first, last);
+		_boundary.AddForces(_fluids, params, first, last);
+	});
 }
@@ -12,6 +12,9 @@ class WaterBathSample : public PhysicsSample, public ContactListener
 {
 private:
 	std::vector<GraphicsData> _quadTreeGraphicsData;
+	std::vector<std::uint32_t> _colIndices; /**< Slot index of each collider of _colRefs, resolved when colliders are added. */
+	std::vector<std::size_t> _colGraphics; /**< Index in AllGraphicsData of each collider of _colRefs. */
+	std::vector<std::uint32_t> _fluidBodies; /**< Slot index of each fluid body, to reach its particle. */
 public:
 
 	int NbParticles = 1000;
@@ -38,8 +41,15 @@ protected:
 private:
 	void CreateBall(XMVECTOR position, float radius, BodyType type) noexcept;
 
+	void CreateFluid(std::size_t count, float radius) noexcept;
+
 	void CreateWall(XMVECTOR position, XMVECTOR minBound, XMVECTOR maxBound, bool isFilled) noexcept;
 
 	void DrawQuadtree(const BVHNode& node) noexcept;
 
+	/**
+	 * @brief Resolve the references of _colRefs again if colliders were added or removed since the last call.
+	 */
+	void ResolveColliders() noexcept;
+
 };
@@ -11,8 +11,8 @@ void BouncingCollisionSample::OnCollisionEnter(ColliderRef col1,
                                                ColliderRef col2) noexcept {
   Color color = {Random::Range(0, 255), Random::Range(0, 255),
                  Random::Range(0, 255), 255};
-  AllGraphicsData[col1.Index].Color = color;
-  AllGraphicsData[col2.Index].Color = color;
+  AllGraphicsData[col1.Index()].Color = color;
+  AllGraphicsData[col2.Index()].Color = color;
 }
 
 void BouncingCollisionSample::OnCollisionExit(ColliderRef col1,
@@ -32,25 +32,24 @@ void BouncingCollisionSample::SampleSetUp() noexcept {
     _bodyRefs.push_back(bodyRef1);
     auto& body1 = _world.GetBody(bodyRef1);
 
-    body1.Mass = 1;
+    body1.SetMass(1);
 
-    body1.Velocity = XMVectorScale(
+    body1.SetVelocity(XMVectorScale(
         XMVectorSet(Random::Range(-1.f, 1.f), Random::Range(-1.f, 1.f),
                     Random::Range(-1.f, 1.f), 0),
-        SPEED);
+        SPEED));
 
-    body1.Position = {Random::Range(-100.f, 100.f),
-                      Random::Range(-100.f, 100.f),
-                      Random::Range(-100.f, 100.f)};
+    body1.SetPosition({Random::Range(-100.f, 100.f),
+                       Random::Range(-100.f, 100.f),
+                       Random::Range(-100.f, 100.f)});
 
     auto colRef1 = _world.CreateCollider(bodyRef1);
     _colRefs.push_back(colRef1);
     auto& col1 = _world.GetCollider(colRef1);
     col1.Shape = Sphere(XMVectorZero(), sphere_RADIUS);
-    col1.BodyPosition = body1.Position;
 
     GraphicsData bd;
-    bd.Shape = Sphere(XMVectorZero(), sphere_RADIUS) + body1.Position;
+    bd.Shape = Sphere(XMVectorZero(), sphere_RADIUS) + body1.GetPosition();
     AllGraphicsData.push_back(bd);
   }
 
@@ -60,23 +59,22 @@ void BouncingCollisionSample::SampleSetUp() noexcept {
     _bodyRefs.push_back(bodyRef1);
     auto& body1 = _world.GetBody(bodyRef1);
 
-    body1.Velocity = XMVectorScale(
+    body1.SetVelocity(XMVectorScale(
         XMVectorSet(Random::Range(-1.f, 1.f), Random::Range(-1.f, 1.f),
                     Random::Range(-1.f, 1.f), 0),
-        SPEED);
+        SPEED));
 
-    body1.Position = {Random::Range(-100.f, 100.f),
-                      Random::Range(-100.f, 100.f),
-                      Random::Range(-100.f, 100.f)};
+    body1.SetPosition({Random::Range(-100.f, 100.f),
+                       Random::Range(-100.f, 100.f),
+                       Random::Range(-100.f, 100.f)});
 
     auto colRef1 = _world.CreateCollider(bodyRef1);
     _colRefs.push_back(colRef1);
     auto& col1 = _world.GetCollider(colRef1);
     col1.Shape = CuboidF(XMVectorZero(), cuboid_BOUNDS);
-    col1.BodyPosition = body1.Position;
 
     GraphicsData bd;
-    bd.Shape = CuboidF(XMVectorZero(), cuboid_BOUNDS) + body1.Position;
+    bd.Shape = CuboidF(XMVectorZero(), cuboid_BOUNDS) + body1.GetPosition();
     AllGraphicsData.push_back(bd);
   }
 }
@@ -99,47 +97,41 @@ void BouncingCollisionSample::SampleUpdate() noexcept {
 
   for (std::size_t i = 0; i < _colRefs.size(); ++i) {
     auto& col = _world.GetCollider(_colRefs[i]);
-    auto bounds = col.GetBounds();
     auto& body = _world.GetBody(col.BodyRef);
+    auto bounds = col.GetBounds(body.GetPosition());
 
     if (XMVectorGetX(bounds.MinBound()) <= -100) {
-      body.Velocity =
-          XMVectorSetX(body.Velocity, Abs(XMVectorGetX(body.Velocity)));
+      body.SetVelocity(XMVectorSetX(body.GetVelocity(), Abs(XMVectorGetX(body.GetVelocity()))));
     } else if (XMVectorGetX(bounds.MaxBound()) >= 100) {
-      body.Velocity =
-          XMVectorSetX(body.Velocity, -Abs(XMVectorGetX(body.Velocity)));
+      body.SetVelocity(XMVectorSetX(body.GetVelocity(), -Abs(XMVectorGetX(body.GetVelocity()))));
     }
     if (XMVectorGetY(bounds.MinBound()) <= -100) {
-      body.Velocity =
-          XMVectorSetY(body.Velocity, Abs(XMVectorGetY(body.Velocity)));
+      body.SetVelocity(XMVectorSetY(body.GetVelocity(), Abs(XMVectorGetY(body.GetVelocity()))));
     } else if (XMVectorGetY(bounds.MaxBound()) >= 100) {
-      body.Velocity =
-          XMVectorSetY(body.Velocity, -Abs(XMVectorGetY(body.Velocity)));
+      body.SetVelocity(XMVectorSetY(body.GetVelocity(), -Abs(XMVectorGetY(body.GetVelocity()))));
     }
     if (XMVectorGetZ(bounds.MinBound()) <= -100) {
-      body.Velocity =
-          XMVectorSetZ(body.Velocity, Abs(XMVectorGetZ(body.Velocity)));
+      body.SetVelocity(XMVectorSetZ(body.GetVelocity(), Abs(XMVectorGetZ(body.GetVelocity()))));
     } else if (XMVectorGetZ(bounds.MaxBound()) >= 100) {
-      body.Velocity =
-          XMVectorSetZ(body.Velocity, -Abs(XMVectorGetZ(body.Velocity)));
+      body.SetVelocity(XMVectorSetZ(body.GetVelocity(), -Abs(XMVectorGetZ(body.GetVelocity()))));
     }
 
     auto& shape = _world.GetCollider(_colRefs[i]).Shape;
 
     switch (shape.index()) {
       case static_cast<int>(ShapeType::Sphere):
-        AllGraphicsData[i].Shape = std::get<SphereF>(shape) + col.BodyPosition;
+        AllGraphicsData[i].Shape = std::get<SphereF>(shape) + body.GetPosition();
         break;
       case static_cast<int>(ShapeType::Cuboid):
-        AllGraphicsData[i].Shape = std::get<CuboidF>(shape) + col.BodyPosition;
+        AllGraphicsData[i].Shape = std::get<CuboidF>(shape) + body.GetPosition();
         break;
     }
     if (i == 0) {
                   printf("speed: x=%f, y=%f,z=%f, all=%f \n",
-                         XMVectorGetX(body.Velocity), 
-                         XMVectorGetY(body.Velocity),
-                         XMVectorGetZ(body.Velocity),
-             Abs(XMVectorGetX(body.Velocity))+ Abs(XMVectorGetY(body.Velocity))+ Abs(XMVectorGetZ(body.Velocity)));
+                         XMVectorGetX(body.GetVelocity()), 
+                         XMVectorGetY(body.GetVelocity()),
+                         XMVectorGetZ(body.GetVelocity()),
+             Abs(XMVectorGetX(body.GetVelocity()))+ Abs(XMVectorGetY(body.GetVelocity()))+ Abs(XMVectorGetZ(body.GetVelocity())));
     }
   }
 
@@ -22,20 +22,18 @@ void GroundCollisionSample::SampleSetUp() noexcept {
 	_world.SetContactListener(this);
 
 	// Create static cuboid
-	const auto groundRef = _world.CreateBody();
+	const auto groundRef = _world.CreateBody(BodyType::STATIC);
 	_bodyRefs.push_back(groundRef);
 	auto& groundBody = _world.GetBody(groundRef);
-	groundBody.Type = BodyType::STATIC;
-	groundBody.Mass = 1;
+	groundBody.SetMass(1);
 
-	groundBody.Position = { 0,Metrics::MetersToPixels(-1),0 };
+	groundBody.SetPosition({ 0,Metrics::MetersToPixels(-1),0 });
 
 	const auto groundColRef = _world.CreateCollider(groundRef);
 	_colRefs.push_back(groundColRef);
 	auto& groundCol = _world.GetCollider(groundColRef);
 	groundCol.Shape = CuboidF({ Metrics::MetersToPixels(-3), Metrics::MetersToPixels(-0.1f), Metrics::MetersToPixels(-3) },
 		{ Metrics::MetersToPixels(3), Metrics::MetersToPixels(0.1f), Metrics::MetersToPixels(3) });
-	groundCol.BodyPosition = groundBody.Position;
 	groundCol.Restitution = 1.f;
 
 	AllGraphicsData.emplace_back();
@@ -50,21 +48,22 @@ void GroundCollisionSample::SampleUpdate() noexcept {
 
 	for (std::size_t i = 0; i < _colRefs.size(); ++i) {
 		const auto& col = _world.GetCollider(_colRefs[i]);
+		auto& body = _world.GetBody(col.BodyRef);
 
 		const auto& shape = _world.GetCollider(_colRefs[i]).Shape;
 
 		switch (shape.index()) {
 		case static_cast<int>(ShapeType::Sphere):
-			_world.GetBody(col.BodyRef).ApplyForce({ 0, SPEED });
+			body.ApplyForce({ 0, SPEED });
 			AllGraphicsData[i].Shape =
-				std::get<SphereF>(shape) + col.BodyPosition;
+				std::get<SphereF>(shape) + body.GetPosition();
 			break;
 		case static_cast<int>(ShapeType::Cuboid):
 			if (i != 0) {
-				_world.GetBody(col.BodyRef).ApplyForce({ 0, SPEED });
+				body.ApplyForce({ 0, SPEED });
 			}
 			AllGraphicsData[i].Shape =
-				std::get<CuboidF>(shape) + col.BodyPosition;
+				std::get<CuboidF>(shape) + body.GetPosition();
 			break;
 		default:
 			break;
@@ -79,17 +78,16 @@ void GroundCollisionSample::CreateBall(XMVECTOR position) noexcept {
 	_bodyRefs.push_back(sphereBodyRef);
 	auto& sphereBody = _world.GetBody(sphereBodyRef);
 
-	sphereBody.Mass = 1;
+	sphereBody.SetMass(1);
 
 	//sphereBody.Position = position;
-	sphereBody.Position = XMVectorZero();
+	sphereBody.SetPosition(XMVectorZero());
 
 	const auto sphereColRef = _world.CreateCollider(sphereBodyRef);
 	_colRefs.push_back(sphereColRef);
 	auto& sphereCol = _world.GetCollider(sphereColRef);
 	sphereCol.Shape =
 		Sphere(XMVectorZero(), Random::Range(10.f, 40.f));
-	sphereCol.BodyPosition = sphereBody.Position;
 	sphereCol.Restitution = 0.f;
 
 	GraphicsData gd;
@@ -100,20 +98,18 @@ void GroundCollisionSample::CreateBall(XMVECTOR position) noexcept {
 }
 
 void GroundCollisionSample::CreateRect(XMVECTOR position) noexcept {
-	const auto rectBodyRef = _world.CreateBody();
+	const auto rectBodyRef = _world.CreateBody(BodyType::DYNAMIC);
 	_bodyRefs.push_back(rectBodyRef);
 	auto& rectBody = _world.GetBody(rectBodyRef);
-	rectBody.Type = BodyType::DYNAMIC;
 
 	//rectBody.Position = position;
-	rectBody.Position = XMVectorZero();
+	rectBody.SetPosition(XMVectorZero());
 
 	const auto rectColRef = _world.CreateCollider(rectBodyRef);
 	_colRefs.push_back(rectColRef);
 	auto& rectCol = _world.GetCollider(rectColRef);
 	rectCol.Shape = CuboidF({ -Random::Range(1.f, 4.f) * 10.f, -Random::Range(1.f, 4.f) * 10.f,-Random::Range(1.f, 4.f) * 10.f },
 		{ Random::Range(1.f, 4.f) * 10.f, Random::Range(1.f, 4.f) * 10.f, Random::Range(1.f, 4.f) * 10.f });
-	rectCol.BodyPosition = rectBody.Position;
 	rectCol.Restitution = 0.f;
 
 	GraphicsData gd;
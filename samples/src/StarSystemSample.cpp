@@ -16,8 +16,8 @@ void StarSystemSample::SampleSetUp() noexcept
 		_sunRef = _world.CreateBody();
 		auto& sun = _world.GetBody(_sunRef);
 		//sun.Position = { static_cast<float>(Metrics::Width) / 2, static_cast<float>(Metrics::Height) / 2 };
-		sun.Position = { 0, 0, 0 };
-		sun.Mass = 5000;
+		sun.SetPosition({ 0, 0, 0 });
+		sun.SetMass(5000);
 
 		_bodyRefs.push_back(_sunRef);
 		GraphicsData sgd;
@@ -31,20 +31,20 @@ void StarSystemSample::SampleSetUp() noexcept
 			auto bodyRef = _world.CreateBody();
 			auto& body = _world.GetBody(bodyRef);
 			//body.Position = { Random::Range(100.f, Metrics::Width - 100.f),Random::Range(100.f, Metrics::Height - 100.f) };
-			body.Position = { Random::Range(-25.f, 25.f),Random::Range(-25.f, 25.f), Random::Range(-25.f, 25.f) };
+			body.SetPosition({ Random::Range(-25.f, 25.f),Random::Range(-25.f, 25.f), Random::Range(-25.f, 25.f) });
 
-			auto r = XMVectorSubtract(_world.GetBody(_sunRef).Position, body.Position);
-			auto v = sqrt(G * (_world.GetBody(_sunRef).Mass / XMVectorGetX(XMVector3Length(r))));
+			auto r = XMVectorSubtract(_world.GetBody(_sunRef).GetPosition(), body.GetPosition());
+			auto v = sqrt(G * (_world.GetBody(_sunRef).GetMass() / XMVectorGetX(XMVector3Length(r))));
 
 			auto velocityDir = XMVector3Cross(r, XMVectorSet(0.f, 0.f, 1.f, 0.f)); // Cross product with an arbitrary vector (z-axis)
 			if (XMVector3Equal(XMVector3Length(velocityDir), XMVectorZero())) {
 				// Handle edge case: if `r` is parallel to the z-axis, choose a different axis for the cross product
 				velocityDir = XMVector3Cross(r, XMVectorSet(0.f, 1.f, 0.f, 0.f)); // Cross with y-axis
 			}
-			body.Velocity = XMVectorScale(XMVector3Normalize(velocityDir), v);
+			body.SetVelocity(XMVectorScale(XMVector3Normalize(velocityDir), v));
 			//body.Velocity = XMVectorScale(XMVector3Normalize(XMVectorSet(-XMVectorGetY(r), XMVectorGetX(r), 0, 0)), v);
 
-			body.Mass = 10.f;
+			body.SetMass(10.f);
 
 			// Graphics
 			_bodyRefs.push_back(bodyRef);
@@ -67,12 +67,12 @@ void StarSystemSample::SampleSetUp() noexcept
 void StarSystemSample::CalculateGravitationalForce(const Body& sun, Body& body) noexcept
 {
 
-	auto m1m2 = sun.Mass * body.Mass;
-	auto r = XMVectorGetX(XMVector3Length(XMVectorSubtract(sun.Position, body.Position)));
+	auto m1m2 = sun.GetMass() * body.GetMass();
+	auto r = XMVectorGetX(XMVector3Length(XMVectorSubtract(sun.GetPosition(), body.GetPosition())));
 	auto r2 = r * r;
 	auto F = G * (m1m2 / r2);
 
-	XMVECTOR forceDirection = XMVector3Normalize(XMVectorSubtract(sun.Position, body.Position));
+	XMVECTOR forceDirection = XMVector3Normalize(XMVectorSubtract(sun.GetPosition(), body.GetPosition()));
 	XMVECTOR force = XMVectorScale(forceDirection, F);
 	body.ApplyForce(force);
 
@@ -86,7 +86,7 @@ void StarSystemSample::SampleUpdate() noexcept
 	{
 		auto& body = _world.GetBody(_bodyRefs[i]);
 
-		AllGraphicsData[i].Shape = _spheres[i] + body.Position;
+		AllGraphicsData[i].Shape = _spheres[i] + body.GetPosition();
 
 		if (_bodyRefs[i] == _sunRef) continue; // Skip the Sun
 
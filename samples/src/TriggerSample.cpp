@@ -12,33 +12,33 @@ std::string TriggerSample::GetDescription() noexcept
 
 void TriggerSample::OnTriggerEnter(ColliderRef col1, ColliderRef col2) noexcept
 {
-	_triggerNbrPerCollider[col1.Index]++;
-	_triggerNbrPerCollider[col2.Index]++;
-	if (col1.Index == 0)
+	_triggerNbrPerCollider[col1.Index()]++;
+	_triggerNbrPerCollider[col2.Index()]++;
+	if (col1.Index() == 0)
 	{
-		printf("collision: nb = %i\n", _triggerNbrPerCollider[col1.Index]);
+		printf("collision: nb = %i\n", _triggerNbrPerCollider[col1.Index()]);
 	}
-	if (col2.Index == 0)
+	if (col2.Index() == 0)
 	{
-		printf("collision: nb = %i\n", _triggerNbrPerCollider[col2.Index]);
+		printf("collision: nb = %i\n", _triggerNbrPerCollider[col2.Index()]);
 	}
 }
 
 void TriggerSample::OnTriggerExit(ColliderRef col1, ColliderRef col2) noexcept
 {
-	_triggerNbrPerCollider[col1.Index]--;
-	_triggerNbrPerCollider[col2.Index]--;
-	if (col1.Index == 0)
+	_triggerNbrPerCollider[col1.Index()]--;
+	_triggerNbrPerCollider[col2.Index()]--;
+	if (col1.Index() == 0)
 	{
-		printf("sortie: nb = %i\n", _triggerNbrPerCollider[col1.Index]);
+		printf("sortie: nb = %i\n", _triggerNbrPerCollider[col1.Index()]);
 	}
-	if (col2.Index == 0)
+	if (col2.Index() == 0)
 	{
-		printf("sortie: nb = %i\n", _triggerNbrPerCollider[col2.Index]);
+		printf("sortie: nb = %i\n", _triggerNbrPerCollider[col2.Index()]);
 	}
 	////fix de clochard
-	//_triggerNbrPerCollider[col1.Index] = 0;
-	//_triggerNbrPerCollider[col2.Index] = 0;
+	//_triggerNbrPerCollider[col1.Index()] = 0;
+	//_triggerNbrPerCollider[col2.Index()] = 0;
 }
 
 void TriggerSample::SampleSetUp() noexcept
@@ -57,19 +57,18 @@ void TriggerSample::SampleSetUp() noexcept
 		_bodyRefs.push_back(sphereBodyRef);
 		auto& sphereBody = _world.GetBody(sphereBodyRef);
 
-		sphereBody.Velocity = XMVectorScale(XMVectorSet(Random::Range(-1.f, 1.f), Random::Range(-1.f, 1.f), Random::Range(-1.f, 1.f), 0), SPEED);
+		sphereBody.SetVelocity(XMVectorScale(XMVectorSet(Random::Range(-1.f, 1.f), Random::Range(-1.f, 1.f), Random::Range(-1.f, 1.f), 0), SPEED));
 
-		sphereBody.Position = { Random::Range(-100.f, 100.f),Random::Range(-100.f, 100.f), Random::Range(-100.f, 100.f) };
+		sphereBody.SetPosition({ Random::Range(-100.f, 100.f),Random::Range(-100.f, 100.f), Random::Range(-100.f, 100.f) });
 
 		const auto sphereColRef = _world.CreateCollider(sphereBodyRef);
 		_colRefs.push_back(sphereColRef);
 		auto& sphereCol = _world.GetCollider(sphereColRef);
 		sphereCol.Shape = Sphere(XMVectorZero(), sphere_RADIUS);
-		sphereCol.BodyPosition = sphereBody.Position;
 		sphereCol.IsTrigger = true;
 
 		GraphicsData cgd;
-		cgd.Shape = Sphere(XMVectorZero(), sphere_RADIUS) + sphereBody.Position;
+		cgd.Shape = Sphere(XMVectorZero(), sphere_RADIUS) + sphereBody.GetPosition();
 		AllGraphicsData.push_back(cgd);
 	}
 
@@ -80,19 +79,18 @@ void TriggerSample::SampleSetUp() noexcept
 		_bodyRefs.push_back(rectBodyRef);
 		auto& rectBody = _world.GetBody(rectBodyRef);
 
-		rectBody.Velocity = XMVectorScale(XMVectorSet(Random::Range(-1.f, 1.f), Random::Range(-1.f, 1.f), Random::Range(-1.f, 1.f), 0), SPEED);
+		rectBody.SetVelocity(XMVectorScale(XMVectorSet(Random::Range(-1.f, 1.f), Random::Range(-1.f, 1.f), Random::Range(-1.f, 1.f), 0), SPEED));
 
-		rectBody.Position = { Random::Range(-100.f, 100.f),Random::Range(-100.f, 100.f),Random::Range(-100.f, 100.f) };
+		rectBody.SetPosition({ Random::Range(-100.f, 100.f),Random::Range(-100.f, 100.f),Random::Range(-100.f, 100.f) });
 
 		const auto rectColRef = _world.CreateCollider(rectBodyRef);
 		_colRefs.push_back(rectColRef);
 		auto& rectCol = _world.GetCollider(rectColRef);
 		rectCol.Shape = CuboidF(XMVectorZero(), cuboid_BOUNDS);
-		rectCol.BodyPosition = rectBody.Position;
 		rectCol.IsTrigger = true;
 
 		GraphicsData rbd;
-		rbd.Shape = CuboidF(XMVectorZero(), cuboid_BOUNDS) + rectBody.Position;
+		rbd.Shape = CuboidF(XMVectorZero(), cuboid_BOUNDS) + rectBody.GetPosition();
 		AllGraphicsData.push_back(rbd);
 	}
 }
@@ -141,32 +139,32 @@ void TriggerSample::SampleUpdate() noexcept
 	for (std::size_t i = 0; i < _colRefs.size(); ++i)
 	{
 		auto& col = _world.GetCollider(_colRefs[i]);
-		auto bounds = col.GetBounds();
 		auto& body = _world.GetBody(col.BodyRef);
+		auto bounds = col.GetBounds(body.GetPosition());
 
 		if (XMVectorGetX(bounds.MinBound()) <= -100)
 		{
-			body.Velocity = XMVectorSetX(body.Velocity, Abs(XMVectorGetX(body.Velocity)));
+			body.SetVelocity(XMVectorSetX(body.GetVelocity(), Abs(XMVectorGetX(body.GetVelocity()))));
 		}
 		else if (XMVectorGetX(bounds.MaxBound()) >= 100)
 		{
-			body.Velocity = XMVectorSetX(body.Velocity, -Abs(XMVectorGetX(body.Velocity)));
+			body.SetVelocity(XMVectorSetX(body.GetVelocity(), -Abs(XMVectorGetX(body.GetVelocity()))));
 		}
 		if (XMVectorGetY(bounds.MinBound()) <= -100)
 		{
-			body.Velocity = XMVectorSetY(body.Velocity, Abs(XMVectorGetY(body.Velocity)));
+			body.SetVelocity(XMVectorSetY(body.GetVelocity(), Abs(XMVectorGetY(body.GetVelocity()))));
 		}
 		else if (XMVectorGetY(bounds.MaxBound()) >= 100)
 		{
-			body.Velocity = XMVectorSetY(body.Velocity, -Abs(XMVectorGetY(body.Velocity)));
+			body.SetVelocity(XMVectorSetY(body.GetVelocity(), -Abs(XMVectorGetY(body.GetVelocity()))));
 		}
 		if (XMVectorGetZ(bounds.MinBound()) <= -100)
 		{
-			body.Velocity = XMVectorSetZ(body.Velocity, Abs(XMVectorGetZ(body.Velocity)));
+			body.SetVelocity(XMVectorSetZ(body.GetVelocity(), Abs(XMVectorGetZ(body.GetVelocity()))));
 		}
 		else if (XMVectorGetZ(bounds.MaxBound()) >= 100)
 		{
-			body.Velocity = XMVectorSetZ(body.Velocity, -Abs(XMVectorGetZ(body.Velocity)));
+			body.SetVelocity(XMVectorSetZ(body.GetVelocity(), -Abs(XMVectorGetZ(body.GetVelocity()))));
 		}
 
 		auto& shape = _world.GetCollider(_colRefs[i]).Shape;
@@ -174,10 +172,10 @@ void TriggerSample::SampleUpdate() noexcept
 		switch (shape.index())
 		{
 		case static_cast<int>(ShapeType::Sphere):
-			AllGraphicsData[i].Shape = std::get<SphereF>(shape) + body.Position;
+			AllGraphicsData[i].Shape = std::get<SphereF>(shape) + body.GetPosition();
 			break;
 		case static_cast<int>(ShapeType::Cuboid):
-			AllGraphicsData[i].Shape = std::get<CuboidF>(shape) + body.Position;
+			AllGraphicsData[i].Shape = std::get<CuboidF>(shape) + body.GetPosition();
 			break;
 		}
 
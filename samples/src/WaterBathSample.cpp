@@ -30,6 +30,65 @@ void WaterBathSample::DrawImgui() noexcept
 	if (ImGui::SliderFloat("Viscosity strength", &SPH::ViscosityStrength, 0.0f, 10000.0f)) {
 		SPH::ViscosityStrength = SPH::ViscosityStrength;
 	}
+	ImGui::SliderFloat("Neighbor skin", &_world.NeighborSkin, 0.0f, SPH::SmoothingRadius);
+	ImGui::Checkbox("Symmetric pairs", &_world.SymmetricPairs);
+
+	static const char* kernelNames[] = { "Spiky", "Poly6", "Wendland" };
+	int kernel = static_cast<int>(_world.FluidKernel);
+	if (ImGui::Combo("Smoothing kernel", &kernel, kernelNames, IM_ARRAYSIZE(kernelNames))) {
+		_world.FluidKernel = static_cast<SPHSmoothingKernel>(kernel);
+	}
+
+	static const char* integratorNames[] = { "Semi-implicit Euler", "Leapfrog" };
+	int integrator = static_cast<int>(_world.Integrator);
+	if (ImGui::Combo("Integrator", &integrator, integratorNames, IM_ARRAYSIZE(integratorNames))) {
+		_world.Integrator = static_cast<IntegratorScheme>(integrator);
+	}
+
+	const auto& stats = _world.GetStats();
+	ImGui::Text("SPH kernels: %s", _world.GetSPHKernelName());
+	ImGui::Text("Integrator: %s", _world.GetIntegratorName());
+	ImGui::Text("Neighbor rebuilds: %zu", stats.NeighborRebuilds);
+	ImGui::Text("Average neighbors: %.1f", stats.AverageNeighbors);
+	ImGui::Text("Particle reorders: %zu", stats.ParticleReorders);
+
+	static const char* solverNames[] = { "WCSPH", "DFSPH", "PBF" };
+	int solver = static_cast<int>(_world.Solver);
+	if (ImGui::Combo("Pressure solver", &solver, solverNames, IM_ARRAYSIZE(solverNames))) {
+		_world.Solver = static_cast<FluidSolver>(solver);
+	}
+	if (_world.Solver != FluidSolver::WCSPH) {
+		ImGui::SliderFloat("Rest density (0 = measured)", &SPH::RestDensity, 0.0f, 0.2f, "%.4f");
+		ImGui::Text("Rest density: %.4f", _world.GetRestDensity());
+	}
+	if (_world.Solver == FluidSolver::DFSPH) {
+		ImGui::Text("DFSPH iterations: %zu density, %zu divergence", stats.DensityIterations, stats.DivergenceIterations);
+	}
+	if (_world.Solver == FluidSolver::PBF) {
+		auto& pbf = _world.GetPBFSolver();
+		int iterations = static_cast<int>(pbf.Iterations);
+		if (ImGui::SliderInt("PBF iterations", &iterations, 1, 10)) {
+			pbf.Iterations = static_cast<std::size_t>(iterations);
+		}
+		ImGui::SliderFloat("XSPH viscosity", &pbf.XSPHViscosity, 0.0f, 0.1f);
+		ImGui::Text("PBF projections: %zu", stats.ConstraintIterations);
+	}
+
+	ImGui::Checkbox("Implicit viscosity", &_world.ImplicitViscosity);
+	if (_world.ImplicitViscosity) {
+		ImGui::Text("Viscosity iterations: %zu", stats.ViscosityIterations);
+	}
+
+	ImGui::Checkbox("Fluid sleeping", &_world.FluidSleeping);
+	if (_world.FluidSleeping) {
+		ImGui::Text("Sleeping particles: %zu", stats.SleepingParticles);
+	}
+
+	ImGui::Checkbox("Adaptive time step", &_world.AdaptiveTimeStep);
+	ImGui::Checkbox("Block time steps", &_world.BlockTimeSteps);
+	ImGui::Text("Particle steps: %zu", stats.ParticleSteps);
+	ImGui::SliderFloat("Courant factor", &_world.CourantFactor, 0.05f, 1.0f);
+	ImGui::Text("Fluid substeps: %zu (smallest %.5f s)", stats.Substeps, stats.SmallestTimeStep);
 }
 
 void WaterBathSample::OnCollisionEnter(ColliderRef col1,
@@ -61,12 +120,22 @@ void WaterBathSample::SampleSetUp() noexcept {
 	//// Roof
 	//CreateWall({ 0,WALLDIST + WALLSIZE ,0 }, { -WALLDIST, -WALLSIZE, -WALLDIST }, { WALLDIST, WALLSIZE, WALLDIST }, false);
 
-	for (size_t i = 0; i < NbParticles; i++) {
-		CreateBall({ Random::Range(-WALLDIST * 0.8f, WALLDIST * 0.8f),
-					 Random::Range(-WALLDIST * 0.8f, WALLDIST * 0.8f),
-					 Random::Range(-WALLDIST * 0.8f, WALLDIST * 0.8f) }, PARTICLESIZE, BodyType::FLUID);
-	}
+	CreateFluid(NbParticles, PARTICLESIZE);
+
+	// The container is sampled once with boundary particles, the fluid is kept in by its pressure
+	const CuboidF container(XMVectorSet(-WALLDIST, -WALLDIST, -WALLDIST, 0), XMVectorSet(WALLDIST, WALLDIST, WALLDIST, 0));
+	_world.GetBoundaryParticles().SampleCuboid(container, SPH::SmoothingRadius * 0.5f);
+
+	// Every solver feels the boundary particles, the same walls as an exact container catch the particles a violent
+	// splash pushes between two of them
+	_world.GetStaticGeometry().AddCuboid(container, true, true);
+
+	gd.Shape = container;
+	gd.Color = { 160,160,160 };
+	gd.Filled = false;
+	AllGraphicsData.emplace_back(gd);
 
+	ResolveColliders();
 }
 void WaterBathSample::SampleUpdate() noexcept {
 	//if (NbParticles + 5 < AllGraphicsData.size()) {
@@ -81,52 +150,35 @@ void WaterBathSample::SampleUpdate() noexcept {
 		CreateRect(_mousePos);
 	}*/
 
-	for (std::size_t i = 0; i < _colRefs.size(); ++i) {
-		const auto& col = _world.GetCollider(_colRefs[i]);
-
-		const auto& shape = _world.GetCollider(_colRefs[i]).Shape;
-
-		auto& body = _world.GetBody(col.BodyRef);
-
-		switch (shape.index()) {
-		case static_cast<int>(ShapeType::Sphere):
-
-		if (XMVectorGetY(col.BodyPosition) <= -WALLDIST * 2)//fix to reduce quadtree size
-		{
-			_world.GetBody(col.BodyRef).Position = XMVectorZero();
-			_world.GetBody(col.BodyRef).Velocity = XMVectorZero();
+	// The particle columns own the fluid state, escaped particles are reset there
+	auto& fluids = _world.GetFluidParticles();
+	for (std::size_t i = 0; i < _fluidBodies.size(); ++i) {
+		const std::uint32_t particle = fluids.ParticleOf(_fluidBodies[i]);
+		if (particle == FluidParticleSystem::INVALID_INDEX) {
+			continue;
 		}
 
-		if (XMVectorGetX(col.BodyPosition) <= -WALLDIST)
-		{
-			body.Velocity = XMVectorSetX(body.Velocity, Abs(XMVectorGetX(body.Velocity)));
-		}
-		else if (XMVectorGetX(col.BodyPosition) >= WALLDIST)
-		{
-			body.Velocity = XMVectorSetX(body.Velocity, -Abs(XMVectorGetX(body.Velocity)));
-		}
-		if (XMVectorGetY(col.BodyPosition) <= -WALLDIST)
-		{
-			body.Position = XMVectorSetY(body.Position, -WALLDIST);
-			body.Velocity = XMVectorSetY(body.Velocity, Abs(XMVectorGetY(body.Velocity)));
-		}
-		else if (XMVectorGetY(col.BodyPosition) >= WALLDIST)
+		// The boundary particles keep the fluid in, a particle escaping through a gap is put back in the middle
+		if (fluids.PositionY[particle] <= -WALLDIST * 2)
 		{
-			body.Velocity = XMVectorSetY(body.Velocity, -Abs(XMVectorGetY(body.Velocity)));
+			fluids.PositionX[particle] = fluids.PositionY[particle] = fluids.PositionZ[particle] = 0.f;
+			fluids.VelocityX[particle] = fluids.VelocityY[particle] = fluids.VelocityZ[particle] = 0.f;
 		}
-		if (XMVectorGetZ(col.BodyPosition) <= -WALLDIST)
-		{
-			body.Velocity = XMVectorSetZ(body.Velocity, Abs(XMVectorGetZ(body.Velocity)));
-		}
-		else if (XMVectorGetZ(col.BodyPosition) >= WALLDIST)
-		{
-			body.Velocity = XMVectorSetZ(body.Velocity, -Abs(XMVectorGetZ(body.Velocity)));
-		}
-		AllGraphicsData[i].Shape = std::get<SphereF>(shape) + col.BodyPosition;
+	}
+
+	// The references were checked when the colliders were created, the loop reads the colliders unchecked
+	ResolveColliders();
+	for (std::size_t i = 0; i < _colIndices.size(); ++i) {
+		const auto& col = _world.ColliderAt(_colIndices[i]);
+		const auto& shape = col.Shape;
+		const XMVECTOR position = _world.BodyAt(col.BodyRef.Index()).GetPosition();
 
+		switch (shape.index()) {
+		case static_cast<int>(ShapeType::Sphere):
+		AllGraphicsData[_colGraphics[i]].Shape = std::get<SphereF>(shape) + position;
 		break;
 		case static_cast<int>(ShapeType::Cuboid):
-		AllGraphicsData[i].Shape = std::get<CuboidF>(shape) + col.BodyPosition;
+		AllGraphicsData[_colGraphics[i]].Shape = std::get<CuboidF>(shape) + position;
 		break;
 		default:
 		break;
@@ -139,22 +191,41 @@ void WaterBathSample::SampleUpdate() noexcept {
 	//					   _quadTreeGraphicsData.end());
 }
 
-void WaterBathSample::SampleTearDown() noexcept {}
+void WaterBathSample::SampleTearDown() noexcept {
+	_colIndices.clear();
+	_colGraphics.clear();
+	_fluidBodies.clear();
+}
+
+void WaterBathSample::ResolveColliders() noexcept {
+	// The sample only adds colliders, so a size change is the only way the indices can go stale
+	if (_colIndices.size() == _colRefs.size()) {
+		return;
+	}
+
+	try {
+		_colIndices = _world.ResolveColliders(_colRefs);
+	}
+	catch (const std::runtime_error&) {
+		// A reference of the sample was destroyed behind its back, draw nothing rather than read a dead slot
+		_colIndices.clear();
+	}
+}
 
 void WaterBathSample::CreateBall(XMVECTOR position, float radius, BodyType type) noexcept {
 	const auto sphereBodyRef = _world.CreateBody(type);
 	_bodyRefs.push_back(sphereBodyRef);
 	auto& sphereBody = _world.GetBody(sphereBodyRef);
 
-	sphereBody.Mass = 1.f;//(type == BodyType::FLUID) ? 1 : 10;
+	sphereBody.SetMass(1.f);//(type == BodyType::FLUID) ? 1 : 10;
 
-	sphereBody.Position = position;
+	sphereBody.SetPosition(position);
 
 	const auto sphereColRef = _world.CreateCollider(sphereBodyRef);
 	_colRefs.push_back(sphereColRef);
+	_colGraphics.push_back(AllGraphicsData.size());
 	auto& sphereCol = _world.GetCollider(sphereColRef);
 	sphereCol.Shape = Sphere(XMVectorZero(), radius);
-	sphereCol.BodyPosition = sphereBody.Position;
 	sphereCol.Restitution = 0.f;
 	sphereCol.IsTrigger = false;
 
@@ -165,21 +236,50 @@ void WaterBathSample::CreateBall(XMVECTOR position, float radius, BodyType type)
 	AllGraphicsData.emplace_back(gd);
 }
 
+void WaterBathSample::CreateFluid(std::size_t count, float radius) noexcept {
+	// The bodies and colliders are created in bulk, the world storage grows once. The colliders let the particles
+	// collide with the rigid bodies, the SPH update handles the fluid with itself
+	const auto bodyRefs = _world.CreateBodies(count, BodyType::FLUID);
+	const auto colRefs = _world.CreateColliders(bodyRefs);
+	_bodyRefs.insert(_bodyRefs.end(), bodyRefs.begin(), bodyRefs.end());
+	_colRefs.insert(_colRefs.end(), colRefs.begin(), colRefs.end());
+	_fluidBodies = _world.ResolveBodies(bodyRefs);
+
+	GraphicsData gd;
+	gd.Color = Color{ 170, 213, 219 };
+
+	for (std::size_t i = 0; i < count; i++) {
+		auto& body = _world.GetBody(bodyRefs[i]);
+		body.SetMass(1.f);
+		body.SetPosition({ Random::Range(-WALLDIST * 0.8f, WALLDIST * 0.8f),
+						  Random::Range(-WALLDIST * 0.8f, WALLDIST * 0.8f),
+						  Random::Range(-WALLDIST * 0.8f, WALLDIST * 0.8f) });
+
+		auto& col = _world.GetCollider(colRefs[i]);
+		col.Shape = Sphere(XMVectorZero(), radius);
+		col.Restitution = 0.f;
+		col.IsTrigger = false;
+
+		_colGraphics.push_back(AllGraphicsData.size());
+		gd.Shape = SphereF(body.GetPosition(), radius);
+		AllGraphicsData.emplace_back(gd);
+	}
+}
+
 void WaterBathSample::CreateWall(XMVECTOR position, XMVECTOR minBound, XMVECTOR maxBound, bool isFilled) noexcept
 {
-	const auto wallRef = _world.CreateBody();
+	const auto wallRef = _world.CreateBody(BodyType::STATIC);
 	_bodyRefs.push_back(wallRef);
 	auto& wallBody = _world.GetBody(wallRef);
-	wallBody.Type = BodyType::STATIC;
-	wallBody.Mass = 1;
+	wallBody.SetMass(1);
 
-	wallBody.Position = position;
+	wallBody.SetPosition(position);
 
 	const auto wallColRef = _world.CreateCollider(wallRef);
 	_colRefs.push_back(wallColRef);
+	_colGraphics.push_back(AllGraphicsData.size());
 	auto& wallCol = _world.GetCollider(wallColRef);
 	wallCol.Shape = CuboidF(minBound, maxBound);
-	wallCol.BodyPosition = position;
 	wallCol.Restitution = 0.f;
 
 	GraphicsData gd;